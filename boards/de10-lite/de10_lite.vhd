@@ -114,10 +114,20 @@ begin
               OCD_CSR_CHECK_DISABLE => false,
               -- Do we use post-increment address pointer when debugging?
               OCD_AAMPOSTINCREMENT => TRUE,
+              -- Do we have System Bus Access in the debugger?
+              OCD_SYSBUS => false,
+              -- Do we have the PC sample register in the debugger?
+              OCD_PCSAMPLE => false,
+              -- Number of hardware triggers in the debugger (1 to 4)
+              OCD_TRIGGERS => 4,
               -- Do we have integer hardware multiply/divide?
               HAVE_MULDIV => TRUE,
               -- Do we have the fast divider?
               FAST_DIVIDE => false,
+              -- Do we have the single-cycle multiplier?
+              SINGLE_CYCLE_MULTIPLY => false,
+              -- Do we have the early-terminating divider?
+              EARLY_DIVIDE => false,
               -- Do we have the Zba extension?
               HAVE_ZBA => false,
               -- Do we have Zbb (bit instructions)?
@@ -130,12 +140,24 @@ begin
               HAVE_ZIMOP => false,
               -- Have Zbkb (bitmanip instructions for cryptography)
               HAVE_ZBKB => false,
+              -- Do we have Zca (compressed instructions)?
+              HAVE_ZCA => false,
+              -- Do we have Zcb (extra compressed instructions)?
+              HAVE_ZCB => false,
+              -- Do we have Zcmp (push/pop instructions)?
+              HAVE_ZCMP => false,
               -- Do we have HPM counters?
               HAVE_ZIHPM => false,
               -- Do we have vectored MTVEC (for interrupts)?
               VECTORED_MTVEC => TRUE,
               -- Do we have registers in onboard RAM?
               HAVE_REGISTERS_IN_RAM => TRUE,
+              -- Do we have static branch prediction?
+              HAVE_BRANCH_PREDICTION => TRUE,
+              -- Do we have the Branch Target Buffer?
+              HAVE_BTB => false,
+              -- Do we have the instruction prefetch queue?
+              HAVE_PREFETCH => false,
               -- Number of address bits for ROM
               ROM_ADDRESS_BITS => 16,
               -- Number of address bits for RAM
@@ -152,6 +174,12 @@ begin
               BUFFER_IO_RESPONSE => false,
               -- Fast memory access (severly reduces Fmax)?
               FAST_MEM => false,
+              -- Single-cycle loads (needs FAST_MEM)?
+              FAST_LOAD => false,
+              -- Use the store buffer?
+              HAVE_STORE_BUFFER => false,
+              -- Post I/O stores in the store buffer?
+              POST_IO_STORES => false,
               -- Use UART1?
               HAVE_UART1 => TRUE,
               -- Use UART2?
@@ -174,6 +202,14 @@ begin
               HAVE_WDT => TRUE,
               -- Use CRC?
               HAVE_CRC => TRUE,
+              -- Use DMA?
+              HAVE_DMA => false,
+              -- Use CLIC interrupt controller?
+              HAVE_CLIC => false,
+              -- Do we have a shadow register bank for interrupts?
+              HAVE_SHADOW_REGS => false,
+              -- Use trace buffer?
+              HAVE_TRACE => false,
               -- UART1 BREAK triggers system reset
               UART1_BREAK_RESETS => false
              )
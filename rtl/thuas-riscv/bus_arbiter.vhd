@@ -0,0 +1,188 @@
+-- #################################################################################################
+-- # bus_arbiter.vhd -- Data bus arbiter between core, DMA and DM                                  #
+-- # ********************************************************************************************* #
+-- # This file is part of the THUAS RISCV RV32 Project                                             #
+-- # ********************************************************************************************* #
+-- # BSD 3-Clause License                                                                          #
+-- #                                                                                               #
+-- # Copyright (c) 2026, Jesse op den Brouw. All rights reserved.                                  #
+-- #                                                                                               #
+-- # Redistribution and use in source and binary forms, with or without modification, are          #
+-- # permitted provided that the following conditions are met:                                     #
+-- #                                                                                               #
+-- # 1. Redistributions of source code must retain the above copyright notice, this list of        #
+-- #    conditions and the following disclaimer.                                                   #
+-- #                                                                                               #
+-- # 2. Redistributions in binary form must reproduce the above copyright notice, this list of     #
+-- #    conditions and the following disclaimer in the documentation and/or other materials        #
+-- #    provided with the distribution.                                                            #
+-- #                                                                                               #
+-- # 3. Neither the name of the copyright holder nor the names of its contributors may be used to  #
+-- #    endorse or promote products derived from this software without specific prior written      #
+-- #    permission.                                                                                #
+-- #                                                                                               #
+-- # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS   #
+-- # OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF               #
+-- # MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE    #
+-- # COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,     #
+-- # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE #
+-- # GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED    #
+-- # AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING     #
+-- # NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED  #
+-- # OF THE POSSIBILITY OF SUCH DAMAGE.                                                            #
+-- # ********************************************************************************************* #
+-- # https:/github.com/jesseopdenbrouw/thuas-riscv                                                 #
+-- #################################################################################################
+
+-- This file contains the data bus arbiter. It is placed between the
+-- core and the address decoder when the DMA controller or the System
+-- Bus Access of the Debug Module (DM) is present.
+-- The core owns the bus by default. When the DMA requests the bus
+-- (hold), the arbiter waits for the end of the current core transfer
+-- (the core strobes a transfer once and waits for the ready),
+-- then waits two idle clock cycles before the DMA gets the bus. The
+-- DMA keeps the bus until it drops hold. The DM is handled the same
+-- way as the DMA, the DMA has priority over the DM. The master that
+-- does not own the bus sees no strobe, no ready and no errors. A core
+-- transfer that is strobed while the core does not own the bus is
+-- latched and strobed to the address decoder as soon as the core
+-- owns the bus again, so the core simply stalls.
+
+library ieee;
+use ieee.std_logic_1164.all;
+
+library work;
+use work.processor_common.all;
+
+entity bus_arbiter is
+    port (I_clk : in std_logic;
+          I_areset : in std_logic;
+          I_sreset : in std_logic;
+          -- From and to core
+          I_bus_request_core : in bus_request_type;
+          O_bus_response_core : out bus_response_type;
+          -- From and to DMA
+          I_bus_request_dma : in bus_request_type;
+          O_bus_response_dma : out bus_response_type;
+          I_bus_hold_dma : in std_logic;
+          O_bus_grant_dma : out std_logic;
+          -- From and to DM
+          I_bus_request_dm : in bus_request_type;
+          O_bus_response_dm : out bus_response_type;
+          I_bus_hold_dm : in std_logic;
+          O_bus_grant_dm : out std_logic;
+          -- To and from address decoder
+          O_bus_request : out bus_request_type;
+          I_bus_response : in bus_response_type
+         );
+end entity bus_arbiter;
+
+architecture rtl of bus_arbiter is
+
+type owner_type is (owner_core, owner_drain1, owner_drain2, owner_dma, owner_dm);
+signal owner : owner_type;
+-- Core transfer strobed but not ready
+signal core_busy : std_logic;
+-- Core transfer strobed while not owning the bus
+signal core_pending : std_logic;
+signal core_latched : bus_request_type;
+signal core_request : bus_request_type;
+
+constant bus_request_none_c : bus_request_type := (
+    stb => '0',
+    acc => memaccess_nop,
+    size => memsize_unknown,
+    addr => (others => '0'),
+    data => (others => '0')
+   );
+constant bus_response_none_c : bus_response_type := (
+    data => (others => '0'),
+    ready => '0',
+    load_access_error => '0',
+    store_access_error => '0',
+    load_misaligned_error => '0',
+    store_misaligned_error => '0'
+   );
+
+begin
+
+    -- Determine the owner of the bus
+    process (I_clk, I_areset) is
+    begin
+        if I_areset = '1' then
+            owner <= owner_core;
+            core_busy <= '0';
+            core_pending <= '0';
+            core_latched <= bus_request_none_c;
+        elsif rising_edge(I_clk) then
+            if I_sreset = '1' then
+                owner <= owner_core;
+                core_busy <= '0';
+                core_pending <= '0';
+                core_latched <= bus_request_none_c;
+            else
+                if owner = owner_core then
+                    -- Latched transfer is strobed in this cycle
+                    core_pending <= '0';
+                    -- Track the core transfer
+                    if I_bus_response.ready = '1' then
+                        core_busy <= '0';
+                    elsif core_request.stb = '1' and core_request.acc /= memaccess_nop then
+                        core_busy <= '1';
+                    end if;
+                elsif I_bus_request_core.stb = '1' and I_bus_request_core.acc /= memaccess_nop then
+                    -- Keep the strobed core transfer until the core owns the bus
+                    core_pending <= '1';
+                    core_latched <= I_bus_request_core;
+                end if;
+                case owner is
+                    -- Hand over to the DMA or DM if no core transfer is pending
+                    when owner_core =>
+                        if (I_bus_hold_dma = '1' or I_bus_hold_dm = '1') and core_pending = '0' and
+                           (I_bus_request_core.stb = '0' or I_bus_request_core.acc = memaccess_nop) and
+                           (core_busy = '0' or I_bus_response.ready = '1') then
+                            owner <= owner_drain1;
+                        end if;
+                    -- Two idle cycles before the DMA or DM gets the bus
+                    when owner_drain1 =>
+                        owner <= owner_drain2;
+                    when owner_drain2 =>
+                        if I_bus_hold_dma = '1' then
+                            owner <= owner_dma;
+                        elsif I_bus_hold_dm = '1' then
+                            owner <= owner_dm;
+                        else
+                            owner <= owner_core;
+                        end if;
+                    -- DMA transfers an element
+                    when owner_dma =>
+                        if I_bus_hold_dma = '0' then
+                            owner <= owner_core;
+                        end if;
+                    -- DM transfers a single item
+                    when owner_dm =>
+                        if I_bus_hold_dm = '0' then
+                            owner <= owner_core;
+                        end if;
+                    when others =>
+                        owner <= owner_core;
+                end case;
+            end if;
+        end if;
+    end process;
+
+    -- The latched core transfer is strobed first
+    core_request <= core_latched when core_pending = '1' else I_bus_request_core;
+
+    -- Route the request and the response
+    O_bus_request <= core_request when owner = owner_core else
+                     I_bus_request_dma when owner = owner_dma else
+                     I_bus_request_dm when owner = owner_dm else
+                     bus_request_none_c;
+    O_bus_response_core <= I_bus_response when owner = owner_core else bus_response_none_c;
+    O_bus_response_dma <= I_bus_response when owner = owner_dma else bus_response_none_c;
+    O_bus_grant_dma <= '1' when owner = owner_dma else '0';
+    O_bus_response_dm <= I_bus_response when owner = owner_dm else bus_response_none_c;
+    O_bus_grant_dm <= '1' when owner = owner_dm else '0';
+
+end architecture rtl;
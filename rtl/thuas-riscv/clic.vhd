@@ -0,0 +1,224 @@
+-- #################################################################################################
+-- # clic.vhd - Core-local interrupt controller                                                    #
+-- # ********************************************************************************************* #
+-- # This file is part of the THUAS RISCV RV32 Project                                             #
+-- # ********************************************************************************************* #
+-- # BSD 3-Clause License                                                                          #
+-- #                                                                                               #
+-- # Copyright (c) 2026, Jesse op den Brouw. All rights reserved.                                  #
+-- #                                                                                               #
+-- # Redistribution and use in source and binary forms, with or without modification, are          #
+-- # permitted provided that the following conditions are met:                                     #
+-- #                                                                                               #
+-- # 1. Redistributions of source code must retain the above copyright notice, this list of        #
+-- #    conditions and the following disclaimer.                                                   #
+-- #                                                                                               #
+-- # 2. Redistributions in binary form must reproduce the above copyright notice, this list of     #
+-- #    conditions and the following disclaimer in the documentation and/or other materials        #
+-- #    provided with the distribution.                                                            #
+-- #                                                                                               #
+-- # 3. Neither the name of the copyright holder nor the names of its contributors may be used to  #
+-- #    endorse or promote products derived from this software without specific prior written      #
+-- #    permission.                                                                                #
+-- #                                                                                               #
+-- # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS   #
+-- # OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF               #
+-- # MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE    #
+-- # COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,     #
+-- # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE #
+-- # GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED    #
+-- # AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING     #
+-- # NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED  #
+-- # OF THE POSSIBILITY OF SUCH DAMAGE.                                                            #
+-- # ********************************************************************************************* #
+-- # https:/github.com/jesseopdenbrouw/thuas-riscv                                                 #
+-- #################################################################################################
+
+-- CLIC-style core-local interrupt controller
+--
+-- Each interrupt line of the I/O (0 to 30, the NMI at 31 is not
+-- handled) has an enable bit, a 4-bit priority level and a selective
+-- hardware vectoring (SHV) bit. The controller selects the enabled,
+-- pending interrupt with the highest level, on equal levels the
+-- highest ID wins. The selection is registered and presented to
+-- the core together with the handler address from the vector table.
+-- The core compares the level with the current interrupt level and
+-- the threshold (CSRs mintstatus and mintthresh) to decide on
+-- preemption. The 4-bit level is extended to 8 bits by filling the
+-- lower bits with ones, as the CLIC specification prescribes.
+--
+-- Register map (offsets from base):
+-- 0x000 + 4*n - INTCTL of interrupt n
+--             bit 0 IP, interrupt pending (read only)
+--             bit 1 IE, interrupt enable
+--             bit 2 SHV, jump directly to VECTOR n
+--             bits 7:4 LEVEL, priority level, higher is more urgent
+-- 0x080 + 4*n - VECTOR of interrupt n, handler address
+
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.numeric_std.all;
+
+library work;
+use work.processor_common.all;
+
+entity clic is
+    port (I_clk : in std_logic;
+          I_areset : in std_logic;
+          I_sreset : in std_logic;
+          -- 
+          I_mem_request : in mem_request_type;
+          O_mem_response : out mem_response_type;
+          -- Interrupt lines from the I/O
+          I_intrio : in data_type;
+          -- Selected interrupt to the core
+          O_clic : out clic_request_type
+         );
+end entity clic;
+
+architecture rtl of clic is
+
+-- Number of interrupt lines handled, the NMI is not
+constant CLIC_SOURCES : integer := 31;
+
+type intctl_type is record
+    ie : std_logic;
+    shv : std_logic;
+    level : std_logic_vector(3 downto 0);
+end record;
+type intctl_array_type is array (0 to CLIC_SOURCES-1) of intctl_type;
+signal intctl : intctl_array_type;
+
+-- The vector table has no reset, so it may be mapped onto RAM blocks
+type vector_array_type is array (0 to CLIC_SOURCES-1) of data_type;
+signal vector : vector_array_type;
+
+type select_type is record
+    valid : std_logic;
+    id : integer range 0 to CLIC_SOURCES-1;
+end record;
+-- Selected interrupt and the selection of the previous clock cycle
+signal sel, sel_prev : select_type;
+-- Handler address of the previous selection
+signal vector_sel : data_type;
+
+signal isword : boolean;
+signal idx : integer range 0 to 31;
+
+begin
+
+    -- Check for misaligned access
+    O_mem_response.load_misaligned_error <= '1' when I_mem_request.stb = '1' and I_mem_request.wren = '0' and I_mem_request.size = memsize_word and I_mem_request.addr(1 downto 0) /= "00" else '0';
+    O_mem_response.store_misaligned_error <= '1' when I_mem_request.stb = '1' and I_mem_request.wren = '1' and I_mem_request.size = memsize_word and I_mem_request.addr(1 downto 0) /= "00" else '0';
+    -- Check for unsuppored data size
+    O_mem_response.load_access_error <= '1' when I_mem_request.stb = '1' and I_mem_request.wren = '0' and I_mem_request.size /= memsize_word else '0';
+    O_mem_response.store_access_error <= '1' when I_mem_request.stb = '1' and I_mem_request.wren = '1' and I_mem_request.size /= memsize_word  else '0';
+    
+    -- Correct size and address boundary
+    isword <= I_mem_request.size = memsize_word and I_mem_request.addr(1 downto 0) = "00";
+
+    -- Register index
+    idx <= to_integer(unsigned(I_mem_request.addr(6 downto 2)));
+
+    -- Registers
+    process (I_clk, I_areset) is
+    begin
+        if I_areset = '1' then
+            for i in 0 to CLIC_SOURCES-1 loop
+                intctl(i).ie <= '0';
+                intctl(i).shv <= '0';
+                intctl(i).level <= (others => '0');
+            end loop;
+            --
+            O_mem_response.data <= all_zeros_c;
+            O_mem_response.ready <= '0';
+        elsif rising_edge(I_clk) then
+            O_mem_response.data <= all_zeros_c;
+            O_mem_response.ready <= '0';
+            if I_sreset = '1' then
+                for i in 0 to CLIC_SOURCES-1 loop
+                    intctl(i).ie <= '0';
+                    intctl(i).shv <= '0';
+                    intctl(i).level <= (others => '0');
+                end loop;
+            else
+                if I_mem_request.stb = '1' and isword then
+                    if I_mem_request.wren = '1' then
+                        if idx < CLIC_SOURCES then
+                            if I_mem_request.addr(7) = '0' then
+                                intctl(idx).ie <= I_mem_request.data(1);
+                                intctl(idx).shv <= I_mem_request.data(2);
+                                intctl(idx).level <= I_mem_request.data(7 downto 4);
+                            else
+                                vector(idx) <= I_mem_request.data;
+                            end if;
+                        end if;
+                    else
+                        if idx < CLIC_SOURCES then
+                            if I_mem_request.addr(7) = '0' then
+                                O_mem_response.data(0) <= I_intrio(idx);
+                                O_mem_response.data(1) <= intctl(idx).ie;
+                                O_mem_response.data(2) <= intctl(idx).shv;
+                                O_mem_response.data(7 downto 4) <= intctl(idx).level;
+                            else
+                                O_mem_response.data <= vector(idx);
+                            end if;
+                        end if;
+                    end if;
+                    O_mem_response.ready <= '1';
+                end if;
+            end if; -- sreset
+        end if;
+    end process;
+
+    -- Select the enabled and pending interrupt with the highest level.
+    -- The selection is registered, the handler address is read one
+    -- clock cycle later.
+    process (I_clk, I_areset) is
+    variable found_v : boolean;
+    variable id_v : integer range 0 to CLIC_SOURCES-1;
+    variable level_v : unsigned(3 downto 0);
+    begin
+        if I_areset = '1' then
+            sel.valid <= '0';
+            sel.id <= 0;
+            sel_prev.valid <= '0';
+            sel_prev.id <= 0;
+            vector_sel <= (others => '0');
+        elsif rising_edge(I_clk) then
+            found_v := false;
+            id_v := 0;
+            level_v := (others => '0');
+            for i in 0 to CLIC_SOURCES-1 loop
+                if I_intrio(i) = '1' and intctl(i).ie = '1' and
+                   (not found_v or unsigned(intctl(i).level) >= level_v) then
+                    found_v := true;
+                    id_v := i;
+                    level_v := unsigned(intctl(i).level);
+                end if;
+            end loop;
+            if I_sreset = '1' then
+                sel.valid <= '0';
+                sel.id <= 0;
+            else
+                sel.valid <= boolean_to_std_logic(found_v);
+                sel.id <= id_v;
+            end if;
+            sel_prev <= sel;
+            vector_sel <= vector(sel.id);
+        end if;
+    end process;
+
+    -- The selection is presented to the core when it is stable for
+    -- two clock cycles, so that the handler address belongs to it.
+    -- The interrupt line and enable are checked again, an interrupt
+    -- cleared by its handler is not taken again at MRET.
+    O_clic.valid <= '1' when sel.valid = '1' and sel_prev.valid = '1' and sel.id = sel_prev.id and
+                             I_intrio(sel.id) = '1' and intctl(sel.id).ie = '1'
+                        else '0';
+    O_clic.id <= std_logic_vector(to_unsigned(sel.id, O_clic.id'length));
+    O_clic.level <= intctl(sel.id).level & "1111";
+    O_clic.shv <= intctl(sel.id).shv;
+    O_clic.vector <= vector_sel;
+
+end architecture rtl;
@@ -62,12 +62,18 @@ entity core is
           HAVE_BOOTLOADER_ROM : boolean;
           -- Disable CSR address check when in debug mode
           OCD_CSR_CHECK_DISABLE : boolean;
+          -- Number of hardware triggers
+          OCD_TRIGGERS : integer;
           -- RISCV E (embedded) or RISCV I (full)
           HAVE_RISCV_E : boolean;
           -- Do we have the integer multiply/divide unit?
           HAVE_MULDIV : boolean;
           -- Fast divide (needs more area)?
           FAST_DIVIDE : boolean;
+          -- Single-cycle multiply in execute stage?
+          SINGLE_CYCLE_MULTIPLY : boolean;
+          -- Early-terminating divider?
+          EARLY_DIVIDE : boolean;
           -- Do we have Zba (sh?add)
           HAVE_ZBA : boolean;
           -- Do we have Zbb (bit instructions)?
@@ -80,20 +86,38 @@ entity core is
           HAVE_ZIMOP : boolean;
           -- Have Zbkb (bitmanip instructions for cryptography)
           HAVE_ZBKB : boolean;
+          -- Do we have Zca (compressed instructions)?
+          HAVE_ZCA : boolean;
+          -- Do we have Zcb (extra compressed instructions)?
+          HAVE_ZCB : boolean;
+          -- Do we have Zcmp (compressed push/pop)?
+          HAVE_ZCMP : boolean;
           -- Do we have HPM counters?
           HAVE_ZIHPM : boolean;
           -- Do we enable vectored mode for mtvec?
           VECTORED_MTVEC : boolean;
           -- Do we have registers is RAM?
           HAVE_REGISTERS_IN_RAM : boolean;
+          -- Do we have branch prediction?
+          HAVE_BRANCH_PREDICTION : boolean;
+          -- Do we have a branch target buffer?
+          HAVE_BTB : boolean;
+          -- Do we have an instruction prefetch queue?
+          HAVE_PREFETCH : boolean;
           -- 4 high bits of ROM address
           ROM_HIGH_NIBBLE : memory_high_nibble;
           -- 4 high bits of boot ROM address
           BOOT_HIGH_NIBBLE : memory_high_nibble;
+          -- 4 high bits of RAM address
+          RAM_HIGH_NIBBLE : memory_high_nibble;
           -- Buffer I/O response
           BUFFER_IO_RESPONSE : boolean;
           -- Fast memory access (severly reduces Fmax)?
           FAST_MEM : boolean;
+          -- Single-cycle loads from ROM/RAM (needs FAST_MEM)?
+          FAST_LOAD : boolean;
+          -- Use posted store buffer?
+          HAVE_STORE_BUFFER : boolean;
           -- Do we have UART1?
           HAVE_UART1 : boolean;
           -- Do we have UART2?
@@ -116,6 +140,14 @@ entity core is
           HAVE_WDT : boolean;
           -- Use CRC?
           HAVE_CRC : boolean;
+          -- Use DMA?
+          HAVE_DMA : boolean;
+          -- Use CLIC-style interrupt controller?
+          HAVE_CLIC : boolean;
+          -- Use a shadow register bank for interrupts?
+          HAVE_SHADOW_REGS : boolean;
+          -- Use the instruction trace buffer?
+          HAVE_TRACE : boolean;
           -- UART1 BREAK triggers system reset
           UART1_BREAK_RESETS : boolean
          );
@@ -128,11 +160,17 @@ entity core is
           -- To and from memory
           O_bus_request : out bus_request_type;
           I_bus_response : in bus_response_type;
+          -- All posted stores are written
+          I_store_buffer_empty : in std_logic;
           -- Interrupt signals from I/O
           I_intrio : data_type;
+          -- Interrupt selected by the CLIC
+          I_clic : in clic_request_type;
           -- [m]time from the memory mapped I/O
           I_mtime : in data_type;
           I_mtimeh : in data_type;
+          -- Instruction trace events
+          O_trace : out trace_type;
           -- Debug signals
           I_dm_core_data_request : in dm_core_data_request_type;
           O_dm_core_data_response : out dm_core_data_response_type;
@@ -141,7 +179,9 @@ entity core is
           I_ackhavereset : in std_logic;
           O_halt_ack : out std_logic;
           O_reset_ack : out std_logic;
-          O_resume_ack : out std_logic
+          O_resume_ack : out std_logic;
+          -- PC of the last retired instruction
+          O_pcsample : out data_type
          );
 end entity core;
 
@@ -149,6 +189,8 @@ architecture rtl of core is
 
 -- Number of registers: 16 for E, 32 for I
 constant NUMBER_OF_REGISTERS : integer := get_int_from_boolean(HAVE_RISCV_E, 16, 32);
+-- Number of register banks: the shadow bank is only available in RAM
+constant NUMBER_OF_BANKS : integer := get_int_from_boolean(HAVE_SHADOW_REGS and HAVE_REGISTERS_IN_RAM, 2, 1);
 
 -- Do we want the extra simulation output file?
 constant SIMULATION_EXTRA : boolean := false;
@@ -161,6 +203,14 @@ signal pc : data_type := boolean_to_std_logic_vector(HAVE_BOOTLOADER_ROM, BOOT_H
 -- IF/ID signals for Instruction Decode stage
 type if_id_type is record
     pc : data_type;
+    -- Fetched instruction is valid, not fetched after a redirect
+    valid : std_logic;
+    -- Instruction access error at fetch
+    error : std_logic;
+    -- BTB hit at fetch, PC loaded with BTB target
+    hit : std_logic;
+    predict : std_logic;
+    target : data_type;
     selrs1 : integer range 0 to NUMBER_OF_REGISTERS-1;
     selrs2 : integer range 0 to NUMBER_OF_REGISTERS-1;
 end record if_id_type;
@@ -185,10 +235,21 @@ type id_ex_type is record
     ismem : std_logic;
     md_op : func3_type;
     md_start : std_logic;
+    -- FENCE/FENCE.I waits for the posted stores
+    fence : std_logic;
     memaccess : memaccess_type;
     memsize : memsize_type;
     pc_op : pc_op_type;
     pc : data_type;
+    -- Compressed instruction, next instruction at PC+2
+    compressed : std_logic;
+    -- Zcmp micro-operation, not the first / not the last
+    uop_cont : std_logic;
+    uop_more : std_logic;
+    -- Jump/branch is predicted taken
+    predict : std_logic;
+    -- Instruction is squashed after a predicted jump/branch
+    bubble : std_logic;
     csr_op : csr_op_type;
     csr_addr : std_logic_vector(11 downto 0);
     csr_immrs1 : std_logic_vector(4 downto 0);
@@ -206,8 +267,41 @@ type ex_wb_type is record
 end record ex_wb_type;
 signal ex_wb : ex_wb_type;
 
--- The registers
-type regs_array_type is array (0 to NUMBER_OF_REGISTERS-1) of data_type;
+-- Forwarded data for RS1/RS2, latest result or fast load data
+type forward_type is record
+    rs1data : data_type;
+    rs2data : data_type;
+end record forward_type;
+signal forward : forward_type;
+
+-- Fast load from ROM, boot ROM or RAM
+type ld_type is record
+    -- Load is outstanding
+    busy : std_logic;
+    en : std_logic;
+    kill : std_logic;
+    rd : reg_type;
+    alu_op : alu_op_type;
+    addr : data_type;
+    size : memsize_type;
+    -- Load data arrives
+    capture : std_logic;
+    data : data_type;
+end record ld_type;
+signal ld : ld_type;
+-- Load data not yet written to the registers
+type lwb_type is record
+    valid : std_logic;
+    pending : std_logic;
+    rd : reg_type;
+    bank : std_logic;
+    sel : integer range 0 to NUMBER_OF_BANKS*NUMBER_OF_REGISTERS-1;
+    data : data_type;
+end record lwb_type;
+signal lwb : lwb_type;
+
+-- The registers, the shadow bank is placed above the normal bank
+type regs_array_type is array (0 to NUMBER_OF_BANKS*NUMBER_OF_REGISTERS-1) of data_type;
 -- After reconfiguration, all the registers are loaded with null-bits
 constant reg_contents : regs_array_type := (  (others => (others => '0')) );
 -- Quartus will not generate RAM blocks for registers when they are in a record
@@ -215,6 +309,8 @@ constant reg_contents : regs_array_type := (  (others => (others => '0')) );
 signal regs_rs1 : regs_array_type := reg_contents;
 signal regs_rs2 : regs_array_type := reg_contents;
 signal regs_debug : regs_array_type := reg_contents;
+-- The selected register bank
+signal regbank : integer range 0 to 1;
 -- Used with on-chip debugger
 signal data_from_gpr : data_type;
 
@@ -250,7 +346,7 @@ type control_type is record
     illegal_instruction_decode : std_logic;
     illegal_instruction_csr : std_logic;
     instruction_misaligned : std_logic;
-    instr_access_error : std_logic_vector(1 downto 0);
+    instr_access_error : std_logic;
     instr_misaligned_ff : std_logic;
     -- Instructions concerning traps
     ecall_request : std_logic;
@@ -263,9 +359,104 @@ type control_type is record
     trap_release : std_logic;
     trap_mcause : data_type;
     may_interrupt : std_logic;
+    -- CLIC mode, interrupt taken from the CLIC, tail-chained at MRET
+    clic_mode : std_logic;
+    clic_preempt : std_logic;
+    clic_chain : std_logic;
+    trap_clic : std_logic;
+    trap_chain : std_logic;
+    clic_shv : std_logic;
+    -- Jump/branch correctly predicted
+    predicted : std_logic;
+    -- Instruction fetch advances, execute stage or debugger loads the PC
+    fetch : std_logic;
+    redirect : std_logic;
+    -- Fast load in execute, decode waits for load data, register write
+    fast_load : std_logic;
+    load_hazard : std_logic;
+    regwrite : std_logic;
 end record control_type;
 signal control : control_type;
 
+-- Branch prediction
+-- Number of entries in the BTB is 2**BTB_SIZE_BITS
+constant BTB_SIZE_BITS : integer := 4;
+constant BTB_SIZE : integer := 2**BTB_SIZE_BITS;
+type btb_tag_array_type is array (0 to BTB_SIZE-1) of std_logic_vector(31 downto BTB_SIZE_BITS+2);
+type btb_target_array_type is array (0 to BTB_SIZE-1) of data_type;
+type btb_counter_array_type is array (0 to BTB_SIZE-1) of unsigned(1 downto 0);
+type bp_type is record
+    -- Decode stage
+    taken : std_logic;
+    want : std_logic;
+    want_pc : data_type;
+    redirect : std_logic;
+    invalidate : std_logic;
+    -- Fetch stage
+    hit : std_logic;
+    fetch_taken : std_logic;
+    fetch_target : data_type;
+    fetch_redirect : std_logic;
+    -- Execute stage
+    ex_taken : std_logic;
+    ex_target : data_type;
+    ex_next : data_type;
+    update : std_logic;
+    -- The branch target buffer
+    valid : std_logic_vector(BTB_SIZE-1 downto 0);
+    tag : btb_tag_array_type;
+    target : btb_target_array_type;
+    counter : btb_counter_array_type;
+end record bp_type;
+signal bp : bp_type;
+
+-- Instruction prefetch queue
+constant PREFETCH_DEPTH : integer := 4;
+type fetch_entry_type is record
+    instr : data_type;
+    pc : data_type;
+    predict : std_logic;
+    error : std_logic;
+    valid : std_logic;
+    compressed : std_logic;
+    -- Zcmp micro-operation, not the first / not the last
+    uop_cont : std_logic;
+    uop_more : std_logic;
+end record fetch_entry_type;
+type prefetch_array_type is array (0 to PREFETCH_DEPTH-1) of fetch_entry_type;
+type pq_type is record
+    queue : prefetch_array_type;
+    count : integer range 0 to PREFETCH_DEPTH;
+    push : std_logic;
+    pop : std_logic;
+    clear : std_logic;
+end record pq_type;
+signal pq : pq_type;
+-- The instruction from the fetch stage or the prefetch queue
+signal fetch_out : fetch_entry_type;
+-- The instruction presented to the decode stage
+signal decode_in : fetch_entry_type;
+
+-- Instruction aligner for compressed instructions
+type align_type is record
+    -- Upper half of the previous word
+    buf : std_logic_vector(15 downto 0);
+    pc : data_type;
+    error : std_logic;
+    valid : std_logic;
+    -- The word from the fetch stage or the queue is used
+    take : std_logic;
+    -- A 32-bit instruction waits for its upper half
+    pending : std_logic;
+    -- Zcmp micro-operation step, more micro-operations follow
+    step : integer range 0 to 15;
+    more : std_logic;
+end record align_type;
+signal align : align_type;
+
+-- Instruction address alignment, halfword with compressed instructions
+constant PC_ALIGN_MASK : std_logic_vector(1 downto 0) := boolean_to_std_logic_vector(HAVE_ZCA, "01", "11");
+
 -- Multiplier/divider
 type md_type is record
     -- Operation ready
@@ -313,6 +504,9 @@ end record csr_access_type;
 signal csr_access : csr_access_type;
 
 -- CSR registers
+-- Hardware triggers, tdata1 and tdata2 per trigger
+type tdata_array_type is array (0 to OCD_TRIGGERS-1) of data_type;
+
 type csr_reg_type is record
     mvendorid : data_type;
     marchid : data_type;
@@ -359,11 +553,16 @@ type csr_reg_type is record
     mhpmevent9 : data_type;
     mxhw : data_type;
     mxspeed : data_type;
+    mxhw2 : data_type;
+    mintthresh : data_type;
+    mintstatus : data_type;
+    mxbank : data_type;
+    scountovf : data_type;
     dcsr : data_type;
     dpc : data_type;
     tselect : data_type;
-    tdata1 : data_type;
-    tdata2 : data_type;
+    tdata1 : tdata_array_type;
+    tdata2 : tdata_array_type;
     tinfo : data_type;
     dcsr_cause : std_logic_vector(3 downto 0);
 end record csr_reg_type;
@@ -374,9 +573,28 @@ type csr_transfer_type is record
     mtvec_to_pc : data_type;
     mepc_to_pc : data_type;
     address_to_mtval : data_type;
+    clic_vector : data_type;
 end record csr_transfer_type;
 signal csr_transfer : csr_transfer_type;
 
+-- Events that can be counted by the HPM counters
+constant HPM_EVENTS : integer := 21;
+signal hpm_events : std_logic_vector(HPM_EVENTS-1 downto 0);
+-- Counter overflow interrupt request
+signal hpm_overflow : std_logic;
+
+-- Hardware triggers: selected trigger, address of a load/store,
+-- triggers firing now and triggers that caused the last halt
+signal tsel : integer range 0 to OCD_TRIGGERS-1;
+signal trig_addr : data_type;
+signal trig_hit : std_logic_vector(OCD_TRIGGERS-1 downto 0);
+signal trig_fired : std_logic_vector(OCD_TRIGGERS-1 downto 0);
+
+-- Instruction trace: PC of the instruction that caused a trap and
+-- the trap is tail-chained
+signal trace_source : data_type;
+signal trace_chain : std_logic;
+
 begin
 
     --
@@ -387,13 +605,91 @@ begin
     --
     
 
-    -- Hardware breakpoint match
-    control.bpmatch <= '1' when id_ex.pc = csr_reg.tdata2 and                   -- instruction address match
-                                csr_reg.tdata1(6) = '1' and                     -- and M mode
-                                csr_reg.tdata1(2) = '1' and                     -- and EXECUTE
-                                csr_reg.tdata1(15 downto 12) = "0001" and       -- and enter debug mode
-                                csr_reg.tdata1(10 downto 07) = "0000" else      -- and match equal   
-                       '0'; 
+    -- Address of a load/store in the execute stage, for the triggers
+    process (control, forward, id_ex) is
+    variable address_v : unsigned(31 downto 0);
+    begin
+        if control.forwarda = '1' then
+            address_v := unsigned(forward.rs1data);
+        else
+            address_v := unsigned(id_ex.rs1data);
+        end if;
+        trig_addr <= std_logic_vector(address_v + unsigned(id_ex.imm));
+    end process;
+
+    -- Hardware trigger match (mcontrol6)
+    -- Each trigger matches on the instruction address (execute) or on the
+    -- address of a load/store. Chained triggers only fire if all triggers
+    -- in the chain match, e.g. an address range with >= and <.
+    process (csr_reg, id_ex, trig_addr) is
+    variable match_v : std_logic_vector(OCD_TRIGGERS-1 downto 0);
+    variable value_v : data_type;
+    variable cmp_v : std_logic;
+    variable all_v : std_logic;
+    variable start_v : integer range 0 to OCD_TRIGGERS-1;
+    begin
+        for i in 0 to OCD_TRIGGERS-1 loop
+            match_v(i) := '0';
+            for j in 0 to 2 loop
+                -- Select the value to compare: load/store address or pc
+                if j = 2 then
+                    value_v := id_ex.pc;
+                else
+                    value_v := trig_addr;
+                end if;
+                -- Compare the value to tdata2
+                case csr_reg.tdata1(i)(10 downto 7) is
+                    -- Equal
+                    when "0000" => cmp_v := boolean_to_std_logic(value_v = csr_reg.tdata2(i));
+                    -- NAPOT, the trailing ones of tdata2 and the 0 above them are not compared
+                    when "0001" => cmp_v := boolean_to_std_logic(((value_v xor csr_reg.tdata2(i)) and not
+                                                                  (csr_reg.tdata2(i) xor std_logic_vector(unsigned(csr_reg.tdata2(i)) + 1))) = x"00000000");
+                    -- Greater than or equal
+                    when "0010" => cmp_v := boolean_to_std_logic(unsigned(value_v) >= unsigned(csr_reg.tdata2(i)));
+                    -- Less than
+                    when "0011" => cmp_v := boolean_to_std_logic(unsigned(value_v) < unsigned(csr_reg.tdata2(i)));
+                    when others => cmp_v := '0';
+                end case;
+                -- Load (0), store (1) and execute (2) enable bits
+                if csr_reg.tdata1(i)(j) = '1' and cmp_v = '1' then
+                    if j = 2 or
+                       (j = 1 and id_ex.ismem = '1' and id_ex.memaccess = memaccess_write) or
+                       (j = 0 and id_ex.ismem = '1' and id_ex.memaccess = memaccess_read) then
+                        match_v(i) := '1';
+                    end if;
+                end if;
+            end loop;
+            -- Only M mode and enter debug mode
+            if csr_reg.tdata1(i)(6) = '0' or csr_reg.tdata1(i)(15 downto 12) /= "0001" then
+                match_v(i) := '0';
+            end if;
+        end loop;
+
+        -- Resolve the chains
+        trig_hit <= (others => '0');
+        all_v := '1';
+        start_v := 0;
+        for i in 0 to OCD_TRIGGERS-1 loop
+            all_v := all_v and match_v(i);
+            -- End of chain
+            if csr_reg.tdata1(i)(11) = '0' or i = OCD_TRIGGERS-1 then
+                if all_v = '1' then
+                    for k in 0 to OCD_TRIGGERS-1 loop
+                        if k >= start_v and k <= i then
+                            trig_hit(k) <= '1';
+                        end if;
+                    end loop;
+                end if;
+                all_v := '1';
+                if i < OCD_TRIGGERS-1 then
+                    start_v := i+1;
+                end if;
+            end if;
+        end loop;
+    end process;
+
+    -- Hardware breakpoint/watchpoint match
+    control.bpmatch <= '1' when unsigned(trig_hit) /= 0 and HAVE_OCD else '0';
 
     -- Processor state control
     process (I_clk, I_areset) is
@@ -409,6 +705,7 @@ begin
             control.load_dpc <= '0';
             control.skip_match <= '0';
             csr_reg.dcsr_cause <= "0000";
+            trig_fired <= (others => '0');
         elsif rising_edge(I_clk) then
             -- Synchronous reset
             if I_sreset = '1' then
@@ -421,6 +718,7 @@ begin
                 control.load_dpc <= '0';
                 control.skip_match <= '0';
                 csr_reg.dcsr_cause <= "0000";
+                trig_fired <= (others => '0');
             else
                 control.load_pc <= '0';
                 control.load_dpc <= '0';
@@ -447,20 +745,21 @@ begin
                         O_resume_ack <= '1';  -- keep this at '1'
                         O_halt_ack <= '0';
 
-                        -- If user halt request...
-                        if I_halt_req = '1' and HAVE_OCD then
+                        -- If user halt request, not within a Zcmp sequence...
+                        if I_halt_req = '1' and id_ex.uop_cont = '0' and HAVE_OCD then
                             O_halt_ack <= '1';                  -- Signal halt
                             control.step <= '0';                --
                             control.state <= state_debug;       -- Goto to debug state
                             control.load_dpc <= '1';            -- Load DPC with PC
                             csr_reg.dcsr_cause <= "1011";       -- Signal halt to user
                         -- If hardware breakpoint and not resuming from this breakpoint...
-                        elsif control.bpmatch = '1' and control.skip_match = '0' and HAVE_OCD then
+                        elsif control.bpmatch = '1' and control.skip_match = '0' and id_ex.uop_cont = '0' and HAVE_OCD then
                             O_halt_ack <= '1';                  -- Signal halt
                             control.step <= '0';                --
                             control.state <= state_debug;       -- Goto debug state
                             control.load_dpc <= '1';            -- Load DPC with PC
                             csr_reg.dcsr_cause <= "1010";       -- Signal HW break to user
+                            trig_fired <= trig_hit;             -- Record the triggers that fired
                         -- If software breakpoint...
                         -- Can be switched off with: <targetname> riscv set_ebreakm off
                         -- dcsr(15) is dcsr.ebreakm bit
@@ -470,7 +769,7 @@ begin
                             control.state <= state_debug;       -- Goto debug state
                             control.load_dpc <= '1';            -- Load DPC with PC
                             csr_reg.dcsr_cause <= "1001";       -- Signal EBREAK to user
-                        elsif control.isstepping = '1' and control.step = '0' and HAVE_OCD then
+                        elsif control.isstepping = '1' and control.step = '0' and id_ex.uop_cont = '0' and HAVE_OCD then
                             O_halt_ack <= '1';                  -- Signal halt
                             control.step <= '0';
                             control.state <= state_debug;       -- Goto debug state
@@ -486,11 +785,11 @@ begin
                         -- If we have an mret request (MRET)
                         elsif control.mret_request = '1' then
                             control.state <= state_mret;
-                        -- Jump/branch request
+                        -- Jump/branch request not (correctly) predicted
                         elsif control.penalty = '1' then
                             control.state <= state_flush;
                         -- If we have to wait for data, we need to wait extra cycles
-                        elsif id_ex.ismem = '1' and I_bus_response.ready = '0' then
+                        elsif id_ex.ismem = '1' and I_bus_response.ready = '0' and control.fast_load = '0' then
                             control.state <= state_mem;
                         -- If the MD unit is started....
                         elsif id_ex.md_start = '1' then
@@ -591,11 +890,12 @@ begin
     
     -- Determine stall
     -- We need to stall if we...
-    control.stall <= '1' when (control.state = state_exec and id_ex.ismem = '1' and I_bus_response.ready = '0') or
+    control.stall <= '1' when (control.state = state_exec and id_ex.ismem = '1' and I_bus_response.ready = '0' and control.fast_load = '0') or
                               (control.state = state_md) or
                               (control.state = state_wfi) or
                               (control.state = state_mem and I_bus_response.ready = '0') or
-                              (control.state = state_exec and id_ex.md_start = '1')
+                              (control.state = state_exec and id_ex.md_start = '1') or
+                              (control.state = state_exec and id_ex.fence = '1' and I_store_buffer_empty = '0')
                          else '0';
     -- If we got a trigger (breakpoint (hw/sw) or step)
     control.stall_on_trigger <= '1' when (control.state = state_exec and I_halt_req = '1' and HAVE_OCD) or
@@ -605,8 +905,22 @@ begin
                                          (control.state = state_exec and control.isstepping = '1' and control.step = '0' and HAVE_OCD)
                                     else '0';
 
+    -- The execute stage or the debugger loads the PC
+    control.redirect <= '1' when control.load_pc = '1' or
+                                 (control.stall = '0' and control.stall_on_trigger = '0' and
+                                  (control.penalty = '1' or id_ex.pc_op = pc_loadoffsetregister or
+                                   id_ex.pc_op = pc_load_mtvec or id_ex.pc_op = pc_load_mepc))
+                            else '0';
+
+    -- Instruction fetch advances if the fetched instruction is
+    -- taken by the decode stage or stored in the prefetch queue
+    control.fetch <= '1' when control.stall_on_trigger = '0' and control.load_pc = '0' and
+                              (if_id.valid = '0' or pq.push = '1' or
+                               (control.stall = '0' and control.load_hazard = '0' and align.take = '1' and pq.count = 0))
+                         else '0';
+
     -- Needed for the instruction fetch for the ROM or boot ROM
-    O_instr_request.stall <= control.stall or control.stall_on_trigger;
+    O_instr_request.stall <= not control.fetch;
 
     -- We need to flush if we are jumping/branching or servicing interrupts
     control.flush <= '1' when control.penalty = '1' or
@@ -619,17 +933,26 @@ begin
                          else '0'; -- for now
 
     -- Instructions retired -- not exact, needs more detail
-    control.instret <= '1' when (control.state = state_exec and control.trap_request = '0' and id_ex.ismem = '0'
+    -- A Zcmp sequence retires with the last micro-operation
+    control.instret <= '1' when ((control.state = state_exec and control.trap_request = '0' and id_ex.ismem = '0'
                                                             and id_ex.md_start = '0' and control.penalty = '0'
-                                                            and control.mret_request = '0' and I_halt_req = '0'
-                                                            and control.bpmatch = '0' and control.ebreak_request = '0'
+                                                            and id_ex.bubble = '0'
+                                                            and control.mret_request = '0'
+                                                            and ((I_halt_req = '0' and control.bpmatch = '0') or id_ex.uop_cont = '1')
+                                                            and control.ebreak_request = '0'
                                                             and control.stall_on_trigger = '0') or
                                  (control.state = state_mem and I_bus_response.ready = '1') or
+                                  control.fast_load = '1' or
                                   control.state = state_md2 or
                                   control.state = state_flush2 or
-                                  control.state = state_mret2
+                                  control.state = state_mret2) and id_ex.uop_more = '0'
                            else '0'; 
                                     
+    -- Write the result to the registers, a fast load writes later
+    control.regwrite <= '1' when control.stall = '0' and control.stall_on_trigger = '0' and id_ex.rd_en = '1' and
+                                 control.trap_request = '0' and control.fast_load = '0'
+                            else '0';
+
     -- We're in debug
     control.indebug <= '1' when control.state = state_debug else '0';
     
@@ -640,9 +963,32 @@ begin
     control.mret_request_delay <= '1' when control.state = state_mret2 else '0';
     
     -- May the core be interrupted (only for interrupts, not exceptions), but not when stepping?
-    control.may_interrupt <= '1' when (control.state = state_exec or control.state = state_wfi) and control.isstepping = '0' else '0';
+    -- A Zcmp sequence can only be interrupted before the first micro-operation.
+    control.may_interrupt <= '1' when (control.state = state_exec or control.state = state_wfi) and control.isstepping = '0' and
+                                      id_ex.uop_cont = '0'
+                                 else '0';
+
+    -- CLIC mode is selected with mtvec mode 11
+    control.clic_mode <= '1' when HAVE_CLIC and csr_reg.mtvec(1 downto 0) = "11" else '0';
+
+    -- An interrupt from the CLIC preempts if its level is above
+    -- the current interrupt level and the threshold
+    control.clic_preempt <= '1' when control.clic_mode = '1' and I_clic.valid = '1' and
+                                     unsigned(I_clic.level) > unsigned(csr_reg.mintstatus(31 downto 24)) and
+                                     unsigned(I_clic.level) > unsigned(csr_reg.mintthresh(7 downto 0))
+                                else '0';
+
+    -- On MRET, an interrupt that would be taken directly after the
+    -- return is entered without returning (tail-chaining). Interrupts
+    -- must be enabled after the return and the level must be above
+    -- the level returned to (mcause.mpil).
+    control.clic_chain <= '1' when control.clic_mode = '1' and I_clic.valid = '1' and csr_reg.mstatus(7) = '1' and
+                                   unsigned(I_clic.level) > unsigned(csr_reg.mcause(23 downto 16)) and
+                                   unsigned(I_clic.level) > unsigned(csr_reg.mintthresh(7 downto 0))
+                              else '0';
     
     -- Check if the currently executing instruction address is aligned to word
+    -- With compressed instructions, only bit 0 of the address must be 0.
     -- We need to make a one-shot, because the PC is incremented by 4 each clock
     -- cycle so the pipeline PCs will all be misaligned and the misaligned signal
     -- would be multiple clock cycles which messes up trap entry.
@@ -653,44 +999,60 @@ begin
         elsif rising_edge(I_clk) then
             if I_sreset = '1' then
                 control.instr_misaligned_ff <= '0';
-            elsif id_ex.pc(1 downto 0) /= "00" then
+            elsif (id_ex.pc(1 downto 0) and PC_ALIGN_MASK) /= "00" then
                 control.instr_misaligned_ff <= '1';
             else
                 control.instr_misaligned_ff <= '0';
             end if;
         end if;
     end process;
-    control.instruction_misaligned <= '1' when id_ex.pc(1 downto 0) /= "00" and control.instr_misaligned_ff = '0' else '0';
+    control.instruction_misaligned <= '1' when (id_ex.pc(1 downto 0) and PC_ALIGN_MASK) /= "00" and control.instr_misaligned_ff = '0' else '0';
             
-    -- Delay instruction access (read) error) for two cycles so that
-    -- the faulted address/instruction is being processed in the
+    -- Instruction access (read) error travels with the instruction
+    -- and is registered when the faulted instruction enters the
     -- execute stage.
     process (I_clk, I_areset) is
     begin
         if I_areset = '1' then
-            control.instr_access_error <= (others => '0');
+            control.instr_access_error <= '0';
         elsif rising_edge(I_clk) then
             if I_sreset = '1' then
-                control.instr_access_error <= (others => '0');
+                control.instr_access_error <= '0';
             elsif control.state = state_trap then
-                control.instr_access_error <= (others => '0');
-            else
-                control.instr_access_error <= control.instr_access_error(0) & I_instr_response.instr_access_error;
+                control.instr_access_error <= '0';
+            elsif control.stall = '0' and control.stall_on_trigger = '0' then
+                -- Instructions not executed cannot fault
+                if control.flush = '1' or control.trap_request = '1' or control.state = state_debugflush2 or
+                   control.load_hazard = '1' then
+                    control.instr_access_error <= '0';
+                else
+                    control.instr_access_error <= decode_in.error and decode_in.valid;
+                end if;
             end if;
         end if;
     end process;
     
 
     -- Data forwarder detectrion. Signals if RS1/RS2 must be forwarded.
-    process (id_ex, ex_wb) is
+    -- The latest result takes precedence over fast load data. Fast load
+    -- data is only forwarded to the register bank it was loaded for.
+    process (id_ex, ex_wb, lwb, csr_reg.mxbank) is
     begin
+        forward.rs1data <= ex_wb.rddata;
+        forward.rs2data <= ex_wb.rddata;
         if ex_wb.rd_en = '1' and ex_wb.rd = id_ex.rs1 then
             control.forwarda <= '1';
+        elsif lwb.valid = '1' and lwb.rd = id_ex.rs1 and lwb.bank = csr_reg.mxbank(0) then
+            control.forwarda <= '1';
+            forward.rs1data <= lwb.data;
         else
             control.forwarda <= '0';
         end if;
         if ex_wb.rd_en = '1' and ex_wb.rd = id_ex.rs2 then
             control.forwardb <= '1';
+        elsif lwb.valid = '1' and lwb.rd = id_ex.rs2 and lwb.bank = csr_reg.mxbank(0) then
+            control.forwardb <= '1';
+            forward.rs2data <= lwb.data;
         else
             control.forwardb <= '0';
         end if;
@@ -706,6 +1068,7 @@ begin
     
     -- The PC
     process (I_clk, I_areset) is
+    variable pc_next_v : data_type;
     begin
         -- Asynchronous reset
         if I_areset = '1' then
@@ -725,41 +1088,45 @@ begin
                     pc(pc'left downto pc'left-3) <= ROM_HIGH_NIBBLE;
                 end if;
             else
+                -- Next PC if the execute stage does not load the PC.
+                -- A jump/branch predicted taken on the fetched instruction
+                -- takes precedence over a BTB hit on the PC.
+                if bp.redirect = '1' then
+                    pc_next_v := bp.want_pc;
+                elsif bp.fetch_redirect = '1' then
+                    pc_next_v := bp.fetch_target;
+                -- Fetch the next word, the PC may point to the
+                -- upper half of a word after a jump/branch
+                elsif HAVE_ZCA then
+                    pc_next_v := std_logic_vector(unsigned(pc(31 downto 2)) + 1) & "00";
+                else
+                    pc_next_v := std_logic_vector(unsigned(pc) + 4);
+                end if;
                 -- Load DPC to PC
                 if control.load_pc = '1' then
                     pc <= csr_reg.dpc;
-                -- Should we stall the pipeline
-                elsif control.stall = '1' or control.stall_on_trigger = '1' then
-                    -- PC holds value
-                    null;
-                else
+                -- The execute stage loads the PC
+                elsif control.redirect = '1' then
                     case id_ex.pc_op is
-                        -- Hold the PC
-                        when pc_hold =>
-                            null;
-                        -- Increment the PC
-                        when pc_incr =>
-                            pc <= std_logic_vector(unsigned(pc) + 4);
-                        -- JAL
+                        -- JAL, not predicted
                         when pc_loadoffset =>
-                            pc <= std_logic_vector(unsigned(id_ex.pc) + unsigned(id_ex.imm));
+                            pc <= bp.ex_target;
                         -- JALR
                         when pc_loadoffsetregister =>
                             -- Check forwarding
                             if control.forwarda = '1' then
-                                pc <= std_logic_vector(unsigned(ex_wb.rddata) + unsigned(id_ex.imm));
+                                pc <= std_logic_vector(unsigned(forward.rs1data) + unsigned(id_ex.imm));
                             else
                                 pc <= std_logic_vector(unsigned(id_ex.rs1data) + unsigned(id_ex.imm));
                             end if;
                             -- As per RISC-V unpriv spec
                             pc(0) <= '0';
-                        -- Branch
+                        -- Branch, mispredicted
                         when pc_branch =>
-                            -- Must we branch?
-                            if control.penalty = '1' then
-                                pc <= std_logic_vector(unsigned(id_ex.pc) + unsigned(id_ex.imm));
+                            if id_ex.predict = '1' then
+                                pc <= bp.ex_next;
                             else
-                                pc <= std_logic_vector(unsigned(pc) + 4);
+                                pc <= bp.ex_target;
                             end if;
                         -- Load mtvec, direct or vectored
                         when pc_load_mtvec =>
@@ -768,12 +1135,110 @@ begin
                         when pc_load_mepc =>
                             pc <= csr_transfer.mepc_to_pc;
                         when others =>
-                            pc <= std_logic_vector(unsigned(pc) + 4);
+                            pc <= pc_next_v;
                     end case;
+                -- Fetch the next instruction
+                elsif control.fetch = '1' then
+                    pc <= pc_next_v;
                 end if;
             end if; -- sreset
         end if; -- posedge
     end process;
+
+    -- Instruction trace
+    -- Reports the discontinuities in the instruction flow: taken
+    -- branches and jumps, traps, MRET and resuming from debug mode.
+    -- An event is reported when the instruction retires, a jump or
+    -- branch that is followed by a trap is not reported. The events
+    -- are registered and do not influence the pipeline.
+    tracegen : if HAVE_TRACE generate
+        process (I_clk, I_areset) is
+        begin
+            if I_areset = '1' then
+                O_trace <= trace_none_c;
+                trace_source <= (others => '0');
+                trace_chain <= '0';
+            elsif rising_edge(I_clk) then
+                O_trace.valid <= '0';
+                if I_sreset = '1' then
+                    O_trace <= trace_none_c;
+                    trace_source <= (others => '0');
+                    trace_chain <= '0';
+                else
+                    -- Trap taken, the PC is loaded with the trap vector later
+                    if control.trap_request = '1' and control.stall_on_trigger = '0' then
+                        trace_source <= id_ex.pc;
+                        trace_chain <= control.trap_chain;
+                    end if;
+                    -- Resume from debug mode, the flow restarts at DPC
+                    if control.load_pc = '1' then
+                        O_trace.valid <= '1';
+                        O_trace.kind <= trace_resume_c;
+                        O_trace.source <= csr_reg.dpc;
+                        O_trace.target <= csr_reg.dpc;
+                    -- Trap vector loaded in the PC
+                    elsif control.redirect = '1' and id_ex.pc_op = pc_load_mtvec then
+                        O_trace.valid <= '1';
+                        if trace_chain = '1' then
+                            O_trace.kind <= trace_chain_c;
+                        else
+                            O_trace.kind <= trace_trap_c;
+                        end if;
+                        O_trace.source <= trace_source;
+                        O_trace.target <= csr_transfer.mtvec_to_pc;
+                    -- Instruction retires in the execute stage
+                    elsif control.state = state_exec and control.stall = '0' and
+                          control.stall_on_trigger = '0' and control.trap_request = '0' then
+                        O_trace.source <= id_ex.pc;
+                        -- MRET
+                        if id_ex.pc_op = pc_load_mepc then
+                            O_trace.valid <= '1';
+                            O_trace.kind <= trace_mret_c;
+                            O_trace.target <= csr_transfer.mepc_to_pc;
+                        -- JALR
+                        elsif bp.ex_taken = '1' and id_ex.pc_op = pc_loadoffsetregister then
+                            O_trace.valid <= '1';
+                            O_trace.kind <= trace_indirect_c;
+                            O_trace.target <= trig_addr(31 downto 1) & '0';
+                        -- JAL and taken branches
+                        elsif bp.ex_taken = '1' then
+                            O_trace.valid <= '1';
+                            O_trace.kind <= trace_direct_c;
+                            O_trace.target <= bp.ex_target;
+                        end if;
+                    end if;
+                end if; -- sreset
+            end if; -- posedge
+        end process;
+    end generate;
+
+    tracegen_not : if not HAVE_TRACE generate
+        O_trace <= trace_none_c;
+        trace_source <= (others => '0');
+        trace_chain <= '0';
+    end generate;
+
+    -- PC sampling
+    -- Registers the PC of the last retired instruction, so that the
+    -- debugger can sample the PC without halting the hart.
+    pcsamplegen : if HAVE_OCD generate
+        process (I_clk, I_areset) is
+        begin
+            if I_areset = '1' then
+                O_pcsample <= (others => '0');
+            elsif rising_edge(I_clk) then
+                if I_sreset = '1' then
+                    O_pcsample <= (others => '0');
+                elsif control.instret = '1' then
+                    O_pcsample <= id_ex.pc;
+                end if;
+            end if;
+        end process;
+    end generate;
+
+    pcsamplegen_not : if not HAVE_OCD generate
+        O_pcsample <= (others => '0');
+    end generate;
     -- For fetching instructions
     O_instr_request.pc <= pc;
 
@@ -788,24 +1253,409 @@ begin
             -- states. After that, this PC will follow
             -- the PC.
             if_id.pc <= (others => '0');
+            if_id.valid <= '0';
+            if_id.error <= '0';
+            if_id.hit <= '0';
+            if_id.predict <= '0';
+            if_id.target <= (others => '0');
         elsif rising_edge(I_clk) then
             if I_sreset = '1' then
                 if_id.pc <= (others => '0');
-            -- Must we stall?
-            elsif control.stall = '1' or control.stall_on_trigger = '1' or id_ex.pc_op = pc_hold then
-                null;
-            else
+                if_id.valid <= '0';
+                if_id.error <= '0';
+                if_id.hit <= '0';
+                if_id.predict <= '0';
+                if_id.target <= (others => '0');
+            -- The instruction being fetched is discarded
+            elsif control.redirect = '1' then
+                if_id.valid <= '0';
+            elsif control.fetch = '1' then
                 if_id.pc <= pc;
+                -- Not valid if the fetched instruction loads the PC
+                if_id.valid <= not bp.redirect;
+                if_id.error <= I_instr_response.instr_access_error;
+                if_id.hit <= bp.hit;
+                if_id.predict <= bp.fetch_redirect;
+                if_id.target <= bp.fetch_target;
             end if;
         end if;
     end process;
 
+
+    --
+    -- Branch prediction
+    -- Jumps (JAL) and backward branches are predicted taken on the
+    -- fetched instruction (BTFN), before it enters the prefetch queue
+    -- or the decode stage. The PC is loaded with the target address
+    -- and the instruction fetched after the jump/branch is discarded,
+    -- so a correctly predicted jump/branch taken costs two clock
+    -- cycles. With the optional BTB, the target address is loaded
+    -- in the fetch stage and a correctly predicted jump/branch costs
+    -- one clock cycle. The BTB holds a two-bit counter per entry.
+    -- A mispredicted jump/branch is resolved in the execute stage
+    -- and flushes the pipeline. JALR is never predicted.
+    --
+
+    -- Target and fall-through address of the jump/branch in execute
+    bp.ex_target <= std_logic_vector(unsigned(id_ex.pc) + unsigned(id_ex.imm));
+    bp.ex_next <= std_logic_vector(unsigned(id_ex.pc) + 4);
+    
+    -- The fetched instruction may load the PC if it is taken by the
+    -- decode stage or the prefetch queue and the execute stage does
+    -- not load the PC. This also happens while the decode stage stalls.
+    bp.redirect <= '1' when bp.want = '1' and if_id.valid = '1' and control.fetch = '1' and
+                            control.redirect = '0' and control.flush = '0' and control.trap_request = '0'
+                        else '0';
+
+    -- The fetch stage may load the PC with the BTB target if
+    -- no other stage loads the PC
+    bp.fetch_redirect <= '1' when bp.fetch_taken = '1' and bp.redirect = '0' and
+                                  control.fetch = '1' and control.redirect = '0'
+                             else '0';
+
+    -- A BTB hit on an instruction that is not a jump/branch or
+    -- with a different target address (e.g. reloaded program)
+    bp.invalidate <= bp.redirect and if_id.predict;
+
+    -- Update BTB and count a jump/branch in execute
+    bp.update <= '1' when control.state = state_exec and control.trap_request = '0' and control.stall_on_trigger = '0' and
+                          (id_ex.pc_op = pc_branch or id_ex.pc_op = pc_loadoffset)
+                     else '0';
+    control.predicted <= bp.update and not control.penalty;
+
+    -- Static prediction on the fetched instruction. Not available
+    -- with compressed instructions, the fetched word is not aligned
+    -- with the instruction.
+    bpgen : if HAVE_BRANCH_PREDICTION and not HAVE_ZCA generate
+        process (I_instr_response.instr, if_id) is
+        variable opcode_v : std_logic_vector(6 downto 0);
+        variable func3_v : std_logic_vector(2 downto 0);
+        variable imm_v : data_type;
+        variable target_v : data_type;
+        variable jump_v : std_logic;
+        variable taken_v : std_logic;
+        begin
+            opcode_v := I_instr_response.instr(6 downto 0);
+            func3_v := I_instr_response.instr(14 downto 12);
+            jump_v := '0';
+            taken_v := '0';
+            -- JAL, always taken
+            if opcode_v = "1101111" then
+                imm_v(31 downto 21) := (others => I_instr_response.instr(31));
+                imm_v(20 downto 1) := I_instr_response.instr(31) & I_instr_response.instr(19 downto 12) & I_instr_response.instr(20) & I_instr_response.instr(30 downto 21);
+                imm_v(0) := '0';
+                jump_v := '1';
+                taken_v := '1';
+            else
+                imm_v(31 downto 13) := (others => I_instr_response.instr(31));
+                imm_v(12 downto 1) := I_instr_response.instr(31) & I_instr_response.instr(7) & I_instr_response.instr(30 downto 25) & I_instr_response.instr(11 downto 8);
+                imm_v(0) := '0';
+                -- Branches
+                if opcode_v = "1100011" and func3_v /= "010" and func3_v /= "011" then
+                    jump_v := '1';
+                    if HAVE_BTB and if_id.hit = '1' then
+                        -- Follow the BTB counter
+                        taken_v := if_id.predict;
+                    else
+                        -- Backward taken, forward not taken
+                        taken_v := I_instr_response.instr(31);
+                    end if;
+                end if;
+            end if;
+            target_v := std_logic_vector(unsigned(if_id.pc) + unsigned(imm_v));
+
+            bp.taken <= taken_v;
+            -- Predicted taken, load the PC if the fetch
+            -- stage did not already do so
+            if taken_v = '1' and (if_id.predict = '0' or if_id.target /= target_v) then
+                bp.want <= '1';
+                bp.want_pc <= target_v;
+            -- Not a jump/branch or predicted not taken, but the
+            -- BTB loaded the PC: continue after this instruction
+            elsif taken_v = '0' and if_id.predict = '1' then
+                bp.want <= '1';
+                bp.want_pc <= std_logic_vector(unsigned(if_id.pc) + 4);
+            else
+                bp.want <= '0';
+                bp.want_pc <= target_v;
+            end if;
+        end process;
+    end generate;
+
+    bpgen_not : if not (HAVE_BRANCH_PREDICTION and not HAVE_ZCA) generate
+        bp.taken <= '0';
+        bp.want <= '0';
+        bp.want_pc <= (others => '0');
+    end generate;
+
+    -- The branch target buffer in the fetch stage
+    btbgen : if HAVE_BRANCH_PREDICTION and HAVE_BTB and not HAVE_ZCA generate
+        -- Look up the PC
+        process (pc, bp.valid, bp.tag, bp.target, bp.counter) is
+        variable index_v : integer range 0 to BTB_SIZE-1;
+        begin
+            index_v := to_integer(unsigned(pc(BTB_SIZE_BITS+1 downto 2)));
+            if bp.valid(index_v) = '1' and bp.tag(index_v) = pc(31 downto BTB_SIZE_BITS+2) then
+                bp.hit <= '1';
+                bp.fetch_taken <= bp.counter(index_v)(1);
+            else
+                bp.hit <= '0';
+                bp.fetch_taken <= '0';
+            end if;
+            bp.fetch_target <= bp.target(index_v);
+        end process;
+
+        -- Update the BTB with the jump/branch in execute
+        process (I_clk, I_areset) is
+        variable index_v : integer range 0 to BTB_SIZE-1;
+        begin
+            if I_areset = '1' then
+                bp.valid <= (others => '0');
+            elsif rising_edge(I_clk) then
+                if I_sreset = '1' then
+                    bp.valid <= (others => '0');
+                else
+                    if bp.invalidate = '1' then
+                        bp.valid(to_integer(unsigned(if_id.pc(BTB_SIZE_BITS+1 downto 2)))) <= '0';
+                    end if;
+                    if bp.update = '1' then
+                        index_v := to_integer(unsigned(id_ex.pc(BTB_SIZE_BITS+1 downto 2)));
+                        if bp.valid(index_v) = '1' and bp.tag(index_v) = id_ex.pc(31 downto BTB_SIZE_BITS+2) then
+                            -- Saturating counter
+                            if bp.ex_taken = '1' and bp.counter(index_v) /= "11" then
+                                bp.counter(index_v) <= bp.counter(index_v) + 1;
+                            elsif bp.ex_taken = '0' and bp.counter(index_v) /= "00" then
+                                bp.counter(index_v) <= bp.counter(index_v) - 1;
+                            end if;
+                        elsif bp.ex_taken = '1' then
+                            -- New entry, weakly taken
+                            bp.valid(index_v) <= '1';
+                            bp.tag(index_v) <= id_ex.pc(31 downto BTB_SIZE_BITS+2);
+                            bp.target(index_v) <= bp.ex_target;
+                            bp.counter(index_v) <= "10";
+                        end if;
+                    end if;
+                end if;
+            end if;
+        end process;
+    end generate;
+
+    btbgen_not : if not (HAVE_BRANCH_PREDICTION and HAVE_BTB and not HAVE_ZCA) generate
+        bp.hit <= '0';
+        bp.fetch_taken <= '0';
+        bp.fetch_target <= (others => '0');
+        bp.valid <= (others => '0');
+    end generate;
+
+
+    --
+    -- Instruction prefetch queue
+    -- The fetched instruction is stored in the queue if the decode
+    -- stage cannot take it, so instruction fetch continues while the
+    -- core waits for data memory or the multiply/divide unit. The
+    -- decode stage takes the oldest instruction from the queue, or
+    -- the fetched instruction if the queue is empty. The queue is
+    -- cleared when the pipeline is flushed or the PC is loaded.
+    --
+
+    pqgen : if HAVE_PREFETCH generate
+        pq.pop <= '1' when control.stall = '0' and control.stall_on_trigger = '0' and control.load_hazard = '0' and
+                           align.take = '1' and pq.count /= 0
+                      else '0';
+        pq.push <= '1' when if_id.valid = '1' and control.stall_on_trigger = '0' and
+                            (control.stall = '1' or control.load_hazard = '1' or align.take = '0' or pq.count /= 0) and
+                            (pq.count /= PREFETCH_DEPTH or pq.pop = '1')
+                       else '0';
+        pq.clear <= control.flush or control.redirect;
+
+        process (I_clk, I_areset) is
+        variable count_v : integer range 0 to PREFETCH_DEPTH;
+        begin
+            if I_areset = '1' then
+                pq.count <= 0;
+            elsif rising_edge(I_clk) then
+                if I_sreset = '1' or pq.clear = '1' then
+                    pq.count <= 0;
+                else
+                    count_v := pq.count;
+                    if pq.pop = '1' then
+                        for i in 0 to PREFETCH_DEPTH-2 loop
+                            pq.queue(i) <= pq.queue(i+1);
+                        end loop;
+                        count_v := count_v - 1;
+                    end if;
+                    if pq.push = '1' then
+                        pq.queue(count_v).instr <= I_instr_response.instr;
+                        pq.queue(count_v).pc <= if_id.pc;
+                        pq.queue(count_v).predict <= bp.taken;
+                        pq.queue(count_v).error <= if_id.error;
+                        pq.queue(count_v).valid <= '1';
+                        pq.queue(count_v).compressed <= '0';
+                        pq.queue(count_v).uop_cont <= '0';
+                        pq.queue(count_v).uop_more <= '0';
+                        count_v := count_v + 1;
+                    end if;
+                    pq.count <= count_v;
+                end if;
+            end if;
+        end process;
+
+        fetch_out <= pq.queue(0) when pq.count /= 0 else
+                     (instr => I_instr_response.instr, pc => if_id.pc, predict => bp.taken,
+                      error => if_id.error, valid => if_id.valid, compressed => '0',
+                      uop_cont => '0', uop_more => '0');
+    end generate;
+
+    pqgen_not : if not HAVE_PREFETCH generate
+        pq.pop <= '0';
+        pq.push <= '0';
+        pq.clear <= '0';
+        pq.count <= 0;
+        fetch_out <= (instr => I_instr_response.instr, pc => if_id.pc, predict => bp.taken,
+                      error => if_id.error, valid => if_id.valid, compressed => '0',
+                      uop_cont => '0', uop_more => '0');
+    end generate;
+
+
+    --
+    -- Instruction aligner
+    -- Instructions are fetched as aligned words. The aligner keeps
+    -- the upper half of a word if it holds a compressed instruction
+    -- or the lower half of a 32-bit instruction that crosses a word
+    -- boundary. Compressed instructions are expanded to their 32-bit
+    -- equivalent. If the kept upper half holds a compressed
+    -- instruction, the word from the fetch stage or the queue is
+    -- not used and instruction fetch waits one clock cycle.
+    --
+
+    zcagen : if HAVE_ZCA generate
+        process (fetch_out, align) is
+        variable half_v : std_logic_vector(15 downto 0);
+        variable last_v : integer range 0 to 15;
+        variable instr_v : data_type;
+        begin
+            -- The halfword that holds the (start of the) instruction
+            if align.valid = '1' then
+                half_v := align.buf;
+            elsif fetch_out.pc(1) = '1' then
+                half_v := fetch_out.instr(31 downto 16);
+            else
+                half_v := fetch_out.instr(15 downto 0);
+            end if;
+            -- Zcmp instructions are a sequence of micro-operations
+            if HAVE_ZCMP then
+                last_v := zcmp_last(half_v);
+            else
+                last_v := 0;
+            end if;
+            if last_v /= 0 then
+                instr_v := expand_zcmp(half_v, align.step);
+            else
+                instr_v := expand_compressed(half_v, HAVE_ZCB);
+            end if;
+
+            decode_in <= fetch_out;
+            align.take <= '1';
+            align.pending <= '0';
+            align.more <= '0';
+            if align.valid = '1' then
+                if align.buf(1 downto 0) /= "11" then
+                    -- Compressed instruction in the kept upper half
+                    decode_in.instr <= instr_v;
+                    decode_in.pc <= align.pc;
+                    decode_in.error <= align.error;
+                    decode_in.valid <= '1';
+                    decode_in.compressed <= '1';
+                    align.take <= '0';
+                else
+                    -- 32-bit instruction that crosses a word boundary
+                    decode_in.instr <= fetch_out.instr(15 downto 0) & align.buf;
+                    decode_in.pc <= align.pc;
+                    decode_in.error <= align.error or fetch_out.error;
+                    align.pending <= not fetch_out.valid;
+                end if;
+            elsif fetch_out.pc(1) = '1' then
+                -- Jumped to the upper half of the word
+                if fetch_out.instr(17 downto 16) /= "11" then
+                    decode_in.instr <= instr_v;
+                    decode_in.compressed <= '1';
+                else
+                    -- Wait for the upper half of the instruction
+                    decode_in.valid <= '0';
+                    align.pending <= fetch_out.valid;
+                end if;
+            elsif fetch_out.instr(1 downto 0) /= "11" then
+                -- Compressed instruction in the lower half
+                decode_in.instr <= instr_v;
+                decode_in.compressed <= '1';
+            end if;
+            -- Keep the instruction until the last micro-operation
+            if last_v /= 0 and (align.valid = '1' or fetch_out.valid = '1') then
+                decode_in.uop_cont <= boolean_to_std_logic(align.step /= 0);
+                if align.step /= last_v then
+                    decode_in.uop_more <= '1';
+                    align.take <= '0';
+                    align.more <= '1';
+                end if;
+            end if;
+        end process;
+
+        -- Keep the upper half of the word when the decode stage
+        -- takes an instruction
+        process (I_clk, I_areset) is
+        begin
+            if I_areset = '1' then
+                align.buf <= (others => '0');
+                align.pc <= (others => '0');
+                align.error <= '0';
+                align.valid <= '0';
+                align.step <= 0;
+            elsif rising_edge(I_clk) then
+                if I_sreset = '1' or control.flush = '1' or control.redirect = '1' then
+                    align.valid <= '0';
+                    align.step <= 0;
+                elsif control.stall = '0' and control.stall_on_trigger = '0' and control.load_hazard = '0' then
+                    if align.more = '1' then
+                        -- Next micro-operation
+                        align.step <= align.step + 1;
+                    elsif align.take = '0' then
+                        -- Kept compressed instruction is taken
+                        align.valid <= '0';
+                        align.step <= 0;
+                    elsif fetch_out.valid = '1' then
+                        align.buf <= fetch_out.instr(31 downto 16);
+                        align.pc <= fetch_out.pc(31 downto 2) & "10";
+                        align.error <= fetch_out.error;
+                        align.step <= 0;
+                        if fetch_out.pc(1) = '0' then
+                            align.valid <= align.valid or boolean_to_std_logic(fetch_out.instr(1 downto 0) /= "11");
+                        else
+                            align.valid <= boolean_to_std_logic(fetch_out.instr(17 downto 16) = "11");
+                        end if;
+                    end if;
+                end if;
+            end if;
+        end process;
+    end generate;
+
+    zcagen_not : if not HAVE_ZCA generate
+        decode_in <= fetch_out;
+        align.take <= '1';
+        align.pending <= '0';
+        align.step <= 0;
+        align.more <= '0';
+        align.buf <= (others => '0');
+        align.pc <= (others => '0');
+        align.error <= '0';
+        align.valid <= '0';
+    end generate;
+
     
     --
     -- Instruction decode block
     --
    
-    process (I_clk, I_areset, I_instr_response, control) is
+    process (I_clk, I_areset, decode_in, control) is
     variable opcode_v : std_logic_vector(6 downto 0);
     variable func3_v : std_logic_vector(2 downto 0);
     variable func7_v : std_logic_vector(6 downto 0);
@@ -822,34 +1672,34 @@ begin
 
 
         -- Get the opcode and destination register
-        opcode_v := I_instr_response.instr(6 downto 0);
-        rd_v := I_instr_response.instr(11 downto 7);
+        opcode_v := decode_in.instr(6 downto 0);
+        rd_v := decode_in.instr(11 downto 7);
 
         -- Registers to select
-        rs1_v := I_instr_response.instr(19 downto 15);
-        rs2_v := I_instr_response.instr(24 downto 20);
+        rs1_v := decode_in.instr(19 downto 15);
+        rs2_v := decode_in.instr(24 downto 20);
 
         -- Get function (extends the opcode)
-        func3_v := I_instr_response.instr(14 downto 12);
-        func7_v := I_instr_response.instr(31 downto 25);
+        func3_v := decode_in.instr(14 downto 12);
+        func7_v := decode_in.instr(31 downto 25);
 
         -- Create all immediate formats
-        imm_u_v(31 downto 12) := I_instr_response.instr(31 downto 12);
+        imm_u_v(31 downto 12) := decode_in.instr(31 downto 12);
         imm_u_v(11 downto 0) := (others => '0');
         
-        imm_j_v(31 downto 21) := (others => I_instr_response.instr(31));
-        imm_j_v(20 downto 1) := I_instr_response.instr(31) & I_instr_response.instr(19 downto 12) & I_instr_response.instr(20) & I_instr_response.instr(30 downto 21);
+        imm_j_v(31 downto 21) := (others => decode_in.instr(31));
+        imm_j_v(20 downto 1) := decode_in.instr(31) & decode_in.instr(19 downto 12) & decode_in.instr(20) & decode_in.instr(30 downto 21);
         imm_j_v(0) := '0';
 
-        imm_i_v(31 downto 12) := (others => I_instr_response.instr(31));
-        imm_i_v(11 downto 0) := I_instr_response.instr(31 downto 20);
+        imm_i_v(31 downto 12) := (others => decode_in.instr(31));
+        imm_i_v(11 downto 0) := decode_in.instr(31 downto 20);
         
-        imm_b_v(31 downto 13) := (others => I_instr_response.instr(31));
-        imm_b_v(12 downto 1) := I_instr_response.instr(31) & I_instr_response.instr(7) & I_instr_response.instr(30 downto 25) & I_instr_response.instr(11 downto 8);
+        imm_b_v(31 downto 13) := (others => decode_in.instr(31));
+        imm_b_v(12 downto 1) := decode_in.instr(31) & decode_in.instr(7) & decode_in.instr(30 downto 25) & decode_in.instr(11 downto 8);
         imm_b_v(0) := '0';
 
-        imm_s_v(31 downto 12) := (others => I_instr_response.instr(31));
-        imm_s_v(11 downto 0) := I_instr_response.instr(31 downto 25) & I_instr_response.instr(11 downto 7);
+        imm_s_v(31 downto 12) := (others => decode_in.instr(31));
+        imm_s_v(11 downto 0) := decode_in.instr(31 downto 25) & decode_in.instr(11 downto 7);
         
         imm_shamt_v(31 downto 5) := (others => '0');
         imm_shamt_v(4 downto 0) := rs2_v;
@@ -871,7 +1721,12 @@ begin
             id_ex.ismem <= '0';
             id_ex.alu_op <= alu_unknown;
             id_ex.pc_op <= pc_incr;
+            id_ex.predict <= '0';
+            id_ex.bubble <= '0';
             id_ex.md_start <= '0';
+            id_ex.fence <= '0';
+            id_ex.uop_cont <= '0';
+            id_ex.uop_more <= '0';
             id_ex.md_op <= (others => '0');
             id_ex.memaccess <= memaccess_nop;
             id_ex.memsize <= memsize_unknown;
@@ -897,7 +1752,12 @@ begin
                 id_ex.ismem <= '0';
                 id_ex.alu_op <= alu_unknown;
                 id_ex.pc_op <= pc_incr;
+                id_ex.predict <= '0';
+                id_ex.bubble <= '0';
                 id_ex.md_start <= '0';
+                id_ex.fence <= '0';
+                id_ex.uop_cont <= '0';
+                id_ex.uop_more <= '0';
                 id_ex.md_op <= (others => '0');
                 id_ex.memaccess <= memaccess_nop;
                 id_ex.memsize <= memsize_unknown;
@@ -910,7 +1770,7 @@ begin
                 control.wfi_request <= '0';
                 control.illegal_instruction_decode <= '0';
             else
-                id_ex.instr <= I_instr_response.instr;
+                id_ex.instr <= decode_in.instr;
                 id_ex.ismem <= '0';
                 -- If in debug...
                 if control.stall_on_trigger = '1' then
@@ -925,6 +1785,9 @@ begin
                     id_ex.alu_op <= alu_nop;
                     id_ex.pc_op <= pc_incr;
                     id_ex.md_start <= '0';
+                    id_ex.fence <= '0';
+                    id_ex.uop_cont <= '0';
+                    id_ex.uop_more <= '0';
                     id_ex.md_op <= (others => '0');
                     id_ex.memaccess <= memaccess_nop;
                     id_ex.memsize <= memsize_unknown;
@@ -949,6 +1812,9 @@ begin
                     id_ex.csr_op <= csr_nop;
                     -- Do not start the MD unit
                     id_ex.md_start <= '0';
+                    id_ex.fence <= '0';
+                    id_ex.uop_cont <= '0';
+                    id_ex.uop_more <= '0';
                     -- ECALL request reset
                     control.ecall_request <= '0';
                     -- EBREAK request reset
@@ -971,7 +1837,10 @@ begin
                     control.wfi_request <= '0';
                 else
                     -- Set all registers to default
-                    id_ex.pc <= if_id.pc;
+                    id_ex.pc <= decode_in.pc;
+                    id_ex.compressed <= decode_in.compressed;
+                    id_ex.uop_cont <= decode_in.uop_cont and decode_in.valid;
+                    id_ex.uop_more <= decode_in.uop_more and decode_in.valid;
                     id_ex.rd <= rd_v;
                     id_ex.rs1 <= rs1_v;
                     id_ex.rs2 <= rs2_v;
@@ -981,7 +1850,10 @@ begin
                     id_ex.isunsigned <= '0';
                     id_ex.alu_op <= alu_nop;
                     id_ex.pc_op <= pc_incr;
+                    id_ex.predict <= '0';
+                    id_ex.bubble <= '0';
                     id_ex.md_start <= '0';
+                    id_ex.fence <= '0';
                     id_ex.md_op <= (others => '0');
                     id_ex.memaccess <= memaccess_nop;
                     id_ex.memsize <= memsize_unknown;
@@ -997,6 +1869,20 @@ begin
                     -- If we flush the pipeline, don't execute the instruction
                     if control.flush = '1' or control.state = state_debugflush or control.state = state_debugflush2 then
                         null;
+                    -- Instruction fetched after a jump/branch predicted
+                    -- taken, don't execute. The PC is the target address.
+                    elsif decode_in.valid = '0' then
+                        -- A 32-bit instruction waits for its upper half
+                        if align.pending = '1' then
+                            id_ex.pc <= decode_in.pc;
+                        else
+                            id_ex.pc <= pc;
+                        end if;
+                        id_ex.bubble <= '1';
+                    -- Instruction needs the data of a fast load that has
+                    -- not arrived yet, don't execute and decode it again
+                    elsif control.load_hazard = '1' then
+                        id_ex.bubble <= '1';
                     else
                         case opcode_v is
                             -- LUI
@@ -1015,6 +1901,7 @@ begin
                             when "1101111" =>
                                 id_ex.alu_op <= alu_jal_jalr;
                                 id_ex.pc_op <= pc_loadoffset;
+                                id_ex.predict <= decode_in.predict;
                                 id_ex.rd_en <= '1';
                                 id_ex.imm <= imm_j_v;
                             -- JALR
@@ -1032,6 +1919,7 @@ begin
                                 -- Set the registers to compare. Comparison is handled by the ALU.
                                 id_ex.imm <= imm_b_v;
                                 id_ex.pc_op <= pc_branch;
+                                id_ex.predict <= decode_in.predict;
                                 case func3_v is
                                     when "000" => id_ex.alu_op <= alu_beq;
                                     when "001" => id_ex.alu_op <= alu_bne;
@@ -1315,12 +2203,17 @@ begin
                                             when '1' => id_ex.alu_op <= alu_divrem;
                                             when others => null;
                                         end case;
-                                        -- Hold the PC
-                                        id_ex.pc_op <= pc_hold;
                                         -- func3 contains the function
                                         id_ex.md_op <= func3_v;
-                                        -- Start multiply/divide/remainder
-                                        id_ex.md_start <= '1';
+                                        -- Multiply in the execute stage
+                                        if SINGLE_CYCLE_MULTIPLY and func3_v(2) = '0' then
+                                            id_ex.rd_en <= '1';
+                                        else
+                                            -- Hold the PC
+                                            id_ex.pc_op <= pc_hold;
+                                            -- Start multiply/divide/remainder
+                                            id_ex.md_start <= '1';
+                                        end if;
                                     else
                                         control.illegal_instruction_decode <= '1';
                                     end if;
@@ -1409,12 +2302,12 @@ begin
                                 case func3_v is
                                     when "000" =>
                                         -- ECALL/EBREAK/MRET/WFI
-                                        if I_instr_response.instr(31 downto 20) = "000000000000" then
+                                        if decode_in.instr(31 downto 20) = "000000000000" then
                                             -- ECALL
                                             control.ecall_request <= '1';
                                             id_ex.alu_op <= alu_trap;
                                             id_ex.pc_op <= pc_hold;
-                                        elsif I_instr_response.instr(31 downto 20) = "000000000001" then
+                                        elsif decode_in.instr(31 downto 20) = "000000000001" then
                                             -- EBREAK
                                             control.ebreak_request <= '1';
                                             -- Check the dcsr.ebreakm flag, if 0 then trap
@@ -1422,12 +2315,12 @@ begin
                                                 id_ex.alu_op <= alu_trap;
                                                 id_ex.pc_op <= pc_hold;
                                             end if;
-                                        elsif I_instr_response.instr(31 downto 20) = "001100000010" then
+                                        elsif decode_in.instr(31 downto 20) = "001100000010" then
                                             -- MRET
                                             id_ex.alu_op <= alu_mret;
                                             control.mret_request <= '1';
                                             id_ex.pc_op <= pc_load_mepc;
-                                        elsif I_instr_response.instr(31 downto 20) = "000100000101" then
+                                        elsif decode_in.instr(31 downto 20) = "000100000101" then
                                             -- WFI
                                             -- Only execute while not stepping
                                             control.wfi_request <= not control.isstepping;
@@ -1472,10 +2365,10 @@ begin
                                         id_ex.csr_immrs1 <= rs1_v; -- imm
                                     when "100" => -- MOP (may be operations)
                                         if HAVE_ZIMOP and
-                                           I_instr_response.instr(31) = '1' and
-                                           I_instr_response.instr(29 downto 28) = "00" and
-                                          (I_instr_response.instr(25) = '1' or 
-                                           I_instr_response.instr(25 downto 22) = "0111") then
+                                           decode_in.instr(31) = '1' and
+                                           decode_in.instr(29 downto 28) = "00" and
+                                          (decode_in.instr(25) = '1' or 
+                                           decode_in.instr(25 downto 22) = "0111") then
                                             id_ex.alu_op <= alu_mop;
                                             id_ex.rd_en <= '1';
                                          else
@@ -1488,8 +2381,8 @@ begin
                             -- FENCE, FENCE.I
                             when "0001111" =>
                                 if func3_v = "000" or func3_v = "001" then
-                                    -- Just ignore
-                                    null;
+                                    -- Wait until all posted stores are written
+                                    id_ex.fence <= boolean_to_std_logic(HAVE_STORE_BUFFER);
                                 else
                                     control.illegal_instruction_decode <= '1';
                                 end if;
@@ -1522,70 +2415,82 @@ begin
     -- onboard RAM blocks.
     --
     
+    -- The register bank selected by mxbank, bank 1 is the shadow bank
+    regbank <= 1 when csr_reg.mxbank(0) = '1' else 0;
+
     -- Generate register in onboard RAM blocks
     gen_regs_ram: if HAVE_REGISTERS_IN_RAM generate
         -- Registers: retire
         -- Do NOT include a reset, otherwise registers will be in ALM flip-flops
         -- Do NOT set x0 to all zero bits
         -- Next process is for the core register RS1
-        process (I_clk, I_areset, control, id_ex, I_dm_core_data_request) is
-        variable selrd_v : integer range 0 to NUMBER_OF_REGISTERS-1;
+        process (I_clk, I_areset, control, id_ex, I_dm_core_data_request, regbank) is
+        variable selrd_v : integer range 0 to NUMBER_OF_BANKS*NUMBER_OF_REGISTERS-1;
         begin
             if control.indebug = '1' then
-                selrd_v := to_integer(unsigned(I_dm_core_data_request.address(4 downto 0)));
+                selrd_v := regbank*NUMBER_OF_REGISTERS + to_integer(unsigned(I_dm_core_data_request.address(4 downto 0)));
             else
-                selrd_v := to_integer(unsigned(id_ex.rd));
+                selrd_v := regbank*NUMBER_OF_REGISTERS + to_integer(unsigned(id_ex.rd));
             end if;
             if rising_edge(I_clk) then
-                if control.stall = '0' and control.stall_on_trigger = '0' and id_ex.rd_en = '1' and control.trap_request = '0' then
+                if control.regwrite = '1' then
                     regs_rs1(selrd_v) <= id_ex.result;
-                elsif control.indebug = '1' and I_dm_core_data_request.writegpr = '1' and selrd_v /= 0 then
+                -- Fast load data, when the execute stage does not write
+                elsif lwb.pending = '1' then
+                    regs_rs1(lwb.sel) <= lwb.data;
+                elsif control.indebug = '1' and I_dm_core_data_request.writegpr = '1' and selrd_v /= regbank*NUMBER_OF_REGISTERS then
                     regs_rs1(selrd_v) <= I_dm_core_data_request.data;
                 end if;
                 if control.stall_on_trigger = '1' or control.stall = '1' or control.trap_request = '1' then
                     null;
                 else
-                    id_ex.rs1data <= regs_rs1(if_id.selrs1);
+                    id_ex.rs1data <= regs_rs1(regbank*NUMBER_OF_REGISTERS + if_id.selrs1);
                 end if;
             end if;
         end process;
         -- Next process is for the core register RS2
-        process (I_clk, I_areset, control, id_ex, I_dm_core_data_request) is
-        variable selrd_v : integer range 0 to NUMBER_OF_REGISTERS-1;
+        process (I_clk, I_areset, control, id_ex, I_dm_core_data_request, regbank) is
+        variable selrd_v : integer range 0 to NUMBER_OF_BANKS*NUMBER_OF_REGISTERS-1;
         begin
             if control.indebug = '1' then
-                selrd_v := to_integer(unsigned(I_dm_core_data_request.address(4 downto 0)));
+                selrd_v := regbank*NUMBER_OF_REGISTERS + to_integer(unsigned(I_dm_core_data_request.address(4 downto 0)));
             else
-                selrd_v := to_integer(unsigned(id_ex.rd));
+                selrd_v := regbank*NUMBER_OF_REGISTERS + to_integer(unsigned(id_ex.rd));
             end if;
             if rising_edge(I_clk) then
-                if control.stall = '0' and control.stall_on_trigger = '0' and id_ex.rd_en = '1' and control.trap_request = '0' then
+                if control.regwrite = '1' then
                     regs_rs2(selrd_v) <= id_ex.result;
-                elsif control.indebug = '1' and I_dm_core_data_request.writegpr = '1' and selrd_v /= 0 then
+                -- Fast load data, when the execute stage does not write
+                elsif lwb.pending = '1' then
+                    regs_rs2(lwb.sel) <= lwb.data;
+                elsif control.indebug = '1' and I_dm_core_data_request.writegpr = '1' and selrd_v /= regbank*NUMBER_OF_REGISTERS then
                     regs_rs2(selrd_v) <= I_dm_core_data_request.data;
                 end if;
                 if control.stall_on_trigger = '1' or control.stall = '1' or control.trap_request = '1' then
                     null;
                 else
-                    id_ex.rs2data <= regs_rs2(if_id.selrs2);
+                    id_ex.rs2data <= regs_rs2(regbank*NUMBER_OF_REGISTERS + if_id.selrs2);
                 end if;
             end if;
         end process;
         -- Next process is for the debug read.
         -- We can't use RS1 or RS2, otherwise the selected output is changed
         debuginramgen: if HAVE_OCD generate
-            process (I_clk, I_areset, control, id_ex, I_dm_core_data_request) is
-            variable selrd_v : integer range 0 to NUMBER_OF_REGISTERS-1;
+            process (I_clk, I_areset, control, id_ex, I_dm_core_data_request, regbank) is
+            variable selrd_v : integer range 0 to NUMBER_OF_BANKS*NUMBER_OF_REGISTERS-1;
             begin
                 if control.indebug = '1' then
-                    selrd_v := to_integer(unsigned(I_dm_core_data_request.address(4 downto 0)));
+                    selrd_v := regbank*NUMBER_OF_REGISTERS + to_integer(unsigned(I_dm_core_data_request.address(4 downto 0)));
                 else
-                    selrd_v := to_integer(unsigned(id_ex.rd));
+                    selrd_v := regbank*NUMBER_OF_REGISTERS + to_integer(unsigned(id_ex.rd));
                 end if;
                 if rising_edge(I_clk) then
-                    if control.stall = '0' and control.stall_on_trigger = '0' and id_ex.rd_en = '1' and control.trap_request = '0' then
+                    if control.regwrite = '1' then
                         regs_debug(selrd_v) <= id_ex.result;
-                    elsif control.indebug = '1' and I_dm_core_data_request.writegpr = '1' and selrd_v /= 0 then
+                    -- Fast load data, when the execute stage does not write
+                    elsif lwb.pending = '1' then
+                        regs_debug(lwb.sel) <= lwb.data;
+                    elsif control.indebug = '1' and I_dm_core_data_request.writegpr = '1' and selrd_v /= regbank*NUMBER_OF_REGISTERS then
                         regs_debug(selrd_v) <= I_dm_core_data_request.data;
                     end if;
                     data_from_gpr <= regs_debug(selrd_v);
@@ -1602,7 +2507,7 @@ begin
         -- Register: exec & retire
         -- Registers in ALM flip-flops, x0 (zero) hardwired to all 0.
         -- Registers are cleared on reset
-        process (I_clk, I_areset, control.indebug, id_ex.rd, I_instr_response.instr, I_dm_core_data_request.address) is
+        process (I_clk, I_areset, control.indebug, id_ex.rd, decode_in.instr, I_dm_core_data_request.address) is
         variable selrd_v : integer range 0 to NUMBER_OF_REGISTERS-1;
         begin
             if control.indebug = '1' then
@@ -1623,8 +2528,11 @@ begin
                     id_ex.rs2data <= (others => '0');
                     data_from_gpr <= (others => '0');
                 else
-                    if control.stall = '0' and control.stall_on_trigger = '0' and id_ex.rd_en = '1' and control.trap_request = '0' then
+                    if control.regwrite = '1' then
                         regs_debug(selrd_v) <= id_ex.result;
+                    -- Fast load data, when the execute stage does not write
+                    elsif lwb.pending = '1' then
+                        regs_debug(lwb.sel) <= lwb.data;
                     elsif control.indebug = '1' and I_dm_core_data_request.writegpr = '1' and selrd_v /= 0 then
                         regs_debug(selrd_v) <= I_dm_core_data_request.data;
                     end if;
@@ -1648,7 +2556,7 @@ begin
     --
     
     -- ALU
-    process (id_ex, control, ex_wb, md, csr_access, I_bus_response.data) is
+    process (id_ex, control, forward, md, csr_access, I_bus_response.data) is
     variable a_v, b_v, r_v, imm_v : data_type;
     variable al_v, bl_v : std_logic_vector(data_type'left+1 downto 0);
     variable signs_v : data_type;
@@ -1658,7 +2566,7 @@ begin
     
         -- Check if forwarding result is needed
         if control.forwarda = '1' then
-            a_v := ex_wb.rddata;
+            a_v := forward.rs1data;
         else
             a_v := id_ex.rs1data;
         end if;
@@ -1667,7 +2575,7 @@ begin
         if id_ex.isimm = '1' then
             b_v := id_ex.imm;
         elsif control.forwardb = '1' then
-            b_v := ex_wb.rddata;
+            b_v := forward.rs2data;
         else
             b_v := id_ex.rs2data;
         end if;
@@ -1697,6 +2605,7 @@ begin
         r_v := (others => '0');
         
         control.penalty <= '0';
+        bp.ex_taken <= '0';
         
         case id_ex.alu_op is
             -- No operation
@@ -1969,28 +2878,37 @@ begin
                 r_v := (others => '0');
                 r_v(7 downto 0) := I_bus_response.data(7 downto 0);
                 
-            -- Jumps and calls
+            -- Jumps and calls, penalty if not predicted
             when alu_jal_jalr =>
-                r_v := std_logic_vector(unsigned(id_ex.pc) + 4);
-                control.penalty <= '1';
+                if id_ex.compressed = '1' then
+                    r_v := std_logic_vector(unsigned(id_ex.pc) + 2);
+                else
+                    r_v := std_logic_vector(unsigned(id_ex.pc) + 4);
+                end if;
+                bp.ex_taken <= '1';
+                control.penalty <= not id_ex.predict;
                 
-            -- Branches
+            -- Branches, penalty if mispredicted
             when alu_beq =>
                 r_v := (others => '0');
                 r_v(0) := cmpeq_v;
-                control.penalty <= cmpeq_v;
+                bp.ex_taken <= cmpeq_v;
+                control.penalty <= cmpeq_v xor id_ex.predict;
             when alu_bne =>
                 r_v := (others => '0');
                 r_v(0) := not cmpeq_v;
-                control.penalty <= not cmpeq_v;
+                bp.ex_taken <= not cmpeq_v;
+                control.penalty <= not cmpeq_v xor id_ex.predict;
             when alu_blt | alu_bltu =>
                 r_v := (others => '0');
                 r_v(0) := cmplt_v;
-                control.penalty <= cmplt_v;
+                bp.ex_taken <= cmplt_v;
+                control.penalty <= cmplt_v xor id_ex.predict;
             when alu_bge | alu_bgeu =>
                 r_v := (others => '0');
                 r_v(0) := not cmplt_v;
-                control.penalty <= not cmplt_v;
+                bp.ex_taken <= not cmplt_v;
+                control.penalty <= not cmplt_v xor id_ex.predict;
                 
             -- Pass data from CSR
             when alu_csr =>
@@ -2014,71 +2932,113 @@ begin
 
     -- The MD unit, can be omitted by setting HAVE_MULDIV to false
     muldivgen: if HAVE_MULDIV generate
-        -- Multiplication Unit
-        -- Check start of multiplication and load registers
-        process (I_clk, I_areset, control, ex_wb, id_ex) is
-        variable a_v, b_v : data_type;
-        begin
-            -- Check if forwarding result is needed
-            if control.forwarda = '1' then
-                a_v := (ex_wb.rddata);
-            else
-                a_v := (id_ex.rs1data);
-            end if;
+        single_cycle_mul: if SINGLE_CYCLE_MULTIPLY generate
+            -- Single-cycle multiplier in the execute stage. The
+            -- synthesizer maps it on the DSP blocks. The multiplier
+            -- is combinational, not pipelined, so it has an impact
+            -- on the fmax.
+            process (control, forward, id_ex) is
+            variable a_v, b_v : data_type;
+            variable ra_v, rb_v : signed(32 downto 0);
+            begin
+                -- Check if forwarding result is needed
+                if control.forwarda = '1' then
+                    a_v := (forward.rs1data);
+                else
+                    a_v := (id_ex.rs1data);
+                end if;
+
+                if control.forwardb = '1' then
+                    b_v := (forward.rs2data);
+                else
+                    b_v := (id_ex.rs2data);
+                end if;
+
+                -- MULHSU and MULHU have an unsigned multiplier,
+                -- MULHU has an unsigned multiplicand
+                if id_ex.md_op(1) = '1' then
+                    if id_ex.md_op(0) = '1' then
+                        ra_v := signed('0' & a_v);
+                    else
+                        ra_v := signed(a_v(31) & a_v);
+                    end if;
+                    rb_v := signed('0' & b_v);
+                else
+                    ra_v := signed(a_v(31) & a_v);
+                    rb_v := signed(b_v(31) & b_v);
+                end if;
+                md.mul_rd_int <= ra_v * rb_v;
+            end process;
+            md.mul_ready <= '0';
+        end generate;
+
+        single_cycle_mul_not: if not SINGLE_CYCLE_MULTIPLY generate
+            -- Multiplication Unit
+            -- Check start of multiplication and load registers
+            process (I_clk, I_areset, control, forward, id_ex) is
+            variable a_v, b_v : data_type;
+            begin
+                -- Check if forwarding result is needed
+                if control.forwarda = '1' then
+                    a_v := (forward.rs1data);
+                else
+                    a_v := (id_ex.rs1data);
+                end if;
                 
-            if control.forwardb = '1' then
-                b_v := (ex_wb.rddata);
-            else
-                b_v := (id_ex.rs2data);
-            end if;
+                if control.forwardb = '1' then
+                    b_v := (forward.rs2data);
+                else
+                    b_v := (id_ex.rs2data);
+                end if;
         
-            if I_areset = '1' then
-                md.rdata_a <= (others => '0');
-                md.rdata_b <= (others => '0');
-                md.mul_running <= '0';
-            elsif rising_edge(I_clk) then
-                if I_sreset = '1' then
+                if I_areset = '1' then
                     md.rdata_a <= (others => '0');
                     md.rdata_b <= (others => '0');
                     md.mul_running <= '0';
-                else
-                    -- Clock in the multiplicand and multiplier
-                    -- In the Cyclone V, these are embedded registers
-                    -- in the DSP units.
-                    if id_ex.md_start = '1' and control.trap_request = '0' and control.stall_on_trigger = '0' and id_ex.md_op(2) = '0' then
-                        if id_ex.md_op(1) = '1' then
-                            if id_ex.md_op(0) = '1' then
-                                md.rdata_a <= '0' & unsigned(a_v);
+                elsif rising_edge(I_clk) then
+                    if I_sreset = '1' then
+                        md.rdata_a <= (others => '0');
+                        md.rdata_b <= (others => '0');
+                        md.mul_running <= '0';
+                    else
+                        -- Clock in the multiplicand and multiplier
+                        -- In the Cyclone V, these are embedded registers
+                        -- in the DSP units.
+                        if id_ex.md_start = '1' and control.trap_request = '0' and control.stall_on_trigger = '0' and id_ex.md_op(2) = '0' then
+                            if id_ex.md_op(1) = '1' then
+                                if id_ex.md_op(0) = '1' then
+                                    md.rdata_a <= '0' & unsigned(a_v);
+                                else
+                                    md.rdata_a <= a_v(31) & unsigned(a_v);
+                                end if;
+                                md.rdata_b <= '0' & unsigned(b_v);
                             else
                                 md.rdata_a <= a_v(31) & unsigned(a_v);
+                                md.rdata_b <= b_v(31) & unsigned(b_v);
                             end if;
-                            md.rdata_b <= '0' & unsigned(b_v);
-                        else
-                            md.rdata_a <= a_v(31) & unsigned(a_v);
-                            md.rdata_b <= b_v(31) & unsigned(b_v);
                         end if;
-                    end if;
-                    -- Only start when start seen and multiply
-                    md.mul_running <= id_ex.md_start and not control.trap_request and not control.stall_on_trigger and not id_ex.md_op(2);
-                end if; -- sreset
-            end if; -- posedge
-        end process;
+                        -- Only start when start seen and multiply
+                        md.mul_running <= id_ex.md_start and not control.trap_request and not control.stall_on_trigger and not id_ex.md_op(2);
+                    end if; -- sreset
+                end if; -- posedge
+            end process;
 
-        -- Do the multiplication
-        process(I_clk, I_areset) is
-        begin
-            if I_areset = '1' then
-                md.mul_rd_int <= (others => '0');
-            elsif rising_edge (I_clk) then
-                if I_sreset = '1' then
+            -- Do the multiplication
+            process(I_clk, I_areset) is
+            begin
+                if I_areset = '1' then
                     md.mul_rd_int <= (others => '0');
-                else
-                    -- Do the multiplication and store in embedded registers
-                    md.mul_rd_int <= signed(md.rdata_a) * signed(md.rdata_b);
-                end if; -- sreset
-            end if; -- posedge
-        end process;
-        md.mul_ready <= md.mul_running;
+                elsif rising_edge (I_clk) then
+                    if I_sreset = '1' then
+                        md.mul_rd_int <= (others => '0');
+                    else
+                        -- Do the multiplication and store in embedded registers
+                        md.mul_rd_int <= signed(md.rdata_a) * signed(md.rdata_b);
+                    end if; -- sreset
+                end if; -- posedge
+            end process;
+            md.mul_ready <= md.mul_running;
+        end generate;
 
         -- Output multiplier result
         process (md, id_ex) is
@@ -2090,26 +3050,26 @@ begin
             end if;
         end process;
 
-        fast_div: if FAST_DIVIDE generate
+        fast_div: if FAST_DIVIDE and not EARLY_DIVIDE generate
         -- The main divider process. The divider retires 2 bits
         -- at a time, hence 16 cycles are needed. We use a
         -- poor man's radix-4 subtraction unit. It is not the
         -- fastest hardware but the easiest to follow. Consider
         -- a SRT radix-4 divider.
-        process (I_clk, I_areset, control, ex_wb, id_ex) is
+        process (I_clk, I_areset, control, forward, id_ex) is
         variable a_v, b_v : data_type;
         variable div_running_v : std_logic;  
         variable count_v : integer range 0 to 16;
         begin 
             -- Check if forwarding result is needed
             if control.forwarda = '1' then
-                a_v := (ex_wb.rddata);
+                a_v := (forward.rs1data);
             else
                 a_v := (id_ex.rs1data);
             end if;
 
             if control.forwardb = '1' then
-                b_v := (ex_wb.rddata);
+                b_v := (forward.rs2data);
             else
                 b_v := (id_ex.rs2data);
             end if;
@@ -2216,22 +3176,152 @@ begin
         end process;
         end generate;
         
-        fast_div_not: if not FAST_DIVIDE generate
+        early_div: if EARLY_DIVIDE generate
+        -- Early-terminating divider. The divisor is aligned with
+        -- the most significant bit of the dividend, so only the
+        -- significant bits of the quotient are computed, one bit
+        -- per clock cycle. Division by zero, division by a power
+        -- of two and a dividend less than the divisor finish in
+        -- the first clock cycle.
+        process (I_clk, I_areset, control, forward, id_ex) is
+        variable a_v, b_v : data_type;
+        variable ua_v, ub_v : unsigned(31 downto 0);
+        variable za_v, zb_v : integer range 0 to 32;
+        variable div_running_v : std_logic;
+        variable count_v : integer range 0 to 32;
+        begin
+            -- Check if forwarding result is needed
+            if control.forwarda = '1' then
+                a_v := (forward.rs1data);
+            else
+                a_v := (id_ex.rs1data);
+            end if;
+
+            if control.forwardb = '1' then
+                b_v := (forward.rs2data);
+            else
+                b_v := (id_ex.rs2data);
+            end if;
+
+            if I_areset = '1' then
+                -- Reset everything
+                count_v := 0;
+                md_buf1 <= (others => '0');
+                md_buf2 <= (others => '0');
+                md.divisor <= (others => '0');
+                div_running_v := '0';
+                md.div_ready <= '0';
+                md.outsign <= '0';
+            elsif rising_edge(I_clk) then
+                if I_sreset = '1' then
+                    -- Reset everything
+                    count_v := 0;
+                    md_buf1 <= (others => '0');
+                    md_buf2 <= (others => '0');
+                    md.divisor <= (others => '0');
+                    div_running_v := '0';
+                    md.div_ready <= '0';
+                    md.outsign <= '0';
+                else
+                    -- If start and dividing...
+                    md.div_ready <= '0';
+                    if id_ex.md_start = '1' and id_ex.md_op(2) = '1' and control.trap_request = '0' and control.stall_on_trigger = '0' then
+                        div_running_v := '1';
+                        count_v := 0;
+                    end if;
+                    if div_running_v = '1' then
+                        if count_v = 0 then
+                            -- If signed divide, check for negative
+                            -- values and make them positive
+                            if id_ex.md_op(0) = '0' and a_v(31) = '1' then
+                                ua_v := unsigned(not a_v) + 1;
+                            else
+                                ua_v := unsigned(a_v);
+                            end if;
+                            if id_ex.md_op(0) = '0' and b_v(31) = '1' then
+                                ub_v := unsigned(not b_v) + 1;
+                            else
+                                ub_v := unsigned(b_v);
+                            end if;
+                            za_v := to_integer(unsigned(count_leading_zeros(std_logic_vector(ua_v))));
+                            zb_v := to_integer(unsigned(count_leading_zeros(std_logic_vector(ub_v))));
+                            -- Determine the result sign
+                            if (id_ex.md_op(0) = '0' and id_ex.md_op(1) = '0' and (a_v(31) /= b_v(31)) and b_v /= all_zeros_c) or (id_ex.md_op(0) = '0' and id_ex.md_op(1) = '1' and a_v(31) = '1') then
+                                md.outsign <= '1';
+                            else
+                                md.outsign <= '0';
+                            end if;
+                            -- Division by zero, quotient is all ones
+                            if ub_v = 0 then
+                                md_buf1 <= ua_v;
+                                md_buf2 <= (others => '1');
+                            -- Division by a power of two, just shift
+                            elsif (ub_v and (ub_v - 1)) = 0 then
+                                md_buf1 <= ua_v and (ub_v - 1);
+                                md_buf2 <= shift_right(ua_v, 31 - zb_v);
+                            -- Quotient is 0
+                            elsif ua_v < ub_v then
+                                md_buf1 <= ua_v;
+                                md_buf2 <= (others => '0');
+                            -- Align the divisor with the dividend
+                            else
+                                md_buf1 <= ua_v;
+                                md_buf2 <= (others => '0');
+                                md.divisor <= shift_left(ub_v, zb_v - za_v);
+                                -- Number of quotient bits
+                                count_v := zb_v - za_v + 1;
+                            end if;
+                            -- Signal ready one clock before
+                            if count_v <= 1 then
+                                md.div_ready <= '1';
+                            end if;
+                            if count_v = 0 then
+                                div_running_v := '0';
+                            end if;
+                        else
+                            -- Compute one quotient bit
+                            if md_buf1 >= md.divisor then
+                                md_buf1 <= md_buf1 - md.divisor;
+                                md_buf2 <= md_buf2(30 downto 0) & '1';
+                            else
+                                md_buf2 <= md_buf2(30 downto 0) & '0';
+                            end if;
+                            md.divisor <= '0' & md.divisor(31 downto 1);
+                            -- Signal ready one clock before
+                            if count_v = 2 then
+                                md.div_ready <= '1';
+                            end if;
+                            count_v := count_v - 1;
+                            if count_v = 0 then
+                                div_running_v := '0';
+                            end if;
+                        end if;
+                    end if;
+                end if; -- sreset
+            end if; -- posedge
+-- synthesis translate_off
+            -- Only to view in simulator
+            md.count <= count_v;
+-- synthesis translate_on
+        end process;
+        end generate;
+
+        fast_div_not: if not FAST_DIVIDE and not EARLY_DIVIDE generate
         -- Division unit, retires one bit at a time
-        process (I_clk, I_areset, control, ex_wb, id_ex) is
+        process (I_clk, I_areset, control, forward, id_ex) is
         variable a_v, b_v : data_type;
         variable div_running_v : std_logic;  
         variable count_v : integer range 0 to 32;
         begin
             -- Check if forwarding result is needed
             if control.forwarda = '1' then
-                a_v := (ex_wb.rddata);
+                a_v := (forward.rs1data);
             else
                 a_v := (id_ex.rs1data);
             end if;
                 
             if control.forwardb = '1' then
-                b_v := (ex_wb.rddata);
+                b_v := (forward.rs2data);
             else
                 b_v := (id_ex.rs2data);
             end if;
@@ -2364,7 +3454,7 @@ begin
                 if control.stall = '1' or control.stall_on_trigger = '1' then
                     null;
                 else
-                    ex_wb.rd_en <= id_ex.rd_en;
+                    ex_wb.rd_en <= id_ex.rd_en and not control.fast_load;
                     if id_ex.rd_en = '1' and control.trap_request = '0' then
                         ex_wb.rddata <= id_ex.result;
                         ex_wb.rd <= id_ex.rd;
@@ -2385,7 +3475,7 @@ begin
 
     -- !fast_mem: set up the registered memory interface
     fastmemnot: if not FAST_MEM generate
-        process (I_clk, I_areset, I_bus_response.ready, control, id_ex, ex_wb, I_dm_core_data_request) is
+        process (I_clk, I_areset, I_bus_response.ready, control, id_ex, forward, I_dm_core_data_request) is
         variable address_v : unsigned(31 downto 0);
         begin
             
@@ -2395,7 +3485,7 @@ begin
             -- Check if we need forward or not
             else
                 if control.forwarda = '1' then
-                    address_v := unsigned(ex_wb.rddata);
+                    address_v := unsigned(forward.rs1data);
                 else
                     address_v := unsigned(id_ex.rs1data);
                 end if;
@@ -2456,7 +3546,7 @@ begin
                     if control.indebug = '1' then
                         O_bus_request.data <= I_dm_core_data_request.data;
                     elsif control.forwardb = '1' then
-                        O_bus_request.data <= ex_wb.rddata;
+                        O_bus_request.data <= forward.rs2data;
                     else
                         O_bus_request.data <= id_ex.rs2data;
                     end if;
@@ -2470,7 +3560,7 @@ begin
 
     -- fast_mem: set up unregistered memory interface
     fastmem: if FAST_MEM generate
-        process (I_clk, I_areset, I_bus_response.ready, control, id_ex, ex_wb, I_dm_core_data_request) is
+        process (I_clk, I_areset, I_bus_response.ready, control, id_ex, forward, ld, I_dm_core_data_request) is
         variable address_v : unsigned(31 downto 0);
         begin
             
@@ -2480,7 +3570,7 @@ begin
             -- Check if we need forward or not
             else
                 if control.forwarda = '1' then
-                    address_v := unsigned(ex_wb.rddata);
+                    address_v := unsigned(forward.rs1data);
                 else
                     address_v := unsigned(id_ex.rs1data);
                 end if;
@@ -2528,12 +3618,189 @@ begin
             if control.indebug = '1' then
                 O_bus_request.data <= I_dm_core_data_request.data;
             elsif control.forwardb = '1' then
-                O_bus_request.data <= ex_wb.rddata;
+                O_bus_request.data <= forward.rs2data;
             else
                 O_bus_request.data <= id_ex.rs2data;
             end if;
+
+            -- Fast load outstanding, keep the address and size for
+            -- the response, the memory is not accessed again
+            if ld.busy = '1' then
+                O_bus_request.stb <= '0';
+                O_bus_request.acc <= memaccess_read;
+                O_bus_request.size <= ld.size;
+            end if;
         end process;
-        O_bus_request.addr <= csr_transfer.address_to_mtval;
+        O_bus_request.addr <= ld.addr when ld.busy = '1' else csr_transfer.address_to_mtval;
+    end generate;
+
+    --
+    -- Fast loads
+    --
+    -- With FAST_MEM, a naturally aligned load from ROM, boot ROM or RAM
+    -- completes in the execute stage. The load data arrives in the next
+    -- clock cycle while the next instruction is executed. The data is
+    -- kept in the load write back buffer, forwarded to the execute stage
+    -- and written to the registers in the first clock cycle the execute
+    -- stage does not write a register. An instruction that needs the load
+    -- data or accesses the memory is held in the decode stage until the
+    -- load data has arrived. Loads from I/O take the normal path.
+    fastloadgen : if FAST_LOAD and FAST_MEM generate
+        -- Determine if the load in the execute stage is a fast load
+        process (control, id_ex, ld, csr_transfer.address_to_mtval, I_store_buffer_empty) is
+        variable nibble_v : memory_high_nibble;
+        variable region_v, aligned_v : boolean;
+        begin
+            nibble_v := csr_transfer.address_to_mtval(31 downto 28);
+            region_v := nibble_v = ROM_HIGH_NIBBLE or nibble_v = RAM_HIGH_NIBBLE or
+                        (nibble_v = BOOT_HIGH_NIBBLE and HAVE_BOOTLOADER_ROM);
+            case id_ex.memsize is
+                when memsize_word => aligned_v := csr_transfer.address_to_mtval(1 downto 0) = "00";
+                when memsize_halfword => aligned_v := csr_transfer.address_to_mtval(0) = '0';
+                when memsize_byte => aligned_v := true;
+                when others => aligned_v := false;
+            end case;
+            if control.state = state_exec and id_ex.memaccess = memaccess_read and region_v and aligned_v and
+               ld.busy = '0' and I_store_buffer_empty = '1' and control.trap_request = '0' and
+               control.stall_on_trigger = '0' then
+                control.fast_load <= '1';
+            else
+                control.fast_load <= '0';
+            end if;
+        end process;
+
+        -- Hold the instruction in the decode stage if it needs the load
+        -- data or the memory while the load data has not arrived
+        process (control.fast_load, id_ex, ld, decode_in, I_bus_response.ready) is
+        variable opcode_v : std_logic_vector(6 downto 0);
+        variable rs1_v, rs2_v : reg_type;
+        variable users1_v, users2_v, ismem_v : boolean;
+        begin
+            opcode_v := decode_in.instr(6 downto 0);
+            rs1_v := decode_in.instr(19 downto 15);
+            rs2_v := decode_in.instr(24 downto 20);
+            -- LUI, AUIPC and JAL have no source register
+            users1_v := opcode_v /= "0110111" and opcode_v /= "0010111" and opcode_v /= "1101111";
+            -- Register-register, stores and branches use RS2
+            users2_v := opcode_v = "0110011" or opcode_v = "0100011" or opcode_v = "1100011";
+            -- Loads and stores
+            ismem_v := opcode_v = "0000011" or opcode_v = "0100011";
+
+            control.load_hazard <= '0';
+            if decode_in.valid = '1' then
+                -- Fast load is started now
+                if control.fast_load = '1' and
+                   (ismem_v or (id_ex.rd_en = '1' and ((users1_v and rs1_v = id_ex.rd) or (users2_v and rs2_v = id_ex.rd)))) then
+                    control.load_hazard <= '1';
+                end if;
+                -- Fast load data has not arrived
+                if ld.busy = '1' and I_bus_response.ready = '0' and
+                   (ismem_v or (ld.en = '1' and ((users1_v and rs1_v = ld.rd) or (users2_v and rs2_v = ld.rd)))) then
+                    control.load_hazard <= '1';
+                end if;
+            end if;
+        end process;
+
+        -- Load data from the memory, sign or zero extended
+        process (ld.alu_op, I_bus_response.data) is
+        variable r_v : data_type;
+        begin
+            r_v := (others => '0');
+            case ld.alu_op is
+                when alu_lh =>
+                    r_v := (others => I_bus_response.data(15));
+                    r_v(15 downto 0) := I_bus_response.data(15 downto 0);
+                when alu_lhu =>
+                    r_v(15 downto 0) := I_bus_response.data(15 downto 0);
+                when alu_lb =>
+                    r_v := (others => I_bus_response.data(7));
+                    r_v(7 downto 0) := I_bus_response.data(7 downto 0);
+                when alu_lbu =>
+                    r_v(7 downto 0) := I_bus_response.data(7 downto 0);
+                when others =>
+                    r_v := I_bus_response.data;
+            end case;
+            ld.data <= r_v;
+        end process;
+        -- Store load data if no younger instruction has written the register
+        ld.capture <= '1' when ld.busy = '1' and I_bus_response.ready = '1' and ld.en = '1' and ld.kill = '0' and
+                               not (control.regwrite = '1' and id_ex.rd = ld.rd)
+                          else '0';
+
+        process (I_clk, I_areset) is
+        begin
+            if I_areset = '1' then
+                ld.busy <= '0';
+                ld.kill <= '0';
+                lwb.valid <= '0';
+                lwb.pending <= '0';
+            elsif rising_edge(I_clk) then
+                if I_sreset = '1' then
+                    ld.busy <= '0';
+                    ld.kill <= '0';
+                    lwb.valid <= '0';
+                    lwb.pending <= '0';
+                else
+                    -- Start or end of a fast load
+                    if control.fast_load = '1' then
+                        ld.busy <= '1';
+                        ld.en <= id_ex.rd_en;
+                        ld.kill <= '0';
+                        ld.rd <= id_ex.rd;
+                        ld.alu_op <= id_ex.alu_op;
+                        ld.addr <= csr_transfer.address_to_mtval;
+                        ld.size <= id_ex.memsize;
+                    elsif ld.busy = '1' then
+                        if I_bus_response.ready = '1' then
+                            ld.busy <= '0';
+                        -- A younger instruction writes the destination register
+                        elsif control.regwrite = '1' and id_ex.rd = ld.rd then
+                            ld.kill <= '1';
+                        end if;
+                    end if;
+                    -- The buffer is written to the registers
+                    if control.regwrite = '0' then
+                        lwb.pending <= '0';
+                    end if;
+                    -- A younger instruction writes the register or the
+                    -- debugger may access the registers
+                    if (control.regwrite = '1' and id_ex.rd = lwb.rd) or
+                       (control.indebug = '1' and lwb.pending = '0') then
+                        lwb.valid <= '0';
+                        lwb.pending <= '0';
+                    end if;
+                    -- Store the load data
+                    if ld.capture = '1' then
+                        lwb.valid <= '1';
+                        lwb.pending <= '1';
+                        lwb.rd <= ld.rd;
+                        lwb.bank <= csr_reg.mxbank(0);
+                        lwb.sel <= regbank*NUMBER_OF_REGISTERS + to_integer(unsigned(ld.rd));
+                        lwb.data <= ld.data;
+                    end if;
+                end if;
+            end if;
+        end process;
+    end generate;
+
+    fastloadgennot : if not (FAST_LOAD and FAST_MEM) generate
+        control.fast_load <= '0';
+        control.load_hazard <= '0';
+        ld.busy <= '0';
+        ld.en <= '0';
+        ld.kill <= '0';
+        ld.rd <= (others => '0');
+        ld.alu_op <= alu_unknown;
+        ld.addr <= (others => '0');
+        ld.size <= memsize_unknown;
+        ld.capture <= '0';
+        ld.data <= (others => '0');
+        lwb.valid <= '0';
+        lwb.pending <= '0';
+        lwb.rd <= (others => '0');
+        lwb.bank <= '0';
+        lwb.sel <= 0;
+        lwb.data <= (others => '0');
     end generate;
 
 
@@ -2549,11 +3816,11 @@ begin
     csr_access.immrs1 <= id_ex.csr_immrs1;
     
 --    -- Set the address of the CSR register
-    process (control.forwarda, id_ex.rs1data, ex_wb.rddata) is
+    process (control.forwarda, id_ex.rs1data, forward.rs1data) is
     begin
         -- Check if we need forward or not
         if control.forwarda = '1' then
-            csr_access.dataout <= ex_wb.rddata;
+            csr_access.dataout <= forward.rs1data;
         else
             csr_access.dataout <= id_ex.rs1data;
         end if;
@@ -2561,69 +3828,108 @@ begin
     end process;
     
     
+    --
+    -- Events for the HPM counters, see the HPM_EVENTS constant.
+    -- Accesses outside ROM, boot ROM and RAM are counted as I/O.
+    --
+    process (control, id_ex, md, I_bus_response.ready, csr_transfer.address_to_mtval) is
+    variable nibble_v : memory_high_nibble;
+    variable io_v : boolean;
+    begin
+        nibble_v := csr_transfer.address_to_mtval(31 downto 28);
+        io_v := not (nibble_v = ROM_HIGH_NIBBLE or nibble_v = RAM_HIGH_NIBBLE or
+                     (nibble_v = BOOT_HIGH_NIBBLE and HAVE_BOOTLOADER_ROM));
+
+        -- Jumps/branches mispredicted (pipeline flush)
+        hpm_events(0) <= control.penalty;
+        -- Stall cycles
+        hpm_events(1) <= control.stall;
+        -- Stores
+        hpm_events(2) <= boolean_to_std_logic(id_ex.memaccess = memaccess_write and I_bus_response.ready = '1');
+        -- Loads
+        hpm_events(3) <= boolean_to_std_logic((id_ex.memaccess = memaccess_read and I_bus_response.ready = '1') or control.fast_load = '1');
+        -- ECALLs
+        hpm_events(4) <= control.ecall_request;
+        -- EBREAKs
+        hpm_events(5) <= control.ebreak_request;
+        -- Multiplications/divisions, a single-cycle multiply is
+        -- counted when it retires, the MD unit is not used
+        hpm_events(6) <= md.ready or (control.instret and
+                         boolean_to_std_logic(SINGLE_CYCLE_MULTIPLY and HAVE_MULDIV and id_ex.alu_op = alu_multiply));
+        -- Jumps/branches correctly predicted
+        hpm_events(7) <= control.predicted;
+        -- Pipeline flush cycles
+        hpm_events(8) <= control.flush;
+        -- WFI cycles
+        hpm_events(9) <= boolean_to_std_logic(control.state = state_wfi);
+        -- Traps taken
+        hpm_events(10) <= control.trap_request and not control.stall_on_trigger;
+        -- Trap entry and MRET cycles
+        hpm_events(11) <= boolean_to_std_logic(control.state = state_trap or control.state = state_trap2 or
+                                               control.state = state_trap3 or control.state = state_mret or
+                                               control.state = state_mret2);
+        -- Interrupts taken
+        hpm_events(12) <= control.trap_request and not control.stall_on_trigger and control.trap_mcause(31);
+        -- I/O accesses
+        hpm_events(13) <= boolean_to_std_logic(id_ex.memaccess /= memaccess_nop and I_bus_response.ready = '1' and io_v);
+        -- I/O wait cycles
+        hpm_events(14) <= boolean_to_std_logic(control.state = state_mem and I_bus_response.ready = '0' and io_v);
+        -- ROM/RAM wait cycles
+        hpm_events(15) <= boolean_to_std_logic(control.state = state_mem and I_bus_response.ready = '0' and not io_v);
+        -- Multiply/divide busy cycles
+        hpm_events(16) <= boolean_to_std_logic(control.state = state_md);
+        -- Load-use hazard cycles
+        hpm_events(17) <= control.load_hazard;
+        -- Instructions retired
+        hpm_events(18) <= control.instret;
+        -- Clock cycles
+        hpm_events(19) <= '1';
+        -- MRETs
+        hpm_events(20) <= boolean_to_std_logic(control.state = state_mret);
+    end process;
+
+    -- Counter overflow interrupt (Sscofpmf), pending while an
+    -- overflow flag (OF) is set
+    hpm_overflow <= '1' when HAVE_ZIHPM and
+                             (csr_reg.mhpmevent3(31) = '1' or csr_reg.mhpmevent4(31) = '1' or
+                              csr_reg.mhpmevent5(31) = '1' or csr_reg.mhpmevent6(31) = '1' or
+                              csr_reg.mhpmevent7(31) = '1' or csr_reg.mhpmevent8(31) = '1' or
+                              csr_reg.mhpmevent9(31) = '1')
+                    else '0';
+
+    -- Overflow flags of the counters
+    csr_reg.scountovf(2 downto 0) <= (others => '0');
+    csr_reg.scountovf(3) <= csr_reg.mhpmevent3(31);
+    csr_reg.scountovf(4) <= csr_reg.mhpmevent4(31);
+    csr_reg.scountovf(5) <= csr_reg.mhpmevent5(31);
+    csr_reg.scountovf(6) <= csr_reg.mhpmevent6(31);
+    csr_reg.scountovf(7) <= csr_reg.mhpmevent7(31);
+    csr_reg.scountovf(8) <= csr_reg.mhpmevent8(31);
+    csr_reg.scountovf(9) <= csr_reg.mhpmevent9(31);
+    csr_reg.scountovf(31 downto 10) <= (others => '0');
+
     --
     -- CSR - Control and Status Registers
     --
     
     process (I_clk, I_areset, csr_access, csr_reg,
              control, id_ex, I_bus_response.ready, md,
-             I_dm_core_data_request, pc) is
+             I_dm_core_data_request, pc, hpm_events) is
     variable csr_addr_v : integer range 0 to csr_size-1;
     variable event3_v, event4_v, event5_v, event6_v, event7_v, event8_v, event9_v : boolean;
     variable csr_content_v : data_type;
     begin
     
-        -- Event generators
+        -- Event generators, a counter counts if one of the selected
+        -- events occurs and counting is not inhibited by MINH (bit 30)
         if HAVE_ZIHPM then
-            event3_v := (csr_reg.mhpmevent3(0) = '1' and control.penalty = '1') or
-                        (csr_reg.mhpmevent3(1) = '1' and control.stall = '1') or
-                        (csr_reg.mhpmevent3(2) = '1' and id_ex.memaccess = memaccess_write and I_bus_response.ready = '1') or
-                        (csr_reg.mhpmevent3(3) = '1' and id_ex.memaccess = memaccess_read and I_bus_response.ready = '1') or
-                        (csr_reg.mhpmevent3(4) = '1' and control.ecall_request = '1') or
-                        (csr_reg.mhpmevent3(5) = '1' and control.ebreak_request = '1') or
-                        (csr_reg.mhpmevent3(6) = '1' and md.ready = '1');
-            event4_v := (csr_reg.mhpmevent4(0) = '1' and control.penalty = '1') or
-                        (csr_reg.mhpmevent4(1) = '1' and control.stall = '1') or
-                        (csr_reg.mhpmevent4(2) = '1' and id_ex.memaccess = memaccess_write and I_bus_response.ready = '1') or
-                        (csr_reg.mhpmevent4(3) = '1' and id_ex.memaccess = memaccess_read and I_bus_response.ready = '1') or
-                        (csr_reg.mhpmevent4(4) = '1' and control.ecall_request = '1') or
-                        (csr_reg.mhpmevent4(5) = '1' and control.ebreak_request = '1') or
-                        (csr_reg.mhpmevent4(6) = '1' and md.ready = '1');
-            event5_v := (csr_reg.mhpmevent5(0) = '1' and control.penalty = '1') or
-                        (csr_reg.mhpmevent5(1) = '1' and control.stall = '1') or
-                        (csr_reg.mhpmevent5(2) = '1' and id_ex.memaccess = memaccess_write and I_bus_response.ready = '1') or
-                        (csr_reg.mhpmevent5(3) = '1' and id_ex.memaccess = memaccess_read and I_bus_response.ready = '1') or
-                        (csr_reg.mhpmevent5(4) = '1' and control.ecall_request = '1') or
-                        (csr_reg.mhpmevent5(5) = '1' and control.ebreak_request = '1') or
-                        (csr_reg.mhpmevent5(6) = '1' and md.ready = '1');
-            event6_v := (csr_reg.mhpmevent6(0) = '1' and control.penalty = '1') or
-                        (csr_reg.mhpmevent6(1) = '1' and control.stall = '1') or
-                        (csr_reg.mhpmevent6(2) = '1' and id_ex.memaccess = memaccess_write and I_bus_response.ready = '1') or
-                        (csr_reg.mhpmevent6(3) = '1' and id_ex.memaccess = memaccess_read and I_bus_response.ready = '1') or
-                        (csr_reg.mhpmevent6(4) = '1' and control.ecall_request = '1') or
-                        (csr_reg.mhpmevent6(5) = '1' and control.ebreak_request = '1') or
-                        (csr_reg.mhpmevent6(6) = '1' and md.ready = '1');
-            event7_v := (csr_reg.mhpmevent7(0) = '1' and control.penalty = '1') or
-                        (csr_reg.mhpmevent7(1) = '1' and control.stall = '1') or
-                        (csr_reg.mhpmevent7(2) = '1' and id_ex.memaccess = memaccess_write and I_bus_response.ready = '1') or
-                        (csr_reg.mhpmevent7(3) = '1' and id_ex.memaccess = memaccess_read and I_bus_response.ready = '1') or
-                        (csr_reg.mhpmevent7(4) = '1' and control.ecall_request = '1') or
-                        (csr_reg.mhpmevent7(5) = '1' and control.ebreak_request = '1') or
-                        (csr_reg.mhpmevent7(6) = '1' and md.ready = '1');
-            event8_v := (csr_reg.mhpmevent8(0) = '1' and control.penalty = '1') or
-                        (csr_reg.mhpmevent8(1) = '1' and control.stall = '1') or
-                        (csr_reg.mhpmevent8(2) = '1' and id_ex.memaccess = memaccess_write and I_bus_response.ready = '1') or
-                        (csr_reg.mhpmevent8(3) = '1' and id_ex.memaccess = memaccess_read and I_bus_response.ready = '1') or
-                        (csr_reg.mhpmevent8(4) = '1' and control.ecall_request = '1') or
-                        (csr_reg.mhpmevent8(5) = '1' and control.ebreak_request = '1') or
-                        (csr_reg.mhpmevent8(6) = '1' and md.ready = '1');
-            event9_v := (csr_reg.mhpmevent9(0) = '1' and control.penalty = '1') or
-                        (csr_reg.mhpmevent9(1) = '1' and control.stall = '1') or
-                        (csr_reg.mhpmevent9(2) = '1' and id_ex.memaccess = memaccess_write and I_bus_response.ready = '1') or
-                        (csr_reg.mhpmevent9(3) = '1' and id_ex.memaccess = memaccess_read and I_bus_response.ready = '1') or
-                        (csr_reg.mhpmevent9(4) = '1' and control.ecall_request = '1') or
-                        (csr_reg.mhpmevent9(5) = '1' and control.ebreak_request = '1') or
-                        (csr_reg.mhpmevent9(6) = '1' and md.ready = '1');
+            event3_v := unsigned(csr_reg.mhpmevent3(HPM_EVENTS-1 downto 0) and hpm_events) /= 0 and csr_reg.mhpmevent3(30) = '0';
+            event4_v := unsigned(csr_reg.mhpmevent4(HPM_EVENTS-1 downto 0) and hpm_events) /= 0 and csr_reg.mhpmevent4(30) = '0';
+            event5_v := unsigned(csr_reg.mhpmevent5(HPM_EVENTS-1 downto 0) and hpm_events) /= 0 and csr_reg.mhpmevent5(30) = '0';
+            event6_v := unsigned(csr_reg.mhpmevent6(HPM_EVENTS-1 downto 0) and hpm_events) /= 0 and csr_reg.mhpmevent6(30) = '0';
+            event7_v := unsigned(csr_reg.mhpmevent7(HPM_EVENTS-1 downto 0) and hpm_events) /= 0 and csr_reg.mhpmevent7(30) = '0';
+            event8_v := unsigned(csr_reg.mhpmevent8(HPM_EVENTS-1 downto 0) and hpm_events) /= 0 and csr_reg.mhpmevent8(30) = '0';
+            event9_v := unsigned(csr_reg.mhpmevent9(HPM_EVENTS-1 downto 0) and hpm_events) /= 0 and csr_reg.mhpmevent9(30) = '0';
         else
             event3_v := false;
             event4_v := false;
@@ -2830,8 +4136,14 @@ begin
              (csr_addr_v = tdata3_addr and HAVE_OCD) or
              (csr_addr_v = tinfo_addr and HAVE_OCD) or
              
+             (csr_addr_v = mintthresh_addr and HAVE_CLIC) or
+             (csr_addr_v = mintstatus_addr and HAVE_CLIC) or
+             (csr_addr_v = mxbank_addr and NUMBER_OF_BANKS = 2) or
+             (csr_addr_v = scountovf_addr and HAVE_ZIHPM) or
+             
               csr_addr_v = mxhw_addr or
-              csr_addr_v = mxspeed_addr then
+              csr_addr_v = mxspeed_addr or
+              csr_addr_v = mxhw2_addr then
             control.illegal_instruction_csr <= '0';
         else 
             control.illegal_instruction_csr <= '1';
@@ -2905,11 +4217,16 @@ begin
             when dcsr_addr          => csr_access.datain <= csr_reg.dcsr;
             when dpc_addr           => csr_access.datain <= csr_reg.dpc;
             when tselect_addr       => csr_access.datain <= csr_reg.tselect;
-            when tdata1_addr        => csr_access.datain <= csr_reg.tdata1;
-            when tdata2_addr        => csr_access.datain <= csr_reg.tdata2;
+            when tdata1_addr        => csr_access.datain <= csr_reg.tdata1(tsel);
+            when tdata2_addr        => csr_access.datain <= csr_reg.tdata2(tsel);
             when tinfo_addr         => csr_access.datain <= csr_reg.tinfo;
             when mxhw_addr          => csr_access.datain <= csr_reg.mxhw;
             when mxspeed_addr       => csr_access.datain <= csr_reg.mxspeed;
+            when mxhw2_addr         => csr_access.datain <= csr_reg.mxhw2;
+            when mintthresh_addr    => csr_access.datain <= csr_reg.mintthresh;
+            when mintstatus_addr    => csr_access.datain <= csr_reg.mintstatus;
+            when mxbank_addr        => csr_access.datain <= csr_reg.mxbank;
+            when scountovf_addr     => csr_access.datain <= csr_reg.scountovf;
             when others             => csr_access.datain <= (others => '0');
         end case;
     
@@ -2953,8 +4270,14 @@ begin
             csr_reg.mhpmevent9 <= (others => '0');
             csr_reg.dcsr <= (others => '0');
             csr_reg.dpc <= (others => '0');
-            csr_reg.tdata1 <= (others => '0');
-            csr_reg.tdata2 <= (others => '0');
+            csr_reg.tselect <= (others => '0');
+            csr_reg.tdata1 <= (others => (others => '0'));
+            csr_reg.tdata2 <= (others => (others => '0'));
+            csr_reg.mintthresh <= (others => '0');
+            csr_reg.mintstatus <= (others => '0');
+            csr_reg.mxbank <= (others => '0');
+            csr_transfer.clic_vector <= (others => '0');
+            control.clic_shv <= '0';
             control.nmi_lockout <= '0';
         elsif rising_edge(I_clk) then
             if I_Sreset = '1' then
@@ -2995,8 +4318,14 @@ begin
                 csr_reg.mhpmevent9 <= (others => '0');
                 csr_reg.dcsr <= (others => '0');
                 csr_reg.dpc <= (others => '0');
-                csr_reg.tdata1 <= (others => '0');
-                csr_reg.tdata2 <= (others => '0');
+                csr_reg.tselect <= (others => '0');
+                csr_reg.tdata1 <= (others => (others => '0'));
+                csr_reg.tdata2 <= (others => (others => '0'));
+                csr_reg.mintthresh <= (others => '0');
+                csr_reg.mintstatus <= (others => '0');
+                csr_reg.mxbank <= (others => '0');
+                csr_transfer.clic_vector <= (others => '0');
+                control.clic_shv <= '0';
                 control.nmi_lockout <= '0';
             else
                 --  Do we count cycles?
@@ -3024,6 +4353,10 @@ begin
                             csr_reg.mhpmcounter3 <= std_logic_vector(unsigned(csr_reg.mhpmcounter3) + 1);
                             if csr_reg.mhpmcounter3 = all_ones_c then
                                 csr_reg.mhpmcounter3h <= std_logic_vector(unsigned(csr_reg.mhpmcounter3h) + 1);
+                                -- The 40-bit counter overflows, set OF
+                                if csr_reg.mhpmcounter3h(7 downto 0) = x"ff" then
+                                    csr_reg.mhpmevent3(31) <= '1';
+                                end if;
                             end if;
                         end if;
                     end if;
@@ -3033,6 +4366,10 @@ begin
                             csr_reg.mhpmcounter4 <= std_logic_vector(unsigned(csr_reg.mhpmcounter4) + 1);
                             if csr_reg.mhpmcounter4 = all_ones_c then
                                 csr_reg.mhpmcounter4h <= std_logic_vector(unsigned(csr_reg.mhpmcounter4h) + 1);
+                                -- The 40-bit counter overflows, set OF
+                                if csr_reg.mhpmcounter4h(7 downto 0) = x"ff" then
+                                    csr_reg.mhpmevent4(31) <= '1';
+                                end if;
                             end if;
                         end if;
                     end if;
@@ -3042,6 +4379,10 @@ begin
                             csr_reg.mhpmcounter5 <= std_logic_vector(unsigned(csr_reg.mhpmcounter5) + 1);
                             if csr_reg.mhpmcounter5 = all_ones_c then
                                 csr_reg.mhpmcounter5h <= std_logic_vector(unsigned(csr_reg.mhpmcounter5h) + 1);
+                                -- The 40-bit counter overflows, set OF
+                                if csr_reg.mhpmcounter5h(7 downto 0) = x"ff" then
+                                    csr_reg.mhpmevent5(31) <= '1';
+                                end if;
                             end if;
                         end if;
                     end if;
@@ -3051,6 +4392,10 @@ begin
                             csr_reg.mhpmcounter6 <= std_logic_vector(unsigned(csr_reg.mhpmcounter6) + 1);
                             if csr_reg.mhpmcounter6 = all_ones_c then
                                 csr_reg.mhpmcounter6h <= std_logic_vector(unsigned(csr_reg.mhpmcounter6h) + 1);
+                                -- The 40-bit counter overflows, set OF
+                                if csr_reg.mhpmcounter6h(7 downto 0) = x"ff" then
+                                    csr_reg.mhpmevent6(31) <= '1';
+                                end if;
                             end if;
                         end if;
                     end if;
@@ -3060,6 +4405,10 @@ begin
                             csr_reg.mhpmcounter7 <= std_logic_vector(unsigned(csr_reg.mhpmcounter7) + 1);
                             if csr_reg.mhpmcounter7 = all_ones_c then
                                 csr_reg.mhpmcounter7h <= std_logic_vector(unsigned(csr_reg.mhpmcounter7h) + 1);
+                                -- The 40-bit counter overflows, set OF
+                                if csr_reg.mhpmcounter7h(7 downto 0) = x"ff" then
+                                    csr_reg.mhpmevent7(31) <= '1';
+                                end if;
                             end if;
                         end if;
                     end if;
@@ -3069,6 +4418,10 @@ begin
                             csr_reg.mhpmcounter8 <= std_logic_vector(unsigned(csr_reg.mhpmcounter8) + 1);
                             if csr_reg.mhpmcounter8 = all_ones_c then
                                 csr_reg.mhpmcounter8h <= std_logic_vector(unsigned(csr_reg.mhpmcounter8h) + 1);
+                                -- The 40-bit counter overflows, set OF
+                                if csr_reg.mhpmcounter8h(7 downto 0) = x"ff" then
+                                    csr_reg.mhpmevent8(31) <= '1';
+                                end if;
                             end if;
                         end if;
                     end if;
@@ -3078,6 +4431,10 @@ begin
                             csr_reg.mhpmcounter9 <= std_logic_vector(unsigned(csr_reg.mhpmcounter9) + 1);
                             if csr_reg.mhpmcounter9 = all_ones_c then
                                 csr_reg.mhpmcounter9h <= std_logic_vector(unsigned(csr_reg.mhpmcounter9h) + 1);
+                                -- The 40-bit counter overflows, set OF
+                                if csr_reg.mhpmcounter9h(7 downto 0) = x"ff" then
+                                    csr_reg.mhpmevent9(31) <= '1';
+                                end if;
                             end if;
                         end if;
                     end if;
@@ -3120,8 +4477,11 @@ begin
                         when mepc_addr => csr_content_v := csr_reg.mepc;
                         when mcause_addr => csr_content_v := csr_reg.mcause;
                         when mtval_addr => csr_content_v := csr_reg.mtval;
-                        when tdata1_addr => csr_content_v := csr_reg.tdata1;
-                        when tdata2_addr => csr_content_v := csr_reg.tdata2;
+                        when mintthresh_addr => csr_content_v := csr_reg.mintthresh;
+                        when mxbank_addr => csr_content_v := csr_reg.mxbank;
+                        when tselect_addr => csr_content_v := csr_reg.tselect;
+                        when tdata1_addr => csr_content_v := csr_reg.tdata1(tsel);
+                        when tdata2_addr => csr_content_v := csr_reg.tdata2(tsel);
                         when others => csr_content_v := (others => '-');
                     end case;
                     -- Do the operation
@@ -3179,8 +4539,15 @@ begin
                         when mepc_addr => csr_reg.mepc <= csr_content_v;
                         when mcause_addr => csr_reg.mcause <= csr_content_v;
                         when mtval_addr => csr_reg.mtval <= csr_content_v;
-                        when tdata1_addr => csr_reg.tdata1 <= csr_content_v;
-                        when tdata2_addr => csr_reg.tdata2 <= csr_content_v;
+                        when mintthresh_addr => csr_reg.mintthresh <= csr_content_v;
+                        when mxbank_addr => csr_reg.mxbank <= csr_content_v;
+                        when tselect_addr =>
+                            -- Only existing triggers can be selected
+                            if unsigned(csr_content_v) < OCD_TRIGGERS then
+                                csr_reg.tselect <= csr_content_v;
+                            end if;
+                        when tdata1_addr => csr_reg.tdata1(tsel) <= csr_content_v;
+                        when tdata2_addr => csr_reg.tdata2(tsel) <= csr_content_v;
                         when others => null;
                     end case;
                 end if;
@@ -3190,7 +4557,11 @@ begin
                 if csr_reg.dcsr_cause(3) = '1' and HAVE_OCD then
                     csr_reg.dcsr(8 downto 6) <= csr_reg.dcsr_cause(2 downto 0);
                     if csr_reg.dcsr_cause(2 downto 0) = "010" then
-                        csr_reg.tdata1(22) <= '1';  -- hit0
+                        for i in 0 to OCD_TRIGGERS-1 loop
+                            if trig_fired(i) = '1' then
+                                csr_reg.tdata1(i)(22) <= '1';  -- hit0
+                            end if;
+                        end loop;
                     end if;
                 end if;
                 -- If a halt/break/step, load DPC with PC
@@ -3234,17 +4605,28 @@ begin
                         when mepc_addr => csr_reg.mepc <= I_dm_core_data_request.data;
                         when mcause_addr => csr_reg.mcause <= I_dm_core_data_request.data;
                         when mtval_addr => csr_reg.mtval <= I_dm_core_data_request.data;
+                        when mintthresh_addr => csr_reg.mintthresh <= I_dm_core_data_request.data;
+                        when mxbank_addr => csr_reg.mxbank <= I_dm_core_data_request.data;
                         when dcsr_addr => csr_reg.dcsr <= I_dm_core_data_request.data;
                         when dpc_addr => csr_reg.dpc <= I_dm_core_data_request.data;
-                        when tdata1_addr => csr_reg.tdata1 <= I_dm_core_data_request.data;
-                        when tdata2_addr => csr_reg.tdata2 <= I_dm_core_data_request.data;
+                        when tselect_addr =>
+                            -- Only existing triggers can be selected
+                            if unsigned(I_dm_core_data_request.data) < OCD_TRIGGERS then
+                                csr_reg.tselect <= I_dm_core_data_request.data;
+                            end if;
+                        when tdata1_addr => csr_reg.tdata1(tsel) <= I_dm_core_data_request.data;
+                        when tdata2_addr => csr_reg.tdata2(tsel) <= I_dm_core_data_request.data;
                         when others => null;
                     end case;
                 end if;
 
                 
-                -- Set all bits hard to 0 except MTIE (7), MSIE (3)
-                csr_reg.mie(csr_reg.mie'left downto 8) <= (others => '0');
+                -- Set all bits hard to 0 except LCOFIE (13), MTIE (7), MSIE (3)
+                csr_reg.mie(csr_reg.mie'left downto 14) <= (others => '0');
+                if not HAVE_ZIHPM then
+                    csr_reg.mie(13) <= '0';
+                end if;
+                csr_reg.mie(12 downto 8) <= (others => '0');
                 csr_reg.mie(6 downto 4) <= (others => '0');
                 csr_reg.mie(2 downto 0) <= (others => '0');
 
@@ -3264,31 +4646,59 @@ begin
                 -- TI bit always 0
                 csr_reg.mcountinhibit(1) <= '0';
                 
-                -- Bit 1 of mtvec should always be 0
-                csr_reg.mtvec(1) <= '0';
+                -- Bit 1 of mtvec should always be 0, except for CLIC mode (11)
+                if not HAVE_CLIC then
+                    csr_reg.mtvec(1) <= '0';
+                end if;
                 
                 -- MCAUSE doesn't use that many bits...
-                -- Only Interrupt Bit and 5 LSB are needed
-                csr_reg.mcause(30 downto 5) <= (others => '0');
+                -- Only Interrupt Bit and 5 LSB are needed, with the CLIC
+                -- also the previous interrupt level (mpil) in bits 23:16
+                if HAVE_CLIC then
+                    csr_reg.mcause(30 downto 24) <= (others => '0');
+                    csr_reg.mcause(15 downto 5) <= (others => '0');
+                else
+                    csr_reg.mcause(30 downto 5) <= (others => '0');
+                end if;
+
+                -- Only an 8-bit threshold, the interrupt level is in mintstatus(31:24)
+                csr_reg.mintthresh(31 downto 8) <= (others => '0');
+                csr_reg.mintstatus(23 downto 0) <= (others => '0');
+                if not HAVE_CLIC then
+                    csr_reg.mintthresh <= (others => '0');
+                    csr_reg.mintstatus <= (others => '0');
+                end if;
+
+                -- Only the switch enable (bit 2) and the previous bank (bit 1)
+                -- are writable, the current bank (bit 0) and the nested trap
+                -- flag (bit 3) are read-only
+                csr_reg.mxbank(31 downto 4) <= (others => '0');
+                csr_reg.mxbank(3) <= csr_reg.mxbank(3);
+                csr_reg.mxbank(0) <= csr_reg.mxbank(0);
+                if NUMBER_OF_BANKS = 1 then
+                    csr_reg.mxbank <= (others => '0');
+                end if;
 
                 -- Not al bits are used
                 -- Only 40 bits are used in the counters
-                -- There are only 6 events that can be counted
+                -- There are only HPM_EVENTS events that can be counted,
+                -- bit 31 is the overflow flag (OF) and bit 30 inhibits
+                -- counting (MINH)
                 if HAVE_ZIHPM then
                     csr_reg.mhpmcounter3h(csr_reg.mhpmcounter3h'left downto 8) <= (others => '0');
-                    csr_reg.mhpmevent3(csr_reg.mhpmevent3'left downto 7) <= (others => '0');
+                    csr_reg.mhpmevent3(29 downto HPM_EVENTS) <= (others => '0');
                     csr_reg.mhpmcounter4h(csr_reg.mhpmcounter3h'left downto 8) <= (others => '0');
-                    csr_reg.mhpmevent4(csr_reg.mhpmevent4'left downto 7) <= (others => '0');
+                    csr_reg.mhpmevent4(29 downto HPM_EVENTS) <= (others => '0');
                     csr_reg.mhpmcounter5h(csr_reg.mhpmcounter5h'left downto 8) <= (others => '0');
-                    csr_reg.mhpmevent5(csr_reg.mhpmevent5'left downto 7) <= (others => '0');
+                    csr_reg.mhpmevent5(29 downto HPM_EVENTS) <= (others => '0');
                     csr_reg.mhpmcounter6h(csr_reg.mhpmcounter6h'left downto 8) <= (others => '0');
-                    csr_reg.mhpmevent6(csr_reg.mhpmevent6'left downto 7) <= (others => '0');
+                    csr_reg.mhpmevent6(29 downto HPM_EVENTS) <= (others => '0');
                     csr_reg.mhpmcounter7h(csr_reg.mhpmcounter7h'left downto 8) <= (others => '0');
-                    csr_reg.mhpmevent7(csr_reg.mhpmevent7'left downto 7) <= (others => '0');
+                    csr_reg.mhpmevent7(29 downto HPM_EVENTS) <= (others => '0');
                     csr_reg.mhpmcounter8h(csr_reg.mhpmcounter8h'left downto 8) <= (others => '0');
-                    csr_reg.mhpmevent8(csr_reg.mhpmevent8'left downto 7) <= (others => '0');
+                    csr_reg.mhpmevent8(29 downto HPM_EVENTS) <= (others => '0');
                     csr_reg.mhpmcounter9h(csr_reg.mhpmcounter9h'left downto 8) <= (others => '0');
-                    csr_reg.mhpmevent9(csr_reg.mhpmevent9'left downto 7) <= (others => '0');
+                    csr_reg.mhpmevent9(29 downto HPM_EVENTS) <= (others => '0');
                 else
                     csr_reg.mhpmcounter3 <= (others => '0');
                     csr_reg.mhpmcounter3h <= (others => '0');
@@ -3330,32 +4740,50 @@ begin
                     csr_reg.dcsr(27 downto 18) <= (others => '0');   -- reserved
                     csr_reg.dcsr(31 downto 28) <= "0100";            -- version 1.0
 
-                    csr_reg.tdata1(31 downto 28) <= x"6";            -- always type 6 (mcontrol6)
-                    csr_reg.tdata1(26) <= '0';                       -- uncertain
-                    csr_reg.tdata1(25) <= '0';                       -- hit1 = 0
-                    csr_reg.tdata1(24) <= '0';                       -- vs
-                    csr_reg.tdata1(23) <= '0';                       -- vu
-                    csr_reg.tdata1(20) <= '0';                       -- 0
-                    csr_reg.tdata1(19) <= '0';                       -- 0
-                    csr_reg.tdata1(11) <= '0';                       -- chain
-                    csr_reg.tdata1(5) <= '0';                        -- uncertainen
-                    csr_reg.tdata1(4) <= '0';                        -- S mode
-                    csr_reg.tdata1(3) <= '0';                        -- U mode
-                    csr_reg.tdata1(1) <= '0';                        -- no store
-                    csr_reg.tdata1(0) <= '0';                        -- no load
+                    for i in 0 to OCD_TRIGGERS-1 loop
+                        csr_reg.tdata1(i)(31 downto 28) <= x"6";         -- always type 6 (mcontrol6)
+                        csr_reg.tdata1(i)(26) <= '0';                    -- uncertain
+                        csr_reg.tdata1(i)(25) <= '0';                    -- hit1 = 0
+                        csr_reg.tdata1(i)(24) <= '0';                    -- vs
+                        csr_reg.tdata1(i)(23) <= '0';                    -- vu
+                        csr_reg.tdata1(i)(21) <= '0';                    -- select address only
+                        csr_reg.tdata1(i)(20) <= '0';                    -- 0
+                        csr_reg.tdata1(i)(19) <= '0';                    -- 0
+                        csr_reg.tdata1(i)(18 downto 16) <= "000";        -- size any
+                        if csr_reg.tdata1(i)(10 downto 9) /= "00" then
+                            csr_reg.tdata1(i)(10 downto 7) <= "0000";    -- match: only equal, NAPOT, >= and <
+                        end if;
+                        if i = OCD_TRIGGERS-1 then
+                            csr_reg.tdata1(i)(11) <= '0';                -- last trigger cannot chain
+                        end if;
+                        csr_reg.tdata1(i)(5) <= '0';                     -- uncertainen
+                        csr_reg.tdata1(i)(4) <= '0';                     -- S mode
+                        csr_reg.tdata1(i)(3) <= '0';                     -- U mode
+                    end loop;
+                    csr_reg.tselect(31 downto 2) <= (others => '0');
 
                     csr_reg.dpc(0) <= '0';                           -- LSB always 0
                 else
                     csr_reg.dcsr <= (others => '0');
                     csr_reg.dpc <= (others => '0');
-                    csr_reg.tdata1 <= (others => '0');
-                    csr_reg.tdata2 <= (others => '0');
+                    csr_reg.tselect <= (others => '0');
+                    csr_reg.tdata1 <= (others => (others => '0'));
+                    csr_reg.tdata2 <= (others => (others => '0'));
                 end if;
                 
                 -- Interrupt handling takes priority over possible user
                 -- update of the CSRs.
                 -- The LIC checks if exceptions/interrupts are enabled.
-                if control.trap_request = '1' and control.stall_on_trigger = '0' then
+                if control.trap_request = '1' and control.stall_on_trigger = '0' and control.trap_chain = '1' then
+                    -- Tail-chaining on MRET, return address, mpie and
+                    -- mpil are kept, only the cause and level change
+                    csr_reg.mstatus(3) <= '0';
+                    csr_reg.mcause(31) <= '1';
+                    csr_reg.mcause(4 downto 0) <= control.trap_mcause(4 downto 0);
+                    csr_reg.mintstatus(31 downto 24) <= I_clic.level;
+                    csr_transfer.clic_vector <= I_clic.vector;
+                    control.clic_shv <= I_clic.shv;
+                elsif control.trap_request = '1' and control.stall_on_trigger = '0' then
                     -- Copy mie to mpie
                     csr_reg.mstatus(7) <= csr_reg.mstatus(3);
                     -- Set M mode
@@ -3366,6 +4794,17 @@ begin
                     csr_reg.mcause <= control.trap_mcause;
                     -- Save PC at the point of interrupt
                     csr_reg.mepc <= id_ex.pc;
+                    -- In CLIC mode, save the interrupt level in mpil and
+                    -- raise the level for an interrupt from the CLIC
+                    if control.clic_mode = '1' then
+                        csr_reg.mcause(23 downto 16) <= csr_reg.mintstatus(31 downto 24);
+                        if control.trap_clic = '1' then
+                            csr_reg.mintstatus(31 downto 24) <= I_clic.level;
+                        end if;
+                    end if;
+                    -- Hardware vectored interrupt from the CLIC
+                    csr_transfer.clic_vector <= I_clic.vector;
+                    control.clic_shv <= control.trap_clic and I_clic.shv;
                     -- Set MTVAL
                     if control.trap_mcause = x"00000000" then
                         -- Instruction misaligned fault, set MTVAL to all zeros
@@ -3394,21 +4833,61 @@ begin
                     csr_reg.mstatus(7) <= '1';
                     -- Keep M mode
                     csr_reg.mstatus(12 downto 11) <= "11";
+                    -- Restore the interrupt level
+                    if control.clic_mode = '1' then
+                        csr_reg.mintstatus(31 downto 24) <= csr_reg.mcause(23 downto 16);
+                    end if;
                  -- Enable further NMI interrupts
                     control.nmi_lockout <= '0';
                 end if;
+
+                -- Shadow register bank. On trap entry, the current bank is
+                -- saved and an interrupt (not the NMI) switches to the shadow
+                -- bank if enabled. MRET switches back when the pipeline is
+                -- flushed, before the instruction at the return address reads
+                -- its registers. Tail-chaining keeps the bank. Interrupts are
+                -- not taken in the shadow bank. A trap in the shadow bank (an
+                -- exception or the NMI) keeps the bank and the previous bank
+                -- and sets the nested flag, its MRET clears the flag and stays
+                -- in the shadow bank.
+                if NUMBER_OF_BANKS = 2 then
+                    if control.trap_request = '1' and control.stall_on_trigger = '0' and control.trap_chain = '0' then
+                        if csr_reg.mxbank(0) = '1' then
+                            csr_reg.mxbank(3) <= '1';
+                        else
+                            csr_reg.mxbank(1) <= csr_reg.mxbank(0);
+                            if csr_reg.mxbank(2) = '1' and control.trap_mcause(31) = '1' and control.trap_mcause(4 downto 0) /= "11111" then
+                                csr_reg.mxbank(0) <= '1';
+                            end if;
+                        end if;
+                    elsif control.state = state_mret then
+                        if csr_reg.mxbank(3) = '1' then
+                            csr_reg.mxbank(3) <= '0';
+                        else
+                            csr_reg.mxbank(0) <= csr_reg.mxbank(1);
+                        end if;
+                    end if;
+                end if;
             end if; -- sreset
         end if; -- posedge
 
         -- Calculate the MTVEC to be loaded in the PC on trap
-        if VECTORED_MTVEC and csr_reg.mtvec(0) = '1' and csr_reg.mcause(31) = '1' then
+        -- A hardware vectored interrupt from the CLIC jumps to its handler
+        if control.clic_shv = '1' then
+            csr_transfer.mtvec_to_pc <= csr_transfer.clic_vector(csr_transfer.clic_vector'left downto 1) & '0';
+        elsif VECTORED_MTVEC and csr_reg.mtvec(1 downto 0) = "01" and csr_reg.mcause(31) = '1' then
             csr_transfer.mtvec_to_pc <= std_logic_vector(unsigned(csr_reg.mtvec(csr_reg.mtvec'left downto 2)) + unsigned(csr_reg.mcause(5 downto 0))) & "00";
         else
             csr_transfer.mtvec_to_pc <= csr_reg.mtvec(csr_reg.mtvec'left downto 2) & "00";
         end if;
 
-        -- Lowest two bits of mepc always 0, see priv ISA, S.3.1.14
-        csr_reg.mepc(1 downto 0) <= "00";
+        -- Lowest two bits of mepc always 0, see priv ISA, S.3.1.14,
+        -- only the lowest bit with compressed instructions
+        if HAVE_ZCA then
+            csr_reg.mepc(0) <= '0';
+        else
+            csr_reg.mepc(1 downto 0) <= "00";
+        end if;
 
     end process;
 
@@ -3425,8 +4904,13 @@ begin
     csr_reg.misa(31 downto 13) <= x"4000" & "000";
     csr_reg.misa(12) <= '1' when HAVE_MULDIV else '0';
     csr_reg.misa(11 downto 4) <= x"10" when NUMBER_OF_REGISTERS = 32 else x"01";
-    csr_reg.misa(3 downto 0) <= x"2" when HAVE_ZBA and HAVE_ZBB and HAVE_ZBS else x"0";
-    csr_reg.mip <= I_intrio;
+    csr_reg.misa(3) <= '0';
+    csr_reg.misa(2) <= '1' when HAVE_ZCA else '0';
+    csr_reg.misa(1) <= '1' when HAVE_ZBA and HAVE_ZBB and HAVE_ZBS else '0';
+    csr_reg.misa(0) <= '0';
+    csr_reg.mip(31 downto 14) <= I_intrio(31 downto 14);
+    csr_reg.mip(13) <= hpm_overflow;
+    csr_reg.mip(12 downto 0) <= I_intrio(12 downto 0);
     -- Debug tinfo
     csr_reg.tinfo <= x"01000040" when HAVE_OCD else (others => '0'); -- v1, only mcontrol6
 
@@ -3443,9 +4927,9 @@ begin
     csr_reg.mxhw(09) <= boolean_to_std_logic(HAVE_SPI2);
     csr_reg.mxhw(10) <= boolean_to_std_logic(HAVE_TIMER1);
     csr_reg.mxhw(11) <= boolean_to_std_logic(HAVE_TIMER2);
-    csr_reg.mxhw(12) <= '0'; -- reserved
-    csr_reg.mxhw(13) <= '0'; -- reserved
-    csr_reg.mxhw(14) <= '0'; -- reserved
+    csr_reg.mxhw(12) <= boolean_to_std_logic(HAVE_DMA);
+    csr_reg.mxhw(13) <= boolean_to_std_logic(HAVE_BRANCH_PREDICTION and not HAVE_ZCA);
+    csr_reg.mxhw(14) <= boolean_to_std_logic(HAVE_BRANCH_PREDICTION and HAVE_BTB and not HAVE_ZCA);
     csr_reg.mxhw(15) <= '1'; -- TIME/TIMEH, always present
     csr_reg.mxhw(16) <= boolean_to_std_logic(HAVE_MULDIV);
     csr_reg.mxhw(17) <= boolean_to_std_logic(FAST_DIVIDE and HAVE_MULDIV);
@@ -3467,12 +4951,25 @@ begin
     -- Custom read-only synthesized clock frequency
     csr_reg.mxspeed <= std_logic_vector(to_unsigned(SYSTEM_FREQUENCY, 32));
 
+    -- Custom read-only second hardware description
+    csr_reg.mxhw2(00) <= boolean_to_std_logic(SINGLE_CYCLE_MULTIPLY and HAVE_MULDIV);
+    csr_reg.mxhw2(01) <= boolean_to_std_logic(EARLY_DIVIDE and HAVE_MULDIV);
+    csr_reg.mxhw2(02) <= boolean_to_std_logic(HAVE_PREFETCH);
+    csr_reg.mxhw2(03) <= boolean_to_std_logic(FAST_LOAD and FAST_MEM);
+    csr_reg.mxhw2(04) <= boolean_to_std_logic(HAVE_STORE_BUFFER);
+    csr_reg.mxhw2(05) <= boolean_to_std_logic(HAVE_ZCB and HAVE_ZCA);
+    csr_reg.mxhw2(06) <= boolean_to_std_logic(HAVE_ZCMP and HAVE_ZCA);
+    csr_reg.mxhw2(07) <= boolean_to_std_logic(HAVE_CLIC);
+    csr_reg.mxhw2(08) <= boolean_to_std_logic(NUMBER_OF_BANKS = 2);
+    csr_reg.mxhw2(09) <= boolean_to_std_logic(HAVE_TRACE);
+    csr_reg.mxhw2(31 downto 10) <= (others => '0');
+
     -- Copy system timer info
     csr_reg.mtime <= I_mtime;
     csr_reg.mtimeh <= I_mtimeh;
 
-    -- Only 1 hw breakpoint
-    csr_reg.tselect <= (others => '0');
+    -- Selected hardware trigger
+    tsel <= to_integer(unsigned(csr_reg.tselect(1 downto 0)));
 
     
     --
@@ -3483,12 +4980,29 @@ begin
     -- trap is to be served. Note that interrupts will only
     -- be served if the processor is in the exec and wfi states.
     -- Exceptions will be served in the exec and mem states,
-    process (I_clk, I_areset, I_intrio, I_bus_response,
-             I_instr_response.instr_access_error, control, csr_reg) is
+    -- In CLIC mode, all interrupts except the NMI are handled by the CLIC.
+    process (I_clk, I_areset, I_intrio, I_clic, I_bus_response,
+             I_instr_response.instr_access_error, control, csr_reg, hpm_overflow) is
+    variable intrio_v : data_type;
+    variable mie_v : std_logic;
     begin
         control.trap_request <= '0';
         control.trap_release <= '0';
         control.trap_mcause <= (others => '0');
+        control.trap_clic <= '0';
+        control.trap_chain <= '0';
+
+        intrio_v := I_intrio;
+        if control.clic_mode = '1' then
+            intrio_v(30 downto 0) := (others => '0');
+        end if;
+
+        -- No interrupts in the shadow bank, a nested handler would
+        -- overwrite the registers of the running handler
+        mie_v := csr_reg.mstatus(3);
+        if NUMBER_OF_BANKS = 2 and csr_reg.mxbank(0) = '1' then
+            mie_v := '0';
+        end if;
         
         -- Priority as of Table 3.7 of "Volume II: RISC-V Privileged Architectures V20211203"
         -- Local hardware interrupts take priority over exceptions, the RISC-V system timer
@@ -3499,94 +5013,112 @@ begin
             control.trap_request <= '1';
             control.trap_mcause <= std_logic_vector(to_unsigned(31, control.trap_mcause'length));
             control.trap_mcause(31) <= '1';
+        -- Interrupt from the CLIC, above the current level and threshold
+        elsif control.clic_preempt = '1' and mie_v = '1' and control.may_interrupt ='1' and control.isstepping = '0' then
+            control.trap_request <= '1';
+            control.trap_mcause <= std_logic_vector(resize(unsigned(I_clic.id), control.trap_mcause'length));
+            control.trap_mcause(31) <= '1';
+            control.trap_clic <= '1';
+        -- Tail-chaining, MRET with an interrupt waiting to be taken
+        elsif control.clic_chain = '1' and control.mret_request = '1' and control.state = state_exec and control.may_interrupt ='1' then
+            control.trap_request <= '1';
+            control.trap_mcause <= std_logic_vector(resize(unsigned(I_clic.id), control.trap_mcause'length));
+            control.trap_mcause(31) <= '1';
+            control.trap_clic <= '1';
+            control.trap_chain <= '1';
         -- Currently unassigned
-        elsif I_intrio(30) = '1' and csr_reg.mstatus(3) = '1' and control.may_interrupt ='1' and control.isstepping = '0' then
+        elsif intrio_v(30) = '1' and mie_v = '1' and control.may_interrupt ='1' and control.isstepping = '0' then
             control.trap_request <= '1';
             control.trap_mcause <= std_logic_vector(to_unsigned(30, control.trap_mcause'length));
             control.trap_mcause(31) <= '1';
         -- Currently unassigned
-        elsif I_intrio(29) = '1' and csr_reg.mstatus(3) = '1' and control.may_interrupt ='1' and control.isstepping = '0' then
+        elsif intrio_v(29) = '1' and mie_v = '1' and control.may_interrupt ='1' and control.isstepping = '0' then
             control.trap_request <= '1';
             control.trap_mcause <= std_logic_vector(to_unsigned(29, control.trap_mcause'length));
             control.trap_mcause(31) <= '1';
         -- Currently unassigned
-        elsif I_intrio(28) = '1' and csr_reg.mstatus(3) = '1' and control.may_interrupt ='1' and control.isstepping = '0' then
+        elsif intrio_v(28) = '1' and mie_v = '1' and control.may_interrupt ='1' and control.isstepping = '0' then
             control.trap_request <= '1';
             control.trap_mcause <= std_logic_vector(to_unsigned(28, control.trap_mcause'length));
             control.trap_mcause(31) <= '1';
         -- SPI1
-        elsif I_intrio(27) = '1' and csr_reg.mstatus(3) = '1' and control.may_interrupt ='1' and control.isstepping = '0' then
+        elsif intrio_v(27) = '1' and mie_v = '1' and control.may_interrupt ='1' and control.isstepping = '0' then
             control.trap_request <= '1';
             control.trap_mcause <= std_logic_vector(to_unsigned(27, control.trap_mcause'length));
             control.trap_mcause(31) <= '1';
         -- I2C1
-        elsif I_intrio(26) = '1' and csr_reg.mstatus(3) = '1' and control.may_interrupt ='1' and control.isstepping = '0' then
+        elsif intrio_v(26) = '1' and mie_v = '1' and control.may_interrupt ='1' and control.isstepping = '0' then
             control.trap_request <= '1';
             control.trap_mcause <= std_logic_vector(to_unsigned(26, control.trap_mcause'length));
             control.trap_mcause(31) <= '1';
         -- SPI2
-        elsif I_intrio(25) = '1' and csr_reg.mstatus(3) = '1' and control.may_interrupt ='1' and control.isstepping = '0' then
+        elsif intrio_v(25) = '1' and mie_v = '1' and control.may_interrupt ='1' and control.isstepping = '0' then
             control.trap_request <= '1';
             control.trap_mcause <= std_logic_vector(to_unsigned(25, control.trap_mcause'length));
             control.trap_mcause(31) <= '1';
         -- I2C2
-        elsif I_intrio(24) = '1' and csr_reg.mstatus(3) = '1' and control.may_interrupt ='1' and control.isstepping = '0' then
+        elsif intrio_v(24) = '1' and mie_v = '1' and control.may_interrupt ='1' and control.isstepping = '0' then
             control.trap_request <= '1';
             control.trap_mcause <= std_logic_vector(to_unsigned(24, control.trap_mcause'length));
             control.trap_mcause(31) <= '1';
         -- UART1
-        elsif I_intrio(23) = '1' and csr_reg.mstatus(3) = '1' and control.may_interrupt ='1' and control.isstepping = '0' then
+        elsif intrio_v(23) = '1' and mie_v = '1' and control.may_interrupt ='1' and control.isstepping = '0' then
             control.trap_request <= '1';
             control.trap_mcause <= std_logic_vector(to_unsigned(23, control.trap_mcause'length));
             control.trap_mcause(31) <= '1';
         -- Currently unassigned
-        elsif I_intrio(22) = '1' and csr_reg.mstatus(3) = '1' and control.may_interrupt ='1' and control.isstepping = '0' then
+        elsif intrio_v(22) = '1' and mie_v = '1' and control.may_interrupt ='1' and control.isstepping = '0' then
             control.trap_request <= '1';
             control.trap_mcause <= std_logic_vector(to_unsigned(22, control.trap_mcause'length));
             control.trap_mcause(31) <= '1';
         -- TIMER2
-        elsif I_intrio(21) = '1' and csr_reg.mstatus(3) = '1' and control.may_interrupt ='1' and control.isstepping = '0' then
+        elsif intrio_v(21) = '1' and mie_v = '1' and control.may_interrupt ='1' and control.isstepping = '0' then
             control.trap_request <= '1';
             control.trap_mcause <= std_logic_vector(to_unsigned(21, control.trap_mcause'length));
             control.trap_mcause(31) <= '1';
         -- TIMER1
-        elsif I_intrio(20) = '1' and csr_reg.mstatus(3) = '1' and control.may_interrupt ='1' and control.isstepping = '0' then
+        elsif intrio_v(20) = '1' and mie_v = '1' and control.may_interrupt ='1' and control.isstepping = '0' then
             control.trap_request <= '1';
             control.trap_mcause <= std_logic_vector(to_unsigned(20, control.trap_mcause'length));
             control.trap_mcause(31) <= '1';
         -- Currently unassigned
-        elsif I_intrio(19) = '1' and csr_reg.mstatus(3) = '1' and control.may_interrupt ='1' and control.isstepping = '0' then
+        elsif intrio_v(19) = '1' and mie_v = '1' and control.may_interrupt ='1' and control.isstepping = '0' then
             control.trap_request <= '1';
             control.trap_mcause <= std_logic_vector(to_unsigned(19, control.trap_mcause'length));
             control.trap_mcause(31) <= '1';
         -- EXTI
-        elsif I_intrio(18) = '1' and csr_reg.mstatus(3) = '1' and control.may_interrupt ='1' and control.isstepping = '0' then
+        elsif intrio_v(18) = '1' and mie_v = '1' and control.may_interrupt ='1' and control.isstepping = '0' then
             control.trap_request <= '1';
             control.trap_mcause <= std_logic_vector(to_unsigned(18, control.trap_mcause'length));
             control.trap_mcause(31) <= '1';
         -- Currently unassigned
-        elsif I_intrio(17) = '1' and csr_reg.mstatus(3) = '1' and control.may_interrupt ='1' and control.isstepping = '0' then
+        elsif intrio_v(17) = '1' and mie_v = '1' and control.may_interrupt ='1' and control.isstepping = '0' then
             control.trap_request <= '1';
             control.trap_mcause <= std_logic_vector(to_unsigned(17, control.trap_mcause'length));
             control.trap_mcause(31) <= '1';
         -- Currently unassigned
-        elsif I_intrio(16) = '1' and csr_reg.mstatus(3) = '1' and control.may_interrupt ='1' and control.isstepping = '0' then
+        elsif intrio_v(16) = '1' and mie_v = '1' and control.may_interrupt ='1' and control.isstepping = '0' then
             control.trap_request <= '1';
             control.trap_mcause <= std_logic_vector(to_unsigned(16, control.trap_mcause'length));
             control.trap_mcause(31) <= '1';
         -- RISC-V machine software interrupt
-        elsif I_intrio(3) = '1' and csr_reg.mstatus(3) = '1' and csr_reg.mie(3) = '1' and control.may_interrupt ='1' and control.isstepping = '0' then
+        elsif intrio_v(3) = '1' and mie_v = '1' and csr_reg.mie(3) = '1' and control.may_interrupt ='1' and control.isstepping = '0' then
             control.trap_request <= '1';
             control.trap_mcause <= std_logic_vector(to_unsigned(3, control.trap_mcause'length));
             control.trap_mcause(31) <= '1';
         -- RISC-V external timer interrupt
-        elsif I_intrio(7) = '1' and csr_reg.mstatus(3) = '1' and csr_reg.mie(7) = '1' and control.may_interrupt ='1' and control.isstepping = '0' then
+        elsif intrio_v(7) = '1' and mie_v = '1' and csr_reg.mie(7) = '1' and control.may_interrupt ='1' and control.isstepping = '0' then
             control.trap_request <= '1';
             control.trap_mcause <= std_logic_vector(to_unsigned(7, control.trap_mcause'length));
             control.trap_mcause(31) <= '1';
+        -- Local counter overflow interrupt, not in CLIC mode
+        elsif hpm_overflow = '1' and control.clic_mode = '0' and mie_v = '1' and csr_reg.mie(13) = '1' and control.may_interrupt ='1' and control.isstepping = '0' then
+            control.trap_request <= '1';
+            control.trap_mcause <= std_logic_vector(to_unsigned(13, control.trap_mcause'length));
+            control.trap_mcause(31) <= '1';
         -- Exceptions from here. Can always start a trap.
         -- Instruction access from unimplemented ROM
-        elsif control.instr_access_error(1) = '1' then
+        elsif control.instr_access_error = '1' then
             control.trap_request <= '1';
             control.trap_mcause <= std_logic_vector(to_unsigned(1, control.trap_mcause'length));
         -- Illegal instruction, can also be a CSR instruction problem
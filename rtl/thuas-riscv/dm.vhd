@@ -34,10 +34,18 @@
 -- # https:/github.com/jesseopdenbrouw/thuas-riscv                                                 #
 -- #################################################################################################
 
--- This file contains the Debug Module (DM). The DM can only handle Abstract Commands:
--- Access Registers and Access Memory. Program buffer and system bus are not supported.
--- See Debug spec, S. 6.1.1.
+-- This file contains the Debug Module (DM). The DM can handle Abstract Commands:
+-- Access Registers and Access Memory. Program buffer is not supported.
+-- See Debug spec, S. 6.1.1. Commands can be repeated by accessing data0 or
+-- data1 when the corresponding abstractauto bit is set (burst access).
 -- Register access can also read/write CSRs. Parts based on neorv32 DM module.
+-- Optionally, the DM has System Bus Access (SBA), see Debug spec, S. 3.10.
+-- The DM is then a bus master next to the core and the DMA, so memory can
+-- be read and written without halting the hart.
+-- Optionally, the DM has a read-only PC sample register at the first
+-- custom DMI address (0x70). It returns the PC of the last retired
+-- instruction, so that the debugger can sample the PC while the hart
+-- is running.
 
 library ieee;
 use ieee.std_logic_1164.all;
@@ -50,7 +58,11 @@ use work.processor_common.all;
 entity dm is
     generic (
              -- Do we use address post-increment?
-             OCD_AAMPOSTINCREMENT : boolean
+             OCD_AAMPOSTINCREMENT : boolean;
+             -- Do we have System Bus Access?
+             OCD_SYSBUS : boolean;
+             -- Do we have the PC sample register?
+             OCD_PCSAMPLE : boolean
             );
     port (I_clk : in std_logic;
           I_areset : in std_logic;
@@ -68,7 +80,14 @@ entity dm is
           O_ackhavereset : out std_logic;
           -- Data exchange with the core
           O_dm_core_data_request : out dm_core_data_request_type;
-          I_dm_core_data_response : in dm_core_data_response_type
+          I_dm_core_data_response : in dm_core_data_response_type;
+          -- System Bus Access
+          O_bus_request : out bus_request_type;
+          I_bus_response : in bus_response_type;
+          O_bus_hold : out std_logic;
+          I_bus_grant : in std_logic;
+          -- PC of the last retired instruction
+          I_pcsample : in data_type
          );
 end entity dm;
 
@@ -82,7 +101,12 @@ constant addr_dmstatus_c     : std_logic_vector(6 downto 0) := "0010001";
 constant addr_hartinfo_c     : std_logic_vector(6 downto 0) := "0010010";
 constant addr_abstractcs_c   : std_logic_vector(6 downto 0) := "0010110";
 constant addr_command_c      : std_logic_vector(6 downto 0) := "0010111";
+constant addr_abstractauto_c : std_logic_vector(6 downto 0) := "0011000";
 constant addr_nextdm_c       : std_logic_vector(6 downto 0) := "0011101";
+constant addr_sbcs_c         : std_logic_vector(6 downto 0) := "0111000";
+constant addr_sbaddress0_c   : std_logic_vector(6 downto 0) := "0111001";
+constant addr_sbdata0_c      : std_logic_vector(6 downto 0) := "0111100";
+constant addr_pcsample_c     : std_logic_vector(6 downto 0) := "1110000";
 constant addr_haltsum0_c     : std_logic_vector(6 downto 0) := "1000000";
 
 -- Memory timeout in clock cycles
@@ -112,17 +136,52 @@ type dm_reg_type is record
     data0mustread : std_logic;
     data1mustincrement : std_logic;
     clrerr : std_logic;
+    autoexec : std_logic;
     wren : std_logic;
     rden : std_logic;
     --
     data0, data1 : data_type;
     command : data_type;
+    autoexecdata : std_logic_vector(1 downto 0);
     cmderr : std_logic_vector(2 downto 0);
     state : dmstate_type;
     counter : integer range 0 to dm_memory_timeout_c-1;
 end record;
 signal dm_reg : dm_reg_type;
 
+-- States of the System Bus Access
+type sbstate_type is (sb_idle, sb_grant, sb_access, sb_wait);
+
+type sb_reg_type is record
+    sbbusyerror : std_logic;
+    sbreadonaddr : std_logic;
+    sbaccess : std_logic_vector(2 downto 0);
+    sbautoincrement : std_logic;
+    sbreadondata : std_logic;
+    sberror : std_logic_vector(2 downto 0);
+    sbaddress : data_type;
+    sbdata : data_type;
+    sbwrite : std_logic;
+    state : sbstate_type;
+    counter : integer range 0 to dm_memory_timeout_c-1;
+end record;
+signal sb_reg : sb_reg_type;
+signal sbbusy : std_logic;
+
+constant sb_reg_reset_c : sb_reg_type := (
+    sbbusyerror => '0',
+    sbreadonaddr => '0',
+    sbaccess => "010",
+    sbautoincrement => '0',
+    sbreadondata => '0',
+    sberror => "000",
+    sbaddress => (others => '0'),
+    sbdata => (others => '0'),
+    sbwrite => '0',
+    state => sb_idle,
+    counter => 0
+   );
+
 begin
 
     dm_reg.wren <= '1' when I_dmi_request.op = dmi_req_wr_c else '0';
@@ -180,16 +239,45 @@ begin
                             O_dmi_response.data(10 downto 08) <= dm_reg.cmderr;       -- cmderr
                             O_dmi_response.data(07 downto 04) <= (others => '0');     -- reserved
                             O_dmi_response.data(03 downto 00) <= "0010";              -- number of data registers = 2
+                        when addr_abstractauto_c =>
+                            O_dmi_response.data(31 downto 16) <= (others => '0');     -- autoexecprogbuf: no progbuf
+                            O_dmi_response.data(15 downto 02) <= (others => '0');     -- reserved
+                            O_dmi_response.data(01 downto 00) <= dm_reg.autoexecdata; -- autoexecdata for data0 and data1
                         when addr_data0_c =>
                             O_dmi_response.data <= dm_reg.data0;
                         when addr_data1_c =>
                             O_dmi_response.data <= dm_reg.data1;
+                        when addr_sbcs_c =>
+                            -- All zero if there is no System Bus Access
+                            if OCD_SYSBUS then
+                                O_dmi_response.data(31 downto 29) <= "001";                  -- sbversion: Debug spec 1.0
+                                O_dmi_response.data(28 downto 23) <= (others => '0');        -- reserved
+                                O_dmi_response.data(22)           <= sb_reg.sbbusyerror;     -- sbbusyerror (r/w1c)
+                                O_dmi_response.data(21)           <= sbbusy;                 -- sbbusy (r/-)
+                                O_dmi_response.data(20)           <= sb_reg.sbreadonaddr;    -- sbreadonaddr (r/w)
+                                O_dmi_response.data(19 downto 17) <= sb_reg.sbaccess;        -- sbaccess (r/w)
+                                O_dmi_response.data(16)           <= sb_reg.sbautoincrement; -- sbautoincrement (r/w)
+                                O_dmi_response.data(15)           <= sb_reg.sbreadondata;    -- sbreadondata (r/w)
+                                O_dmi_response.data(14 downto 12) <= sb_reg.sberror;         -- sberror (r/w1c)
+                                O_dmi_response.data(11 downto 05) <= "0100000";              -- sbasize (r/-): 32 address bits
+                                O_dmi_response.data(04 downto 00) <= "00111";                -- sbaccess128..8 (r/-): 32, 16 and 8 bits
+                            end if;
+                        when addr_sbaddress0_c =>
+                            O_dmi_response.data <= sb_reg.sbaddress;
+                        when addr_sbdata0_c =>
+                            O_dmi_response.data <= sb_reg.sbdata;
+                        when addr_pcsample_c =>
+                            -- Custom register, all zero if there is no PC sampling
+                            if OCD_PCSAMPLE then
+                                O_dmi_response.data <= I_pcsample;
+                            end if;
                         when addr_haltsum0_c =>
                             O_dmi_response.data <= (0 => I_halt_ack, others => '0');
                         when others =>
                             O_dmi_response.data <= (others => '0');
                     end case;
                     --Read during abstract command executing, see p. 36.
+                    --Also covers an auto-exec read while busy.
                     if dm_reg.busy = '1' then
                         if I_dmi_request.addr = addr_data0_c or
                            I_dmi_request.addr = addr_data1_c then
@@ -215,6 +303,7 @@ begin
             dm_reg.data0 <= (others => '0');
             dm_reg.data1 <= (others => '0');
             dm_reg.command <= (others => '0');
+            dm_reg.autoexecdata <= (others => '0');
             dm_reg.write_acc_fault <= '0';
         elsif rising_edge(I_clk) then
             if I_sreset = '1' then
@@ -227,6 +316,7 @@ begin
                 dm_reg.data0 <= (others => '0');
                 dm_reg.data1 <= (others => '0');
                 dm_reg.command <= (others => '0');
+                dm_reg.autoexecdata <= (others => '0');
                 dm_reg.write_acc_fault <= '0';
             else
                 dm_reg.clrerr <= '0';
@@ -250,6 +340,10 @@ begin
                             if dm_reg.busy = '0' and dm_reg.cmderr = "000" then -- idle and no errors yet
                                 dm_reg.command <= I_dmi_request.data;
                             end if;
+                        when addr_abstractauto_c =>
+                            if dm_reg.busy = '0' then
+                                dm_reg.autoexecdata <= I_dmi_request.data(1 downto 0);
+                            end if;
                         when addr_data0_c =>
                             if dm_reg.busy = '0' then
                                 dm_reg.data0 <= I_dmi_request.data;
@@ -265,6 +359,7 @@ begin
                     if dm_reg.busy = '1' then
                         if I_dmi_request.addr = addr_abstractcs_c or
                            I_dmi_request.addr = addr_command_c or
+                           I_dmi_request.addr = addr_abstractauto_c or
                            I_dmi_request.addr = addr_data0_c or
                            I_dmi_request.addr = addr_data1_c then
                             dm_reg.write_acc_fault <= '1';
@@ -362,6 +457,9 @@ begin
                             if dm_reg.wren  = '1' and I_dmi_request.addr = addr_command_c and dm_reg.cmderr = "000" then
                                 -- Command issued
                                 dm_reg.state <= cmd_check;
+                            elsif dm_reg.autoexec = '1' and dm_reg.cmderr = "000" then
+                                -- Command issued again by accessing a data register
+                                dm_reg.state <= cmd_check;
                             end if;
                         -- Check the command and dispatch. Commands are: register access end memory access.
                         when cmd_check =>
@@ -513,6 +611,13 @@ begin
     
     -- Set busy flag
     dm_reg.busy <= '0' when dm_reg.state = cmd_idle else '1';
+    -- Reading or writing a data register with its autoexecdata bit set executes
+    -- the command again after the access, see Debug spec, S. 3.12.8. As with a
+    -- write to command, this is only done when idle. An access while busy sets
+    -- cmderr to busy (1) through read_acc_fault/write_acc_fault.
+    dm_reg.autoexec <= '1' when dm_reg.busy = '0' and (dm_reg.wren = '1' or dm_reg.rden = '1') and
+                                ((I_dmi_request.addr = addr_data0_c and dm_reg.autoexecdata(0) = '1') or
+                                 (I_dmi_request.addr = addr_data1_c and dm_reg.autoexecdata(1) = '1')) else '0';
     -- data0 must read data from the bus
     dm_reg.data0mustread <= '1' when dm_reg.state = cmd_readreg2 or (dm_reg.state = cmd_readmem1 and I_dm_core_data_response.ack = '1') else '0';
     -- data1 must increment or not
@@ -522,5 +627,166 @@ begin
     O_resume_req <= dm_reg.resume_req and dm_reg.dm_active;
     O_reset_req <= dm_reg.ndmreset and dm_reg.dm_active;
     O_ackhavereset <= dm_reg.reset_ack and dm_reg.dm_active;
+
+    -- System Bus Access, see Debug spec, S. 3.10
+    -- An access is started by writing sbdata0 (write), by writing
+    -- sbaddress0 with sbreadonaddr set (read) or by reading sbdata0
+    -- with sbreadondata set (read). The DM requests the bus from
+    -- the bus arbiter, strobes the transfer once and waits for the
+    -- response. The hart keeps running.
+    sbgen: if OCD_SYSBUS generate
+        process (I_clk, I_areset) is
+        variable start_v : std_logic;
+        variable write_v : std_logic;
+        variable address_v : data_type;
+        variable data_v : data_type;
+        variable add_v : integer range 0 to 4;
+        begin
+            if I_areset = '1' then
+                sb_reg <= sb_reg_reset_c;
+            elsif rising_edge(I_clk) then
+                if I_sreset = '1' or dm_reg.dm_active = '0' then
+                    sb_reg <= sb_reg_reset_c;
+                else
+                    start_v := '0';
+                    write_v := '0';
+                    address_v := sb_reg.sbaddress;
+                    -- Write from the DMI
+                    if dm_reg.wren = '1' then
+                        case I_dmi_request.addr is
+                            when addr_sbcs_c =>
+                                -- Clear the errors, write 1 to clear
+                                if I_dmi_request.data(22) = '1' then
+                                    sb_reg.sbbusyerror <= '0';
+                                end if;
+                                sb_reg.sberror <= sb_reg.sberror and not I_dmi_request.data(14 downto 12);
+                                -- Configuration cannot be changed during an access
+                                if sbbusy = '0' then
+                                    sb_reg.sbreadonaddr <= I_dmi_request.data(20);
+                                    sb_reg.sbaccess <= I_dmi_request.data(19 downto 17);
+                                    sb_reg.sbautoincrement <= I_dmi_request.data(16);
+                                    sb_reg.sbreadondata <= I_dmi_request.data(15);
+                                end if;
+                            when addr_sbaddress0_c =>
+                                if sbbusy = '1' then
+                                    sb_reg.sbbusyerror <= '1';
+                                else
+                                    sb_reg.sbaddress <= I_dmi_request.data;
+                                    address_v := I_dmi_request.data;
+                                    start_v := sb_reg.sbreadonaddr;
+                                end if;
+                            when addr_sbdata0_c =>
+                                if sbbusy = '1' then
+                                    sb_reg.sbbusyerror <= '1';
+                                else
+                                    sb_reg.sbdata <= I_dmi_request.data;
+                                    start_v := '1';
+                                    write_v := '1';
+                                end if;
+                            when others =>
+                                null;
+                        end case;
+                    end if;
+                    -- Read from the DMI, the current data is returned
+                    if dm_reg.rden = '1' and I_dmi_request.addr = addr_sbdata0_c then
+                        if sbbusy = '1' then
+                            sb_reg.sbbusyerror <= '1';
+                        else
+                            start_v := sb_reg.sbreadondata;
+                        end if;
+                    end if;
+                    -- Start an access, but not if there are errors pending
+                    if start_v = '1' and sb_reg.sbbusyerror = '0' and sb_reg.sberror = "000" then
+                        if sb_reg.sbaccess(2) = '1' or sb_reg.sbaccess = "011" then
+                            -- Unsupported size
+                            sb_reg.sberror <= "100";
+                        elsif (sb_reg.sbaccess = "001" and address_v(0) /= '0') or
+                              (sb_reg.sbaccess = "010" and address_v(1 downto 0) /= "00") then
+                            -- Misaligned address
+                            sb_reg.sberror <= "011";
+                        else
+                            sb_reg.sbwrite <= write_v;
+                            sb_reg.state <= sb_grant;
+                        end if;
+                    end if;
+
+                    -- The bus transfer
+                    case sb_reg.state is
+                        -- Wait for the bus
+                        when sb_grant =>
+                            sb_reg.counter <= dm_memory_timeout_c-1;
+                            if I_bus_grant = '1' then
+                                sb_reg.state <= sb_access;
+                            end if;
+                        -- Strobe is active for one clock cycle, then wait for response
+                        when sb_access | sb_wait =>
+                            sb_reg.state <= sb_wait;
+                            if I_bus_response.load_access_error = '1' or I_bus_response.store_access_error = '1' then
+                                sb_reg.sberror <= "010";
+                                sb_reg.state <= sb_idle;
+                            elsif I_bus_response.load_misaligned_error = '1' or I_bus_response.store_misaligned_error = '1' then
+                                sb_reg.sberror <= "011";
+                                sb_reg.state <= sb_idle;
+                            elsif I_bus_response.ready = '1' then
+                                -- Only use the bits of the access size
+                                if sb_reg.sbwrite = '0' then
+                                    data_v := I_bus_response.data;
+                                    case sb_reg.sbaccess is
+                                        when "000" => data_v(31 downto 8) := (others => '0');
+                                        when "001" => data_v(31 downto 16) := (others => '0');
+                                        when others => null;
+                                    end case;
+                                    sb_reg.sbdata <= data_v;
+                                end if;
+                                -- Address auto-increment by the access size
+                                if sb_reg.sbautoincrement = '1' then
+                                    case sb_reg.sbaccess is
+                                        when "000"  => add_v := 1;
+                                        when "001"  => add_v := 2;
+                                        when others => add_v := 4;
+                                    end case;
+                                    sb_reg.sbaddress <= std_logic_vector(unsigned(sb_reg.sbaddress) + add_v);
+                                end if;
+                                sb_reg.state <= sb_idle;
+                            -- Timeout, report to the debugger
+                            elsif sb_reg.counter > 0 then
+                                sb_reg.counter <= sb_reg.counter - 1;
+                            else
+                                sb_reg.sberror <= "001";
+                                sb_reg.state <= sb_idle;
+                            end if;
+                        when others =>
+                            null;
+                    end case;
+                end if; -- sreset
+            end if; -- posedge
+        end process;
+
+        sbbusy <= '0' when sb_reg.state = sb_idle else '1';
+
+        -- Bus master signals
+        O_bus_request.stb <= '1' when sb_reg.state = sb_access else '0';
+        O_bus_request.acc <= memaccess_nop when sb_reg.state = sb_idle or sb_reg.state = sb_grant else
+                             memaccess_write when sb_reg.sbwrite = '1' else
+                             memaccess_read;
+        O_bus_request.size <= memsize_byte when sb_reg.sbaccess = "000" else
+                              memsize_halfword when sb_reg.sbaccess = "001" else
+                              memsize_word;
+        O_bus_request.addr <= sb_reg.sbaddress;
+        O_bus_request.data <= sb_reg.sbdata;
+        -- Keep the bus during the transfer
+        O_bus_hold <= '0' when sb_reg.state = sb_idle else '1';
+    end generate;
+
+    sbgen_not: if not OCD_SYSBUS generate
+        sb_reg <= sb_reg_reset_c;
+        sbbusy <= '0';
+        O_bus_request.stb <= '0';
+        O_bus_request.acc <= memaccess_nop;
+        O_bus_request.size <= memsize_unknown;
+        O_bus_request.addr <= (others => '0');
+        O_bus_request.data <= (others => '0');
+        O_bus_hold <= '0';
+    end generate;
     
 end architecture rtl;
\ No newline at end of file
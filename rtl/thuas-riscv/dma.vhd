@@ -0,0 +1,362 @@
+-- #################################################################################################
+-- # dma.vhd -- Direct Memory Access controller                                                    #
+-- # ********************************************************************************************* #
+-- # This file is part of the THUAS RISCV RV32 Project                                             #
+-- # ********************************************************************************************* #
+-- # BSD 3-Clause License                                                                          #
+-- #                                                                                               #
+-- # Copyright (c) 2026, Jesse op den Brouw. All rights reserved.                                  #
+-- #                                                                                               #
+-- # Redistribution and use in source and binary forms, with or without modification, are          #
+-- # permitted provided that the following conditions are met:                                     #
+-- #                                                                                               #
+-- # 1. Redistributions of source code must retain the above copyright notice, this list of        #
+-- #    conditions and the following disclaimer.                                                   #
+-- #                                                                                               #
+-- # 2. Redistributions in binary form must reproduce the above copyright notice, this list of     #
+-- #    conditions and the following disclaimer in the documentation and/or other materials        #
+-- #    provided with the distribution.                                                            #
+-- #                                                                                               #
+-- # 3. Neither the name of the copyright holder nor the names of its contributors may be used to  #
+-- #    endorse or promote products derived from this software without specific prior written      #
+-- #    permission.                                                                                #
+-- #                                                                                               #
+-- # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS   #
+-- # OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF               #
+-- # MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE    #
+-- # COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,     #
+-- # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE #
+-- # GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED    #
+-- # AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING     #
+-- # NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED  #
+-- # OF THE POSSIBILITY OF SUCH DAMAGE.                                                            #
+-- # ********************************************************************************************* #
+-- # https:/github.com/jesseopdenbrouw/thuas-riscv                                                 #
+-- #################################################################################################
+
+-- DMA controller
+--
+-- Four channels copy elements from a source address to a destination
+-- address over the data bus. A channel is started by a trigger: either
+-- always (memory to memory) or a DMA request from a peripheral (e.g.
+-- character received, transmitter empty). Lower channel numbers have
+-- priority. One element is transferred per request, after which the
+-- bus is released. The bus is obtained from the bus arbiter with a
+-- hold/grant handshake.
+--
+-- Register map (offsets from base):
+-- 0x00 STAT - bits 3:0 transfer complete, bits 7:4 bus error,
+--             write 1 to clear, bits 11:8 channel enabled (read only)
+-- 0x40 + 0x10*n - channel n CTRL
+--             bit 0 EN, cleared by hardware when done
+--             bit 1 TCIE, transfer complete/error interrupt enable
+--             bits 3:2 SSIZE, bits 5:4 DSIZE (00 byte, 01 halfword, 10 word)
+--             bit 6 SINC, bit 7 DINC, increment source/destination
+--             bits 11:8 TRIG, trigger select, 0 = always
+-- 0x44 + 0x10*n - channel n SRC
+-- 0x48 + 0x10*n - channel n DST
+-- 0x4c + 0x10*n - channel n CNT, number of elements (16 bits)
+
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.numeric_std.all;
+
+library work;
+use work.processor_common.all;
+
+entity dma is
+    port (I_clk : in std_logic;
+          I_areset : in std_logic;
+          I_sreset : in std_logic;
+          -- 
+          I_mem_request : in mem_request_type;
+          O_mem_response : out mem_response_type;
+          -- Bus master
+          O_bus_request : out bus_request_type;
+          I_bus_response : in bus_response_type;
+          O_bus_hold : out std_logic;
+          I_bus_grant : in std_logic;
+          --
+          I_trigger : in std_logic_vector(15 downto 0);
+          O_irq : out std_logic
+         );
+end entity dma;
+
+architecture rtl of dma is
+
+constant DMA_CHANNELS : integer := 4;
+
+type channel_type is record
+    en : std_logic;
+    tcie : std_logic;
+    ssize : std_logic_vector(1 downto 0);
+    dsize : std_logic_vector(1 downto 0);
+    sinc : std_logic;
+    dinc : std_logic;
+    trig : std_logic_vector(3 downto 0);
+    src : data_type;
+    dst : data_type;
+    cnt : unsigned(15 downto 0);
+    tc : std_logic;
+    err : std_logic;
+end record;
+type channel_array_type is array (0 to DMA_CHANNELS-1) of channel_type;
+signal ch : channel_array_type;
+
+type dmastate_type is (idle, grant, read_src, read_wait, write_dst, write_wait);
+type dma_type is record
+    state : dmastate_type;
+    cur : integer range 0 to DMA_CHANNELS-1;
+    acc : memaccess_type;
+    size : memsize_type;
+    addr : data_type;
+    data : data_type;
+end record;
+signal dma : dma_type;
+
+-- Channels requesting a transfer
+signal req : std_logic_vector(DMA_CHANNELS-1 downto 0);
+
+signal isword : boolean;
+
+-- Translate size field to bus size, 11 is treated as word
+function to_memsize(size : std_logic_vector(1 downto 0)) return memsize_type is
+begin
+    case size is
+        when "00" => return memsize_byte;
+        when "01" => return memsize_halfword;
+        when others => return memsize_word;
+    end case;
+end function;
+
+-- Next address, incremented by the size if requested
+function next_addr(addr : data_type; size : std_logic_vector(1 downto 0); inc : std_logic) return data_type is
+begin
+    if inc = '0' then
+        return addr;
+    end if;
+    case size is
+        when "00" => return std_logic_vector(unsigned(addr) + 1);
+        when "01" => return std_logic_vector(unsigned(addr) + 2);
+        when others => return std_logic_vector(unsigned(addr) + 4);
+    end case;
+end function;
+
+begin
+
+    -- Check for misaligned access
+    O_mem_response.load_misaligned_error <= '1' when I_mem_request.stb = '1' and I_mem_request.wren = '0' and I_mem_request.size = memsize_word and I_mem_request.addr(1 downto 0) /= "00" else '0';
+    O_mem_response.store_misaligned_error <= '1' when I_mem_request.stb = '1' and I_mem_request.wren = '1' and I_mem_request.size = memsize_word and I_mem_request.addr(1 downto 0) /= "00" else '0';
+    -- Check for unsuppored data size
+    O_mem_response.load_access_error <= '1' when I_mem_request.stb = '1' and I_mem_request.wren = '0' and I_mem_request.size /= memsize_word else '0';
+    O_mem_response.store_access_error <= '1' when I_mem_request.stb = '1' and I_mem_request.wren = '1' and I_mem_request.size /= memsize_word  else '0';
+    
+    -- Correct size and address boundary
+    isword <= I_mem_request.size = memsize_word and I_mem_request.addr(1 downto 0) = "00";
+
+    -- A channel requests a transfer if it is enabled, its trigger
+    -- is active and there are elements left
+    reqgen: for i in 0 to DMA_CHANNELS-1 generate
+        req(i) <= ch(i).en and I_trigger(to_integer(unsigned(ch(i).trig))) when ch(i).cnt /= 0 else '0';
+    end generate;
+
+    process (I_clk, I_areset) is
+    variable idx_v : integer range 0 to DMA_CHANNELS-1;
+    variable data_v : data_type;
+    begin
+        if I_areset = '1' then
+            for i in 0 to DMA_CHANNELS-1 loop
+                ch(i).en <= '0';
+                ch(i).tcie <= '0';
+                ch(i).ssize <= "00";
+                ch(i).dsize <= "00";
+                ch(i).sinc <= '0';
+                ch(i).dinc <= '0';
+                ch(i).trig <= (others => '0');
+                ch(i).src <= (others => '0');
+                ch(i).dst <= (others => '0');
+                ch(i).cnt <= (others => '0');
+                ch(i).tc <= '0';
+                ch(i).err <= '0';
+            end loop;
+            dma.state <= idle;
+            dma.cur <= 0;
+            dma.acc <= memaccess_nop;
+            dma.size <= memsize_unknown;
+            dma.addr <= (others => '0');
+            dma.data <= (others => '0');
+            O_mem_response.data <= all_zeros_c;
+            O_mem_response.ready <= '0';
+        elsif rising_edge(I_clk) then
+            O_mem_response.data <= all_zeros_c;
+            O_mem_response.ready <= '0';
+
+            if I_sreset = '1' then
+                for i in 0 to DMA_CHANNELS-1 loop
+                    ch(i).en <= '0';
+                    ch(i).tcie <= '0';
+                    ch(i).ssize <= "00";
+                    ch(i).dsize <= "00";
+                    ch(i).sinc <= '0';
+                    ch(i).dinc <= '0';
+                    ch(i).trig <= (others => '0');
+                    ch(i).src <= (others => '0');
+                    ch(i).dst <= (others => '0');
+                    ch(i).cnt <= (others => '0');
+                    ch(i).tc <= '0';
+                    ch(i).err <= '0';
+                end loop;
+                dma.state <= idle;
+                dma.cur <= 0;
+                dma.acc <= memaccess_nop;
+                dma.size <= memsize_unknown;
+                dma.addr <= (others => '0');
+                dma.data <= (others => '0');
+            else
+                -- Register access, 0x00 is status, 0x40 and up are channels
+                idx_v := to_integer(unsigned(I_mem_request.addr(5 downto 4)));
+                if I_mem_request.stb = '1' and isword then
+                    if I_mem_request.wren = '1' then
+                        -- Write
+                        if I_mem_request.addr(7 downto 2) = "000000" then
+                            -- Write 1 to clear, so that other flags are not lost
+                            for i in 0 to DMA_CHANNELS-1 loop
+                                if I_mem_request.data(i) = '1' then
+                                    ch(i).tc <= '0';
+                                end if;
+                                if I_mem_request.data(i+4) = '1' then
+                                    ch(i).err <= '0';
+                                end if;
+                            end loop;
+                        elsif I_mem_request.addr(7 downto 6) = "01" then
+                            case I_mem_request.addr(3 downto 2) is
+                                when "00" => ch(idx_v).en <= I_mem_request.data(0);
+                                             ch(idx_v).tcie <= I_mem_request.data(1);
+                                             ch(idx_v).ssize <= I_mem_request.data(3 downto 2);
+                                             ch(idx_v).dsize <= I_mem_request.data(5 downto 4);
+                                             ch(idx_v).sinc <= I_mem_request.data(6);
+                                             ch(idx_v).dinc <= I_mem_request.data(7);
+                                             ch(idx_v).trig <= I_mem_request.data(11 downto 8);
+                                when "01" => ch(idx_v).src <= I_mem_request.data;
+                                when "10" => ch(idx_v).dst <= I_mem_request.data;
+                                when "11" => ch(idx_v).cnt <= unsigned(I_mem_request.data(15 downto 0));
+                                when others => null;
+                            end case;
+                        end if;
+                    else
+                        -- Read
+                        if I_mem_request.addr(7 downto 2) = "000000" then
+                            for i in 0 to DMA_CHANNELS-1 loop
+                                O_mem_response.data(i) <= ch(i).tc;
+                                O_mem_response.data(i+4) <= ch(i).err;
+                                O_mem_response.data(i+8) <= ch(i).en;
+                            end loop;
+                        elsif I_mem_request.addr(7 downto 6) = "01" then
+                            case I_mem_request.addr(3 downto 2) is
+                                when "00" => O_mem_response.data(0) <= ch(idx_v).en;
+                                             O_mem_response.data(1) <= ch(idx_v).tcie;
+                                             O_mem_response.data(3 downto 2) <= ch(idx_v).ssize;
+                                             O_mem_response.data(5 downto 4) <= ch(idx_v).dsize;
+                                             O_mem_response.data(6) <= ch(idx_v).sinc;
+                                             O_mem_response.data(7) <= ch(idx_v).dinc;
+                                             O_mem_response.data(11 downto 8) <= ch(idx_v).trig;
+                                when "01" => O_mem_response.data <= ch(idx_v).src;
+                                when "10" => O_mem_response.data <= ch(idx_v).dst;
+                                when "11" => O_mem_response.data(15 downto 0) <= std_logic_vector(ch(idx_v).cnt);
+                                when others => null;
+                            end case;
+                        end if;
+                    end if;
+                    O_mem_response.ready <= '1';
+                end if;
+
+                -- The transfer engine
+                case dma.state is
+                    -- Select the requesting channel with the lowest number
+                    when idle =>
+                        dma.acc <= memaccess_nop;
+                        dma.size <= memsize_unknown;
+                        for i in DMA_CHANNELS-1 downto 0 loop
+                            if req(i) = '1' then
+                                dma.cur <= i;
+                                dma.addr <= ch(i).src;
+                                dma.size <= to_memsize(ch(i).ssize);
+                                dma.state <= grant;
+                            end if;
+                        end loop;
+                    -- Wait for the bus
+                    when grant =>
+                        if I_bus_grant = '1' then
+                            dma.acc <= memaccess_read;
+                            dma.state <= read_src;
+                        end if;
+                    -- Read source, strobe is active for one clock cycle
+                    when read_src | read_wait =>
+                        if I_bus_response.load_access_error = '1' or I_bus_response.load_misaligned_error = '1' then
+                            ch(dma.cur).en <= '0';
+                            ch(dma.cur).err <= '1';
+                            dma.state <= idle;
+                        elsif I_bus_response.ready = '1' then
+                            -- Only use the bits of the source size
+                            data_v := I_bus_response.data;
+                            case ch(dma.cur).ssize is
+                                when "00" => data_v(31 downto 8) := (others => '0');
+                                when "01" => data_v(31 downto 16) := (others => '0');
+                                when others => null;
+                            end case;
+                            dma.data <= data_v;
+                            dma.acc <= memaccess_write;
+                            dma.addr <= ch(dma.cur).dst;
+                            dma.size <= to_memsize(ch(dma.cur).dsize);
+                            dma.state <= write_dst;
+                        else
+                            dma.state <= read_wait;
+                        end if;
+                    -- Write destination, strobe is active for one clock cycle
+                    when write_dst | write_wait =>
+                        if I_bus_response.store_access_error = '1' or I_bus_response.store_misaligned_error = '1' then
+                            ch(dma.cur).en <= '0';
+                            ch(dma.cur).err <= '1';
+                            dma.state <= idle;
+                        elsif I_bus_response.ready = '1' then
+                            ch(dma.cur).src <= next_addr(ch(dma.cur).src, ch(dma.cur).ssize, ch(dma.cur).sinc);
+                            ch(dma.cur).dst <= next_addr(ch(dma.cur).dst, ch(dma.cur).dsize, ch(dma.cur).dinc);
+                            ch(dma.cur).cnt <= ch(dma.cur).cnt - 1;
+                            -- Last element, disable channel
+                            if ch(dma.cur).cnt = 1 then
+                                ch(dma.cur).en <= '0';
+                                ch(dma.cur).tc <= '1';
+                            end if;
+                            dma.acc <= memaccess_nop;
+                            dma.state <= idle;
+                        else
+                            dma.state <= write_wait;
+                        end if;
+                    when others =>
+                        dma.state <= idle;
+                end case;
+            end if; -- sreset
+        end if; -- rising_edge
+    end process;
+
+    -- Bus master signals
+    O_bus_request.stb <= '1' when dma.state = read_src or dma.state = write_dst else '0';
+    O_bus_request.acc <= dma.acc;
+    O_bus_request.size <= dma.size;
+    O_bus_request.addr <= dma.addr;
+    O_bus_request.data <= dma.data;
+    -- Keep the bus during the read and the write of an element
+    O_bus_hold <= '0' when dma.state = idle else '1';
+
+    -- Interrupt on transfer complete or bus error
+    process (ch) is
+    variable irq_v : std_logic;
+    begin
+        irq_v := '0';
+        for i in 0 to DMA_CHANNELS-1 loop
+            irq_v := irq_v or ((ch(i).tc or ch(i).err) and ch(i).tcie);
+        end loop;
+        O_irq <= irq_v;
+    end process;
+
+end architecture rtl;
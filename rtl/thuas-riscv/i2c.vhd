@@ -57,7 +57,10 @@ entity i2c is
           --
           IO_scl : inout std_logic;
           IO_sda : inout std_logic;
-          O_irq : out std_logic
+          O_irq : out std_logic;
+          -- DMA requests
+          O_rxready : out std_logic;
+          O_txempty : out std_logic
          );
 end entity i2c;
 
@@ -435,6 +438,10 @@ begin
     IO_scl <= '0' when i2c.scl_out = '0' else 'Z';
     IO_sda <= '0' when i2c.sda_out = '0' else 'Z';
     O_irq <= i2c.tcie and i2c.tc;
+
+    -- DMA requests: transfer complete, ready for a new transfer
+    O_rxready <= i2c.tc;
+    O_txempty <= '1' when i2c.state = idle and i2c.starttransmission = '0' else '0';
     
 
 end architecture rtl;
\ No newline at end of file
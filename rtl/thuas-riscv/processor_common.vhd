@@ -45,7 +45,7 @@ use ieee.numeric_std.all;
 package processor_common is
 
     -- Hardware version, BCD encoded
-    constant HW_VERSION : integer := 16#01_01_04_17#;
+    constant HW_VERSION : integer := 16#01_01_04_40#;
 
     
     -- Used data types
@@ -226,6 +226,45 @@ package processor_common is
         ack      : std_logic;
     end record;
     
+    -- Interrupt selected by the CLIC
+    type clic_request_type is record
+        valid : std_logic;
+        id : std_logic_vector(4 downto 0);
+        level : std_logic_vector(7 downto 0);
+        shv : std_logic;
+        vector : data_type;
+    end record;
+    constant clic_request_none_c : clic_request_type := (
+        valid => '0',
+        id => (others => '0'),
+        level => (others => '0'),
+        shv => '0',
+        vector => (others => '0')
+       );
+
+    -- Instruction trace event from the core
+    type trace_type is record
+        valid : std_logic;
+        kind : std_logic_vector(2 downto 0);
+        source : data_type;
+        target : data_type;
+    end record;
+    constant trace_none_c : trace_type := (
+        valid => '0',
+        kind => (others => '0'),
+        source => (others => '0'),
+        target => (others => '0')
+       );
+    -- Trace event kinds
+    constant trace_direct_c : std_logic_vector(2 downto 0) := "001";
+    constant trace_indirect_c : std_logic_vector(2 downto 0) := "010";
+    constant trace_trap_c : std_logic_vector(2 downto 0) := "011";
+    constant trace_mret_c : std_logic_vector(2 downto 0) := "100";
+    constant trace_chain_c : std_logic_vector(2 downto 0) := "101";
+    constant trace_resume_c : std_logic_vector(2 downto 0) := "110";
+    -- Size of the trace buffer in words is 2**bits
+    constant trace_address_bits_c : integer := 10;
+
     -- Constants
     constant all_zeros_c : data_type := (others => '0');
     constant all_ones_c : data_type := (others => '1');
@@ -318,6 +357,9 @@ package processor_common is
     constant mcause_addr : integer := 16#342#; -- 834
     constant mtval_addr : integer := 16#343#;
     constant mip_addr : integer := 16#344#;
+    -- CLIC interrupt level threshold and status
+    constant mintthresh_addr : integer := 16#347#;
+    constant mintstatus_addr : integer := 16#fb1#;
 
     -- M mode counters
     constant mcycle_addr : integer := 16#b00#; --
@@ -415,6 +457,8 @@ package processor_common is
     constant mhpmevent29_addr : integer := 16#33d#; --
     constant mhpmevent30_addr : integer := 16#33e#; --
     constant mhpmevent31_addr : integer := 16#33f#; --
+    -- Counter overflow flags (Sscofpmf)
+    constant scountovf_addr : integer := 16#da0#;
     
     -- Debug registers
     constant dcsr_addr : integer := 16#7b0#; --
@@ -428,6 +472,9 @@ package processor_common is
     -- M mode custom read-only
     constant mxhw_addr : integer := 16#fc0#;
     constant mxspeed_addr : integer := 16#fc1#;
+    constant mxhw2_addr : integer := 16#fc2#;
+    -- Shadow register bank control
+    constant mxbank_addr : integer := 16#7c0#;
    
     -- Constants for interrupt priority
     -- Changes here must be reflected in the interrupt handler in software
@@ -440,7 +487,7 @@ package processor_common is
     constant INTR_PRIO_SPI2   : integer := 25;
     constant INTR_PRIO_I2C2   : integer := 24;
     constant INTR_PRIO_UART1  : integer := 23;
-    constant INTR_PRIO_FREE22 : integer := 22;
+    constant INTR_PRIO_DMA    : integer := 22;
     constant INTR_PRIO_TIMER2 : integer := 21;
     constant INTR_PRIO_TIMER1 : integer := 20;
     constant INTR_PRIO_UART2  : integer := 19;
@@ -467,12 +514,22 @@ package processor_common is
                   OCD_CSR_CHECK_DISABLE : boolean;
                   -- Do we use post-increment address pointer when debugging?
                   OCD_AAMPOSTINCREMENT : boolean;                  
+                  -- Do we have System Bus Access when debugging?
+                  OCD_SYSBUS : boolean;
+                  -- Do we have the PC sample register when debugging?
+                  OCD_PCSAMPLE : boolean;
+                  -- Number of hardware triggers (1 to 4)
+                  OCD_TRIGGERS : integer;
                   -- RISCV E (embedded) of RISCV I (full)
                   HAVE_RISCV_E : boolean;
                   -- Do we have the integer multiply/divide unit?
                   HAVE_MULDIV : boolean;
                   -- Fast divide (needs more area)?
                   FAST_DIVIDE : boolean;
+                  -- Single-cycle multiply in execute stage?
+                  SINGLE_CYCLE_MULTIPLY : boolean;
+                  -- Early-terminating divider?
+                  EARLY_DIVIDE : boolean;
                   -- Do we have Zba (sh?add)
                   HAVE_ZBA : boolean;
                   -- Do we have Zbb (bit instructions)?
@@ -485,12 +542,24 @@ package processor_common is
                   HAVE_ZIMOP : boolean;
                   -- Have Zbkb (bitmanip instructions for cryptography)
                   HAVE_ZBKB : boolean;
+                  -- Do we have Zca (compressed instructions)?
+                  HAVE_ZCA : boolean;
+                  -- Do we have Zcb (extra compressed instructions)?
+                  HAVE_ZCB : boolean;
+                  -- Do we have Zcmp (compressed push/pop)?
+                  HAVE_ZCMP : boolean;
                   -- Do we have HPM counters?
                   HAVE_ZIHPM : boolean;
                   -- Do we enable vectored mode for mtvec?
                   VECTORED_MTVEC : boolean;
                   -- Do we have registers is RAM?
                   HAVE_REGISTERS_IN_RAM : boolean;
+                  -- Do we have branch prediction?
+                  HAVE_BRANCH_PREDICTION : boolean;
+                  -- Do we have a branch target buffer?
+                  HAVE_BTB : boolean;
+                  -- Do we have an instruction prefetch queue?
+                  HAVE_PREFETCH : boolean;
                   -- Address width in bits, size is 2**bits
                   ROM_ADDRESS_BITS : integer;
                   -- Address width in bits, size is 2**bits
@@ -507,6 +576,12 @@ package processor_common is
                   BUFFER_IO_RESPONSE : boolean;
                   -- Fast memory access (severly reduces Fmax)?
                   FAST_MEM : boolean;
+                  -- Single-cycle loads from ROM/RAM (needs FAST_MEM)?
+                  FAST_LOAD : boolean;
+                  -- Use posted store buffer?
+                  HAVE_STORE_BUFFER : boolean;
+                  -- Post stores to I/O (store buffer)?
+                  POST_IO_STORES : boolean;
                   -- Do we have UART1?
                   HAVE_UART1 : boolean;
                   -- Do we have UART1?
@@ -529,6 +604,14 @@ package processor_common is
                   HAVE_WDT : boolean;
                   -- Use CRC?
                   HAVE_CRC : boolean;
+                  -- Use DMA?
+                  HAVE_DMA : boolean;
+                  -- Use CLIC-style interrupt controller?
+                  HAVE_CLIC : boolean;
+                  -- Use a shadow register bank for interrupts?
+                  HAVE_SHADOW_REGS : boolean;
+                  -- Use the instruction trace buffer?
+                  HAVE_TRACE : boolean;
                   -- UART1 BREAK triggers system reset
                   UART1_BREAK_RESETS : boolean
              );
@@ -608,6 +691,15 @@ package processor_common is
     -- Count trailing zeros
     function count_trailing_zeros(input : data_type) return data_type;
 
+    -- Expand a compressed instruction
+    function expand_compressed(input : std_logic_vector(15 downto 0); zcb : boolean) return data_type;
+
+    -- Index of the last micro-operation of a Zcmp instruction, 0 if not Zcmp
+    function zcmp_last(input : std_logic_vector(15 downto 0)) return integer;
+
+    -- Micro-operation of a Zcmp instruction
+    function expand_zcmp(input : std_logic_vector(15 downto 0); step : integer) return data_type;
+
 end package processor_common;
 
 package body processor_common is
@@ -791,5 +883,303 @@ package body processor_common is
         end if;
         return std_logic_vector(to_unsigned(n_v, 32));
     end function count_trailing_zeros;
+
+    -- Expand a compressed (Zca) instruction to its 32-bit equivalent,
+    -- with Zcb if selected. Reserved encodings and the floating point
+    -- loads and stores expand to all zeros, which is an illegal instruction.
+    function expand_compressed(input : std_logic_vector(15 downto 0); zcb : boolean) return data_type is
+    variable rd_v, rs2_v : reg_type;
+    variable rdc_v, rs1c_v : reg_type;
+    variable imm_ci_v : std_logic_vector(11 downto 0);
+    variable imm_v : std_logic_vector(11 downto 0);
+    variable imm_b_v : std_logic_vector(12 downto 0);
+    variable imm_j_v : std_logic_vector(20 downto 0);
+    variable imm_u_v : std_logic_vector(19 downto 0);
+    variable instr_v : data_type;
+    variable op_v : std_logic_vector(4 downto 0);
+    begin
+        -- Quadrant and function
+        op_v := input(1 downto 0) & input(15 downto 13);
+        -- Full registers and the popular registers x8 to x15
+        rd_v := input(11 downto 7);
+        rs2_v := input(6 downto 2);
+        rdc_v := "01" & input(4 downto 2);
+        rs1c_v := "01" & input(9 downto 7);
+        -- Sign extended 6-bit immediate
+        imm_ci_v := (others => input(12));
+        imm_ci_v(4 downto 0) := input(6 downto 2);
+        -- Branch offset
+        imm_b_v := (others => input(12));
+        imm_b_v(7 downto 0) := input(6 downto 5) & input(2) & input(11 downto 10) & input(4 downto 3) & '0';
+        -- Jump offset
+        imm_j_v := (others => input(12));
+        imm_j_v(10 downto 0) := input(8) & input(10 downto 9) & input(6) & input(7) & input(2) & input(11) & input(5 downto 3) & '0';
+        imm_v := (others => '0');
+        imm_u_v := (others => '0');
+        instr_v := (others => '0');
+
+        case op_v is
+            -- C.ADDI4SPN
+            when "00000" =>
+                imm_v := "00" & input(10 downto 7) & input(12 downto 11) & input(5) & input(6) & "00";
+                if imm_v /= x"000" then
+                    instr_v := imm_v & "00010" & "000" & rdc_v & "0010011";
+                end if;
+            -- C.LW
+            when "00010" =>
+                imm_v := "00000" & input(5) & input(12 downto 10) & input(6) & "00";
+                instr_v := imm_v & rs1c_v & "010" & rdc_v & "0000011";
+            -- C.LBU, C.LHU, C.LH, C.SB, C.SH (Zcb)
+            when "00100" =>
+                if zcb then
+                    case input(12 downto 10) is
+                        when "000" =>
+                            instr_v := "0000000000" & input(5) & input(6) & rs1c_v & "100" & rdc_v & "0000011";
+                        when "001" =>
+                            if input(6) = '0' then
+                                instr_v := "0000000000" & input(5) & '0' & rs1c_v & "101" & rdc_v & "0000011";
+                            else
+                                instr_v := "0000000000" & input(5) & '0' & rs1c_v & "001" & rdc_v & "0000011";
+                            end if;
+                        when "010" =>
+                            instr_v := "0000000" & rdc_v & rs1c_v & "000" & "000" & input(5) & input(6) & "0100011";
+                        when "011" =>
+                            if input(6) = '0' then
+                                instr_v := "0000000" & rdc_v & rs1c_v & "001" & "000" & input(5) & '0' & "0100011";
+                            end if;
+                        when others =>
+                            null;
+                    end case;
+                end if;
+            -- C.SW
+            when "00110" =>
+                imm_v := "00000" & input(5) & input(12 downto 10) & input(6) & "00";
+                instr_v := imm_v(11 downto 5) & rdc_v & rs1c_v & "010" & imm_v(4 downto 0) & "0100011";
+            -- C.ADDI, C.NOP
+            when "01000" =>
+                instr_v := imm_ci_v & rd_v & "000" & rd_v & "0010011";
+            -- C.JAL
+            when "01001" =>
+                instr_v := imm_j_v(20) & imm_j_v(10 downto 1) & imm_j_v(11) & imm_j_v(19 downto 12) & "00001" & "1101111";
+            -- C.LI
+            when "01010" =>
+                instr_v := imm_ci_v & "00000" & "000" & rd_v & "0010011";
+            -- C.ADDI16SP, C.LUI
+            when "01011" =>
+                if input(12) & input(6 downto 2) /= "000000" then
+                    if rd_v = "00010" then
+                        imm_v := (others => input(12));
+                        imm_v(8 downto 0) := input(4 downto 3) & input(5) & input(2) & input(6) & "0000";
+                        instr_v := imm_v & "00010" & "000" & "00010" & "0010011";
+                    else
+                        imm_u_v := (others => input(12));
+                        imm_u_v(4 downto 0) := input(6 downto 2);
+                        instr_v := imm_u_v & rd_v & "0110111";
+                    end if;
+                end if;
+            -- C.SRLI, C.SRAI, C.ANDI, C.SUB, C.XOR, C.OR, C.AND
+            when "01100" =>
+                case input(11 downto 10) is
+                    when "00" =>
+                        if input(12) = '0' then
+                            instr_v := "0000000" & input(6 downto 2) & rs1c_v & "101" & rs1c_v & "0010011";
+                        end if;
+                    when "01" =>
+                        if input(12) = '0' then
+                            instr_v := "0100000" & input(6 downto 2) & rs1c_v & "101" & rs1c_v & "0010011";
+                        end if;
+                    when "10" =>
+                        instr_v := imm_ci_v & rs1c_v & "111" & rs1c_v & "0010011";
+                    when others =>
+                        if input(12) = '0' then
+                            case input(6 downto 5) is
+                                when "00" => instr_v := "0100000" & rdc_v & rs1c_v & "000" & rs1c_v & "0110011";
+                                when "01" => instr_v := "0000000" & rdc_v & rs1c_v & "100" & rs1c_v & "0110011";
+                                when "10" => instr_v := "0000000" & rdc_v & rs1c_v & "110" & rs1c_v & "0110011";
+                                when others => instr_v := "0000000" & rdc_v & rs1c_v & "111" & rs1c_v & "0110011";
+                            end case;
+                        -- C.MUL, C.ZEXT.B, C.SEXT.B, C.ZEXT.H, C.SEXT.H, C.NOT (Zcb)
+                        elsif zcb then
+                            if input(6 downto 5) = "10" then
+                                instr_v := "0000001" & rdc_v & rs1c_v & "000" & rs1c_v & "0110011";
+                            elsif input(6 downto 5) = "11" then
+                                case input(4 downto 2) is
+                                    when "000" => instr_v := x"0ff" & rs1c_v & "111" & rs1c_v & "0010011";
+                                    when "001" => instr_v := "011000000100" & rs1c_v & "001" & rs1c_v & "0010011";
+                                    when "010" => instr_v := "000010000000" & rs1c_v & "100" & rs1c_v & "0110011";
+                                    when "011" => instr_v := "011000000101" & rs1c_v & "001" & rs1c_v & "0010011";
+                                    when "101" => instr_v := x"fff" & rs1c_v & "100" & rs1c_v & "0010011";
+                                    when others => null;
+                                end case;
+                            end if;
+                        end if;
+                end case;
+            -- C.J
+            when "01101" =>
+                instr_v := imm_j_v(20) & imm_j_v(10 downto 1) & imm_j_v(11) & imm_j_v(19 downto 12) & "00000" & "1101111";
+            -- C.BEQZ
+            when "01110" =>
+                instr_v := imm_b_v(12) & imm_b_v(10 downto 5) & "00000" & rs1c_v & "000" & imm_b_v(4 downto 1) & imm_b_v(11) & "1100011";
+            -- C.BNEZ
+            when "01111" =>
+                instr_v := imm_b_v(12) & imm_b_v(10 downto 5) & "00000" & rs1c_v & "001" & imm_b_v(4 downto 1) & imm_b_v(11) & "1100011";
+            -- C.SLLI
+            when "10000" =>
+                if input(12) = '0' then
+                    instr_v := "0000000" & input(6 downto 2) & rd_v & "001" & rd_v & "0010011";
+                end if;
+            -- C.LWSP
+            when "10010" =>
+                if rd_v /= "00000" then
+                    imm_v := "0000" & input(3 downto 2) & input(12) & input(6 downto 4) & "00";
+                    instr_v := imm_v & "00010" & "010" & rd_v & "0000011";
+                end if;
+            -- C.JR, C.MV, C.EBREAK, C.JALR, C.ADD
+            when "10100" =>
+                if input(12) = '0' then
+                    if rs2_v = "00000" then
+                        if rd_v /= "00000" then
+                            instr_v := x"000" & rd_v & "000" & "00000" & "1100111";
+                        end if;
+                    else
+                        instr_v := "0000000" & rs2_v & "00000" & "000" & rd_v & "0110011";
+                    end if;
+                else
+                    if rs2_v = "00000" then
+                        if rd_v = "00000" then
+                            instr_v := x"00100073";
+                        else
+                            instr_v := x"000" & rd_v & "000" & "00001" & "1100111";
+                        end if;
+                    else
+                        instr_v := "0000000" & rs2_v & rd_v & "000" & rd_v & "0110011";
+                    end if;
+                end if;
+            -- C.SWSP
+            when "10110" =>
+                imm_v := "0000" & input(8 downto 7) & input(12 downto 9) & "00";
+                instr_v := imm_v(11 downto 5) & rs2_v & "00010" & "010" & imm_v(4 downto 0) & "0100011";
+            when others =>
+                null;
+        end case;
+        return instr_v;
+    end function expand_compressed;
+
+    -- Zcmp instructions are executed as a sequence of micro-operations.
+    -- CM.PUSH stores the registers below the stack pointer and then
+    -- adjusts the stack pointer. CM.POP, CM.POPRET and CM.POPRETZ load
+    -- the registers, adjust the stack pointer and optionally clear a0
+    -- and return. CM.MVSA01 and CM.MVA01S are two moves.
+    -- Index of the last micro-operation, 0 if not a Zcmp instruction.
+    function zcmp_last(input : std_logic_vector(15 downto 0)) return integer is
+    variable n_v : integer range 0 to 13;
+    begin
+        if input(1 downto 0) /= "10" or input(15 downto 13) /= "101" then
+            return 0;
+        end if;
+        -- CM.MVSA01, CM.MVA01S
+        if input(12 downto 10) = "011" and input(5) = '1' then
+            return 1;
+        end if;
+        -- CM.PUSH, CM.POP, CM.POPRETZ, CM.POPRET with rlist >= 4
+        if input(12 downto 11) /= "11" or input(8) /= '0' or input(7 downto 6) = "00" then
+            return 0;
+        end if;
+        if input(7 downto 4) = "1111" then
+            n_v := 13;
+        else
+            n_v := to_integer(unsigned(input(7 downto 4))) - 3;
+        end if;
+        case input(10 downto 9) is
+            when "10" => return n_v + 2;
+            when "11" => return n_v + 1;
+            when others => return n_v;
+        end case;
+    end function zcmp_last;
+
+    -- Micro-operation step of a Zcmp instruction
+    function expand_zcmp(input : std_logic_vector(15 downto 0); step : integer) return data_type is
+    variable n_v : integer range 0 to 13;
+    variable j_v : integer range 0 to 15;
+    variable adj_v : integer range 0 to 112;
+    variable reg_v, r1s_v, r2s_v : reg_type;
+    variable imm_v : std_logic_vector(11 downto 0);
+    variable instr_v : data_type;
+    begin
+        instr_v := (others => '0');
+        -- CM.MVSA01, CM.MVA01S, s0-s7 are x8, x9, x18-x23
+        if input(12 downto 10) = "011" then
+            if input(9 downto 8) = "00" then
+                r1s_v := "0100" & input(7);
+            else
+                r1s_v := "10" & input(9 downto 7);
+            end if;
+            if input(4 downto 3) = "00" then
+                r2s_v := "0100" & input(2);
+            else
+                r2s_v := "10" & input(4 downto 2);
+            end if;
+            if input(6) = '0' then
+                -- r1s' = a0, r2s' = a1
+                if step = 0 then
+                    instr_v := x"000" & "01010" & "000" & r1s_v & "0010011";
+                else
+                    instr_v := x"000" & "01011" & "000" & r2s_v & "0010011";
+                end if;
+            else
+                -- a0 = r1s', a1 = r2s'
+                if step = 0 then
+                    instr_v := x"000" & r1s_v & "000" & "01010" & "0010011";
+                else
+                    instr_v := x"000" & r2s_v & "000" & "01011" & "0010011";
+                end if;
+            end if;
+            return instr_v;
+        end if;
+
+        -- Number of registers in the list ra, s0-s11
+        if input(7 downto 4) = "1111" then
+            n_v := 13;
+        else
+            n_v := to_integer(unsigned(input(7 downto 4))) - 3;
+        end if;
+        -- Stack adjustment, multiple of 16 bytes
+        adj_v := ((n_v + 3) / 4) * 16 + to_integer(unsigned(input(3 downto 2))) * 16;
+
+        if step < n_v then
+            -- Registers are stored/loaded from s11 down to ra
+            j_v := n_v - 1 - step;
+            case j_v is
+                when 0 => reg_v := "00001";
+                when 1 => reg_v := "01000";
+                when 2 => reg_v := "01001";
+                when others => reg_v := std_logic_vector(to_unsigned(15 + j_v, 5));
+            end case;
+            if input(10 downto 9) = "00" then
+                -- SW reg, -4*(step+1)(sp)
+                imm_v := std_logic_vector(to_signed(-4 * (step + 1), 12));
+                instr_v := imm_v(11 downto 5) & reg_v & "00010" & "010" & imm_v(4 downto 0) & "0100011";
+            else
+                -- LW reg, adj-4*(step+1)(sp)
+                imm_v := std_logic_vector(to_signed(adj_v - 4 * (step + 1), 12));
+                instr_v := imm_v & "00010" & "010" & reg_v & "0000011";
+            end if;
+        elsif input(10 downto 9) = "00" then
+            -- ADDI sp, sp, -adj
+            imm_v := std_logic_vector(to_signed(-adj_v, 12));
+            instr_v := imm_v & "00010" & "000" & "00010" & "0010011";
+        elsif input(10 downto 9) = "10" and step = n_v then
+            -- LI a0, 0
+            instr_v := x"000" & "00000" & "000" & "01010" & "0010011";
+        elsif step = zcmp_last(input) and input(10 downto 9) /= "01" then
+            -- JALR x0, 0(ra)
+            instr_v := x"000" & "00001" & "000" & "00000" & "1100111";
+        else
+            -- ADDI sp, sp, adj
+            imm_v := std_logic_vector(to_signed(adj_v, 12));
+            instr_v := imm_v & "00010" & "000" & "00010" & "0010011";
+        end if;
+        return instr_v;
+    end function expand_zcmp;
     
 end package body processor_common;
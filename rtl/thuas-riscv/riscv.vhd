@@ -63,12 +63,22 @@ entity riscv is
           OCD_CSR_CHECK_DISABLE : boolean;
           -- Do we use post-increment address pointer when debugging?
           OCD_AAMPOSTINCREMENT : boolean;
+          -- Do we have System Bus Access when debugging?
+          OCD_SYSBUS : boolean;
+          -- Do we have the PC sample register when debugging?
+          OCD_PCSAMPLE : boolean;
+          -- Number of hardware triggers (1 to 4)
+          OCD_TRIGGERS : integer;
           -- RISCV E (embedded) of RISCV I (full)
           HAVE_RISCV_E : boolean;
           -- Do we have the integer multiply/divide unit?
           HAVE_MULDIV : boolean;
           -- Fast divide (needs more area)?
           FAST_DIVIDE : boolean;
+          -- Single-cycle multiply in execute stage?
+          SINGLE_CYCLE_MULTIPLY : boolean;
+          -- Early-terminating divider?
+          EARLY_DIVIDE : boolean;
           -- Do we have Zba (sh?add)
           HAVE_ZBA : boolean;
           -- Do we have Zbb (bit instructions)?
@@ -81,12 +91,24 @@ entity riscv is
           HAVE_ZIMOP : boolean;
           -- Have Zbkb (bitmanip instructions for cryptography)
           HAVE_ZBKB : boolean;
+          -- Do we have Zca (compressed instructions)?
+          HAVE_ZCA : boolean;
+          -- Do we have Zcb (extra compressed instructions)?
+          HAVE_ZCB : boolean;
+          -- Do we have Zcmp (compressed push/pop)?
+          HAVE_ZCMP : boolean;
           -- Do we have HPM counters?
           HAVE_ZIHPM : boolean;
           -- Do we enable vectored mode for mtvec?
           VECTORED_MTVEC : boolean;
           -- Do we have registers is RAM?
           HAVE_REGISTERS_IN_RAM : boolean;
+          -- Do we have branch prediction?
+          HAVE_BRANCH_PREDICTION : boolean;
+          -- Do we have a branch target buffer?
+          HAVE_BTB : boolean;
+          -- Do we have an instruction prefetch queue?
+          HAVE_PREFETCH : boolean;
           -- Address width in bits, size is 2**bits
           ROM_ADDRESS_BITS : integer;
           -- Address width in bits, size is 2**bits
@@ -103,6 +125,12 @@ entity riscv is
           BUFFER_IO_RESPONSE : boolean;
           -- Fast memory access (severly reduces Fmax)?
           FAST_MEM : boolean;
+          -- Single-cycle loads from ROM/RAM (needs FAST_MEM)?
+          FAST_LOAD : boolean;
+          -- Use posted store buffer?
+          HAVE_STORE_BUFFER : boolean;
+          -- Post stores to I/O (store buffer)?
+          POST_IO_STORES : boolean;
           -- Do we have UART1?
           HAVE_UART1 : boolean;
           -- Do we have UART1?
@@ -125,6 +153,14 @@ entity riscv is
           HAVE_WDT : boolean;
           -- Use CRC?
           HAVE_CRC : boolean;
+          -- Use DMA?
+          HAVE_DMA : boolean;
+          -- Use CLIC-style interrupt controller?
+          HAVE_CLIC : boolean;
+          -- Use a shadow register bank for interrupts?
+          HAVE_SHADOW_REGS : boolean;
+          -- Use the instruction trace buffer?
+          HAVE_TRACE : boolean;
           -- UART1 BREAK triggers system reset
           UART1_BREAK_RESETS : boolean
          );
@@ -179,10 +215,16 @@ component core is
           HAVE_OCD : boolean;
           -- Disable CSR address check when in debug mode
           OCD_CSR_CHECK_DISABLE : boolean;
+          -- Number of hardware triggers
+          OCD_TRIGGERS : integer;
           -- Do we have the integer multiply/divide unit?
           HAVE_MULDIV : boolean;
           -- Fast divide (needs more area)?
           FAST_DIVIDE : boolean;
+          -- Single-cycle multiply in execute stage?
+          SINGLE_CYCLE_MULTIPLY : boolean;
+          -- Early-terminating divider?
+          EARLY_DIVIDE : boolean;
           -- Do we have Zba (sh?add)
           HAVE_ZBA : boolean;
           -- Do we have Zbb (bit instructions)?
@@ -195,22 +237,40 @@ component core is
           HAVE_ZIMOP : boolean;
           -- Have Zbkb (bitmanip instructions for Cryptography)
           HAVE_ZBKB : boolean;
+          -- Do we have Zca (compressed instructions)?
+          HAVE_ZCA : boolean;
+          -- Do we have Zcb (extra compressed instructions)?
+          HAVE_ZCB : boolean;
+          -- Do we have Zcmp (compressed push/pop)?
+          HAVE_ZCMP : boolean;
           -- Do we have HPM counters?
           HAVE_ZIHPM : boolean;
           -- Do we enable vectored mode for mtvec?
           VECTORED_MTVEC : boolean;
           -- Do we have registers is RAM?
           HAVE_REGISTERS_IN_RAM : boolean;
+          -- Do we have branch prediction?
+          HAVE_BRANCH_PREDICTION : boolean;
+          -- Do we have a branch target buffer?
+          HAVE_BTB : boolean;
+          -- Do we have an instruction prefetch queue?
+          HAVE_PREFETCH : boolean;
           -- If bootloader enabled, adjust the boot address
           HAVE_BOOTLOADER_ROM : boolean;
           -- 4 high bits of ROM address
           ROM_HIGH_NIBBLE : memory_high_nibble;
           -- 4 high bits of boot ROM address
           BOOT_HIGH_NIBBLE : memory_high_nibble;
+          -- 4 high bits of RAM address
+          RAM_HIGH_NIBBLE : memory_high_nibble;
           -- Buffer I/O response
           BUFFER_IO_RESPONSE : boolean;
           -- Fast memory access (severly reduces Fmax)?
           FAST_MEM : boolean;
+          -- Single-cycle loads from ROM/RAM (needs FAST_MEM)?
+          FAST_LOAD : boolean;
+          -- Use posted store buffer?
+          HAVE_STORE_BUFFER : boolean;
           -- Do we have UART1?
           HAVE_UART1 : boolean;
           -- Do we have UART2?
@@ -233,6 +293,14 @@ component core is
           HAVE_WDT : boolean;
           -- Use CRC?
           HAVE_CRC : boolean;
+          -- Use DMA?
+          HAVE_DMA : boolean;
+          -- Use CLIC-style interrupt controller?
+          HAVE_CLIC : boolean;
+          -- Use a shadow register bank for interrupts?
+          HAVE_SHADOW_REGS : boolean;
+          -- Use the instruction trace buffer?
+          HAVE_TRACE : boolean;
           -- UART1 BREAK triggers system reset
           UART1_BREAK_RESETS : boolean
          );
@@ -246,11 +314,17 @@ component core is
           O_bus_request : out bus_request_type;
           -- from memory
           I_bus_response : in bus_response_type;
+          -- All posted stores are written
+          I_store_buffer_empty : in std_logic;
           -- Interrupt signals from I/O
           I_intrio : data_type;
+          -- Interrupt selected by the CLIC
+          I_clic : in clic_request_type;
           -- time from the memory mapped I/O
           I_mtime : in data_type;
           I_mtimeh : in data_type;
+          -- Instruction trace events
+          O_trace : out trace_type;
           -- Debug signals
           I_dm_core_data_request : in dm_core_data_request_type;
           O_dm_core_data_response : out dm_core_data_response_type;
@@ -259,7 +333,9 @@ component core is
           I_ackhavereset : in std_logic;
           O_halt_ack : out std_logic;
           O_reset_ack : out std_logic;
-          O_resume_ack : out std_logic
+          O_resume_ack : out std_logic;
+          -- PC of the last retired instruction
+          O_pcsample : out data_type
          );
 end component core;
 component address_decode is
@@ -358,7 +434,9 @@ component dtm is
 end component dtm;
 component dm is
     generic (
-          OCD_AAMPOSTINCREMENT : boolean
+          OCD_AAMPOSTINCREMENT : boolean;
+          OCD_SYSBUS : boolean;
+          OCD_PCSAMPLE : boolean
          );
     port (
           I_clk : std_logic;
@@ -376,7 +454,14 @@ component dm is
           I_resume_ack : in std_logic;     
           O_ackhavereset : out std_logic;     
           O_dm_core_data_request : out dm_core_data_request_type;
-          I_dm_core_data_response : in dm_core_data_response_type
+          I_dm_core_data_response : in dm_core_data_response_type;
+          -- System Bus Access
+          O_bus_request : out bus_request_type;
+          I_bus_response : in bus_response_type;
+          O_bus_hold : out std_logic;
+          I_bus_grant : in std_logic;
+          -- PC sampling
+          I_pcsample : in data_type
          );
 end component dm;
 --
@@ -542,7 +627,9 @@ component uart is
           I_rxd : in std_logic;
           O_txd: out std_logic;
           O_break_received : out std_logic;
-          O_irq : out std_logic
+          O_irq : out std_logic;
+          O_rxready : out std_logic;
+          O_txempty : out std_logic
          );
 end component uart;    
 
@@ -561,7 +648,9 @@ component i2c is
           --
           IO_scl : inout std_logic;
           IO_sda : inout std_logic;
-          O_irq : out std_logic
+          O_irq : out std_logic;
+          O_rxready : out std_logic;
+          O_txempty : out std_logic
          );
 end component i2c;
 
@@ -578,7 +667,9 @@ component spi is
           O_sck : out std_logic;
           O_mosi : out std_logic;
           I_miso : in std_logic;
-          O_irq : out std_logic
+          O_irq : out std_logic;
+          O_rxready : out std_logic;
+          O_txempty : out std_logic
          );
 end component spi;
 
@@ -613,6 +704,106 @@ component crc is
          );
 end component crc;
 
+-- DMA controller
+component dma is
+    port (
+          I_clk : in std_logic;
+          I_areset : in std_logic;
+          I_sreset : in std_logic;
+          -- 
+          I_mem_request : in mem_request_type;
+          O_mem_response : out mem_response_type;
+          --
+          O_bus_request : out bus_request_type;
+          I_bus_response : in bus_response_type;
+          O_bus_hold : out std_logic;
+          I_bus_grant : in std_logic;
+          --
+          I_trigger : in std_logic_vector(15 downto 0);
+          O_irq : out std_logic
+         );
+end component dma;
+
+-- CLIC-style interrupt controller
+component clic is
+    port (
+          I_clk : in std_logic;
+          I_areset : in std_logic;
+          I_sreset : in std_logic;
+          -- 
+          I_mem_request : in mem_request_type;
+          O_mem_response : out mem_response_type;
+          --
+          I_intrio : in data_type;
+          O_clic : out clic_request_type
+         );
+end component clic;
+
+-- Instruction trace buffer
+component trace is
+    generic (
+          TRACE_ADDRESS_BITS : integer
+         );
+    port (
+          I_clk : in std_logic;
+          I_areset : in std_logic;
+          I_sreset : in std_logic;
+          -- 
+          I_mem_request : in mem_request_type;
+          O_mem_response : out mem_response_type;
+          --
+          I_trace : in trace_type
+         );
+end component trace;
+
+-- Posted store buffer between core and data bus
+component store_buffer is
+    generic (
+          POST_IO_STORES : boolean;
+          ROM_WRITABLE : boolean;
+          ROM_HIGH_NIBBLE : memory_high_nibble;
+          RAM_HIGH_NIBBLE : memory_high_nibble;
+          IO_HIGH_NIBBLE : memory_high_nibble
+         );
+    port (
+          I_clk : in std_logic;
+          I_areset : in std_logic;
+          I_sreset : in std_logic;
+          --
+          I_bus_request : in bus_request_type;
+          O_bus_response : out bus_response_type;
+          O_empty : out std_logic;
+          --
+          O_bus_request : out bus_request_type;
+          I_bus_response : in bus_response_type
+         );
+end component store_buffer;
+
+-- Data bus arbiter between core, DMA and DM
+component bus_arbiter is
+    port (
+          I_clk : in std_logic;
+          I_areset : in std_logic;
+          I_sreset : in std_logic;
+          --
+          I_bus_request_core : in bus_request_type;
+          O_bus_response_core : out bus_response_type;
+          --
+          I_bus_request_dma : in bus_request_type;
+          O_bus_response_dma : out bus_response_type;
+          I_bus_hold_dma : in std_logic;
+          O_bus_grant_dma : out std_logic;
+          --
+          I_bus_request_dm : in bus_request_type;
+          O_bus_response_dm : out bus_response_type;
+          I_bus_hold_dm : in std_logic;
+          O_bus_grant_dm : out std_logic;
+          --
+          O_bus_request : out bus_request_type;
+          I_bus_response : in bus_response_type
+         );
+end component bus_arbiter;
+
 --Generic stub for I/O
 component stub is
     port (
@@ -638,9 +829,26 @@ signal instr_response_boot_int : instr_response2_type;
 signal instr_request_ram_int : instr_request_type;
 signal instr_response_ram_int : instr_response2_type;
 
--- Memory access signals from core to address decoder
+-- Memory access signals from core to store buffer
+signal bus_request_core_int : bus_request_type;
+signal bus_response_core_int : bus_response_type;
+signal store_buffer_empty_int : std_logic;
+-- Memory access signals from store buffer to bus arbiter
 signal bus_request_int : bus_request_type;
 signal bus_response_int : bus_response_type;
+-- Memory access signals from DMA to bus arbiter
+signal bus_request_dma_int : bus_request_type;
+signal bus_response_dma_int : bus_response_type;
+signal bus_hold_dma_int : std_logic;
+signal bus_grant_dma_int : std_logic;
+-- Memory access signals from DM (System Bus Access) to bus arbiter
+signal bus_request_dm_int : bus_request_type;
+signal bus_response_dm_int : bus_response_type;
+signal bus_hold_dm_int : std_logic;
+signal bus_grant_dm_int : std_logic;
+-- Memory access signals from bus arbiter to address decoder
+signal bus_request_arb_int : bus_request_type;
+signal bus_response_arb_int : bus_response_type;
 -- Memory access signals from address decoder to memories
 signal mem_request_rom_int : mem_request_type;
 signal mem_request_boot_int : mem_request_type;
@@ -657,6 +865,10 @@ signal mtimeh_int : data_type;
 
 -- Interrupts from I/O to core
 signal intrio_int : data_type;
+signal clic_int : clic_request_type;
+
+-- Instruction trace events from core to trace buffer
+signal trace_int : trace_type;
 
 -- Signals for reset
 signal areset_sys_sync_int : std_logic_vector(3 downto 0);
@@ -679,6 +891,8 @@ signal ackhavereset_int : std_logic;
 -- DM to core data signals
 signal dm_core_data_request_int : dm_core_data_request_type;
 signal dm_core_data_response_int : dm_core_data_response_type;
+-- PC of the last retired instruction from core to DM
+signal pcsample_int : data_type;
 
 -- Buses between I/O bus switch and I/O modules
 signal gpioa_request_int : mem_request_type;
@@ -707,12 +921,12 @@ signal uart2_request_int : mem_request_type;
 signal uart2_response_int : mem_response_type;
 signal crc_request_int : mem_request_type;
 signal crc_response_int : mem_response_type;
-signal stub13_request_int : mem_request_type;
-signal stub13_response_int : mem_response_type;
-signal stub14_request_int : mem_request_type;
-signal stub14_response_int : mem_response_type;
-signal stub15_request_int : mem_request_type;
-signal stub15_response_int : mem_response_type;
+signal dma_request_int : mem_request_type;
+signal dma_response_int : mem_response_type;
+signal clic_request_int : mem_request_type;
+signal clic_response_int : mem_response_type;
+signal trace_request_int : mem_request_type;
+signal trace_response_int : mem_response_type;
 
 -- IRQ signals
 signal irq_gpioa_int : std_logic;
@@ -727,6 +941,16 @@ signal irq_spi2_int : std_logic;
 signal irq_timer1_int : std_logic;
 signal irq_timer2_int : std_logic;
 signal irq_uart2_int : std_logic;
+signal irq_dma_int : std_logic;
+
+-- DMA request signals from I/O to DMA
+signal dma_trigger_int : std_logic_vector(15 downto 0);
+signal uart1_rxready_int, uart1_txempty_int : std_logic;
+signal uart2_rxready_int, uart2_txempty_int : std_logic;
+signal spi1_rxready_int, spi1_txempty_int : std_logic;
+signal spi2_rxready_int, spi2_txempty_int : std_logic;
+signal i2c1_rxready_int, i2c1_txempty_int : std_logic;
+signal i2c2_rxready_int, i2c2_txempty_int : std_logic;
 
 -- Have synchronous reset?
 type reset_type is (full_async, full_sync);
@@ -795,22 +1019,34 @@ begin
               HAVE_RISCV_E => HAVE_RISCV_E,
               HAVE_OCD => HAVE_OCD,
               OCD_CSR_CHECK_DISABLE => OCD_CSR_CHECK_DISABLE,
+              OCD_TRIGGERS => OCD_TRIGGERS,
               HAVE_MULDIV => HAVE_MULDIV,
               FAST_DIVIDE => FAST_DIVIDE,
+              SINGLE_CYCLE_MULTIPLY => SINGLE_CYCLE_MULTIPLY,
+              EARLY_DIVIDE => EARLY_DIVIDE,
               HAVE_ZBA => HAVE_ZBA,
               HAVE_ZBB => HAVE_ZBB,
               HAVE_ZBS => HAVE_ZBS,
               HAVE_ZICOND => HAVE_ZICOND,
               HAVE_ZIMOP => HAVE_ZIMOP,
               HAVE_ZBKB => HAVE_ZBKB,
+              HAVE_ZCA => HAVE_ZCA,
+              HAVE_ZCB => HAVE_ZCB,
+              HAVE_ZCMP => HAVE_ZCMP,
               HAVE_ZIHPM => HAVE_ZIHPM,
               VECTORED_MTVEC => VECTORED_MTVEC,
               HAVE_REGISTERS_IN_RAM => HAVE_REGISTERS_IN_RAM,
+              HAVE_BRANCH_PREDICTION => HAVE_BRANCH_PREDICTION,
+              HAVE_BTB => HAVE_BTB,
+              HAVE_PREFETCH => HAVE_PREFETCH,
               HAVE_BOOTLOADER_ROM => HAVE_BOOTLOADER_ROM,
               ROM_HIGH_NIBBLE => ROM_HIGH_NIBBLE,
               BOOT_HIGH_NIBBLE => BOOT_HIGH_NIBBLE,
+              RAM_HIGH_NIBBLE => RAM_HIGH_NIBBLE,
               BUFFER_IO_RESPONSE => BUFFER_IO_RESPONSE,
               FAST_MEM => FAST_MEM,
+              FAST_LOAD => FAST_LOAD,
+              HAVE_STORE_BUFFER => HAVE_STORE_BUFFER,
               HAVE_UART1 => HAVE_UART1,
               HAVE_UART2 => HAVE_UART2,
               HAVE_SPI1 => HAVE_SPI1,
@@ -822,6 +1058,10 @@ begin
               HAVE_MSI => HAVE_MSI,
               HAVE_WDT => HAVE_WDT,
               HAVE_CRC => HAVE_CRC,
+              HAVE_DMA => HAVE_DMA,
+              HAVE_CLIC => HAVE_CLIC,
+              HAVE_SHADOW_REGS => HAVE_SHADOW_REGS,
+              HAVE_TRACE => HAVE_TRACE,
               UART1_BREAK_RESETS => UART1_BREAK_RESETS
              )
     port map (I_clk => clk_int,
@@ -831,13 +1071,17 @@ begin
               O_instr_request => instr_request_int,
               I_instr_response => instr_response_int,
               -- Data fetch/store
-              O_bus_request => bus_request_int,
-              I_bus_response => bus_response_int,
+              O_bus_request => bus_request_core_int,
+              I_bus_response => bus_response_core_int,
+              I_store_buffer_empty => store_buffer_empty_int,
               -- Pending insterrupts
               I_intrio => intrio_int,
+              I_clic => clic_int,
               -- [m]time
               I_mtime => mtime_int,
               I_mtimeh => mtimeh_int,
+              -- Instruction trace events
+              O_trace => trace_int,
               -- Debug signals
               I_dm_core_data_request => dm_core_data_request_int,
               O_dm_core_data_response => dm_core_data_response_int,
@@ -846,7 +1090,8 @@ begin
               I_ackhavereset => ackhavereset_int,
               O_halt_ack => halt_ack_int,
               O_reset_ack => reset_ack_int,
-              O_resume_ack => resume_ack_int
+              O_resume_ack => resume_ack_int,
+              O_pcsample => pcsample_int
              );
     
     address_decode0: address_decode
@@ -858,8 +1103,8 @@ begin
               IO_HIGH_NIBBLE => IO_HIGH_NIBBLE
              )
     port map (              --
-              I_bus_request => bus_request_int,
-              O_bus_response => bus_response_int,
+              I_bus_request => bus_request_arb_int,
+              O_bus_response => bus_response_arb_int,
               --
               O_mem_request_rom => mem_request_rom_int,
               O_mem_request_boot => mem_request_boot_int,
@@ -872,6 +1117,63 @@ begin
               I_mem_response_io => mem_response_io_int
     );
     
+    -- Posted stores are written in the background
+    store_buffergen : if HAVE_STORE_BUFFER generate
+        store_buffer0: store_buffer
+        generic map (
+                  POST_IO_STORES => POST_IO_STORES,
+                  ROM_WRITABLE => HAVE_OCD or HAVE_BOOTLOADER_ROM,
+                  ROM_HIGH_NIBBLE => ROM_HIGH_NIBBLE,
+                  RAM_HIGH_NIBBLE => RAM_HIGH_NIBBLE,
+                  IO_HIGH_NIBBLE => IO_HIGH_NIBBLE
+                 )
+        port map (I_clk => clk_int,
+                  I_areset => areset_sys_int,
+                  I_sreset => sreset_sys_int,
+                  --
+                  I_bus_request => bus_request_core_int,
+                  O_bus_response => bus_response_core_int,
+                  O_empty => store_buffer_empty_int,
+                  --
+                  O_bus_request => bus_request_int,
+                  I_bus_response => bus_response_int
+                 );
+    end generate;
+    store_buffergen_not : if not HAVE_STORE_BUFFER generate
+        bus_request_int <= bus_request_core_int;
+        bus_response_core_int <= bus_response_int;
+        store_buffer_empty_int <= '1';
+    end generate;
+
+    -- With DMA or System Bus Access, the core, the DMA and the DM share the data bus
+    bus_arbitergen : if HAVE_DMA or (HAVE_OCD and OCD_SYSBUS) generate
+        bus_arbiter0: bus_arbiter
+        port map (I_clk => clk_int,
+                  I_areset => areset_sys_int,
+                  I_sreset => sreset_sys_int,
+                  --
+                  I_bus_request_core => bus_request_int,
+                  O_bus_response_core => bus_response_int,
+                  --
+                  I_bus_request_dma => bus_request_dma_int,
+                  O_bus_response_dma => bus_response_dma_int,
+                  I_bus_hold_dma => bus_hold_dma_int,
+                  O_bus_grant_dma => bus_grant_dma_int,
+                  --
+                  I_bus_request_dm => bus_request_dm_int,
+                  O_bus_response_dm => bus_response_dm_int,
+                  I_bus_hold_dm => bus_hold_dm_int,
+                  O_bus_grant_dm => bus_grant_dm_int,
+                  --
+                  O_bus_request => bus_request_arb_int,
+                  I_bus_response => bus_response_arb_int
+                 );
+    end generate;
+    bus_arbitergen_not : if not (HAVE_DMA or (HAVE_OCD and OCD_SYSBUS)) generate
+        bus_request_arb_int <= bus_request_int;
+        bus_response_int <= bus_response_arb_int;
+    end generate;
+    
     instr_route0: instr_router
     generic map (
               HAVE_BOOTLOADER_ROM => HAVE_BOOTLOADER_ROM,
@@ -976,7 +1278,9 @@ begin
         -- Debug Module
         dm0: dm
         generic map (
-                  OCD_AAMPOSTINCREMENT => OCD_AAMPOSTINCREMENT
+                  OCD_AAMPOSTINCREMENT => OCD_AAMPOSTINCREMENT,
+                  OCD_SYSBUS => OCD_SYSBUS,
+                  OCD_PCSAMPLE => OCD_PCSAMPLE
                  )
         port map (I_clk => I_clk,
                   I_areset => areset_debug_int,
@@ -994,7 +1298,14 @@ begin
                   O_ackhavereset => ackhavereset_int,
                   --
                   O_dm_core_data_request => dm_core_data_request_int,
-                  I_dm_core_data_response => dm_core_data_response_int
+                  I_dm_core_data_response => dm_core_data_response_int,
+                  --
+                  O_bus_request => bus_request_dm_int,
+                  I_bus_response => bus_response_dm_int,
+                  O_bus_hold => bus_hold_dm_int,
+                  I_bus_grant => bus_grant_dm_int,
+                  --
+                  I_pcsample => pcsample_int
                  );
     end generate debuggen;
     
@@ -1016,6 +1327,13 @@ begin
         dm_core_data_request_int.writecsr <= '0';
         dm_core_data_request_int.writegpr <= '0';
         dm_core_data_request_int.writemem <= '0';
+
+        bus_request_dm_int.stb <= '0';
+        bus_request_dm_int.acc <= memaccess_nop;
+        bus_request_dm_int.size <= memsize_unknown;
+        bus_request_dm_int.addr <= (others => '0');
+        bus_request_dm_int.data <= (others => '0');
+        bus_hold_dm_int <= '0';
     end generate notdebuggen;
 
     -- I/O bus switch
@@ -1070,15 +1388,15 @@ begin
               -- 0xc00 - CRC
               O_dev12_request => crc_request_int,
               I_dev12_response => crc_response_int,
-              -- 0xd00 - free
-              O_dev13_request => stub13_request_int,
-              I_dev13_response => stub13_response_int,
-              -- 0xe00 - free
-              O_dev14_request => stub14_request_int,
-              I_dev14_response => stub14_response_int,
-              -- 0xf00 - free
-              O_dev15_request => stub15_request_int,
-              I_dev15_response => stub15_response_int
+              -- 0xd00 - DMA
+              O_dev13_request => dma_request_int,
+              I_dev13_response => dma_response_int,
+              -- 0xe00 - CLIC
+              O_dev14_request => clic_request_int,
+              I_dev14_response => clic_response_int,
+              -- 0xf00 - Trace buffer
+              O_dev15_request => trace_request_int,
+              I_dev15_response => trace_response_int
              );
 
     -- Always have GPIOA
@@ -1215,7 +1533,9 @@ begin
                   I_rxd => I_uart1rxd,
                   O_txd => O_uart1txd,
                   O_break_received => break_from_uart1_int,
-                  O_irq => irq_uart1_int
+                  O_irq => irq_uart1_int,
+                  O_rxready => uart1_rxready_int,
+                  O_txempty => uart1_txempty_int
                  );
     end generate;
     uart1gen_not : if not HAVE_UART1 generate
@@ -1231,6 +1551,8 @@ begin
         O_uart1txd <= 'Z';
         break_from_uart1_int <= '0';
         irq_uart1_int <= '0';
+        uart1_rxready_int <= '0';
+        uart1_txempty_int <= '0';
     end generate;
 
     -- I2C1 - A master-only I2C device
@@ -1249,7 +1571,9 @@ begin
                   --
                   IO_scl => IO_i2c1scl,
                   IO_sda => IO_i2c1sda,
-                  O_irq => irq_i2c1_int
+                  O_irq => irq_i2c1_int,
+                  O_rxready => i2c1_rxready_int,
+                  O_txempty => i2c1_txempty_int
                  );
     end generate;
     i2c1gen_not : if not HAVE_I2C1 generate
@@ -1265,6 +1589,8 @@ begin
         IO_i2c1scl <= 'Z';
         IO_i2c1sda <= 'Z';
         irq_i2c1_int <= '0';
+        i2c1_rxready_int <= '0';
+        i2c1_txempty_int <= '0';
     end generate;
 
     -- I2C2 - A master-only I2C device
@@ -1283,7 +1609,9 @@ begin
                   --
                   IO_scl => IO_i2c2scl,
                   IO_sda => IO_i2c2sda,
-                  O_irq => irq_i2c2_int
+                  O_irq => irq_i2c2_int,
+                  O_rxready => i2c2_rxready_int,
+                  O_txempty => i2c2_txempty_int
                  );
     end generate;
     i2c2gen_not : if not HAVE_I2C2 generate
@@ -1299,6 +1627,8 @@ begin
         IO_i2c2scl <= 'Z';
         IO_i2c2sda <= 'Z';
         irq_i2c2_int <= '0';
+        i2c2_rxready_int <= '0';
+        i2c2_txempty_int <= '0';
     end generate;
 
     -- SPI1 - A master-only SPI device
@@ -1315,7 +1645,9 @@ begin
                   O_sck => O_spi1sck,
                   O_mosi => O_spi1mosi,
                   I_miso => I_spi1miso,
-                  O_irq => irq_spi1_int
+                  O_irq => irq_spi1_int,
+                  O_rxready => spi1_rxready_int,
+                  O_txempty => spi1_txempty_int
                  );
     end generate;
     spi1gen_not : if not HAVE_SPI1 generate
@@ -1331,6 +1663,8 @@ begin
         O_spi1sck <= 'Z';
         O_spi1mosi <= 'Z';
         irq_spi1_int <= '0';
+        spi1_rxready_int <= '0';
+        spi1_txempty_int <= '0';
     end generate;
 
     -- SPI2 - A master-only SPI device
@@ -1347,7 +1681,9 @@ begin
                   O_sck => O_spi2sck,
                   O_mosi => O_spi2mosi,
                   I_miso => I_spi2miso,
-                  O_irq => irq_spi2_int
+                  O_irq => irq_spi2_int,
+                  O_rxready => spi2_rxready_int,
+                  O_txempty => spi2_txempty_int
                  );
     end generate;
     spi2gen_not : if not HAVE_SPI2 generate
@@ -1363,6 +1699,8 @@ begin
         O_spi2sck <= 'Z';
         O_spi2mosi <= 'Z';
         irq_spi2_int <= '0';
+        spi2_rxready_int <= '0';
+        spi2_txempty_int <= '0';
     end generate;
 
     -- TIMER2 - A 16-bit timer, with PWM/OC/IC capabilities
@@ -1417,7 +1755,9 @@ begin
                   I_rxd => I_uart2rxd,
                   O_txd => O_uart2txd,
                   O_break_received => open,
-                  O_irq => irq_uart2_int
+                  O_irq => irq_uart2_int,
+                  O_rxready => uart2_rxready_int,
+                  O_txempty => uart2_txempty_int
                  );
     end generate;
     uart2gen_not : if not HAVE_UART2 generate
@@ -1432,6 +1772,8 @@ begin
                  );
         O_uart2txd <= 'Z';
         irq_uart2_int <= '0';
+        uart2_rxready_int <= '0';
+        uart2_txempty_int <= '0';
     end generate;
 
     -- CRC
@@ -1458,40 +1800,119 @@ begin
                  );
     end generate;
 
-    -- Three stubs for non-used I/O
-    stub13gen: stub
-    port map (
-              I_clk => clk_int,
-              I_areset => areset_sys_int,
-              I_sreset => sreset_sys_int,
-              --
-              I_mem_request => stub13_request_int,
-              O_mem_response => stub13_response_int
-             );
-    stub14gen: stub
-    port map (
-              I_clk => clk_int,
-              I_areset => areset_sys_int,
-              I_sreset => sreset_sys_int,
-              --
-              I_mem_request => stub14_request_int,
-              O_mem_response => stub14_response_int
-             );
-    stub15gen: stub
-    port map (
-              I_clk => clk_int,
-              I_areset => areset_sys_int,
-              I_sreset => sreset_sys_int,
-              --
-              I_mem_request => stub15_request_int,
-              O_mem_response => stub15_response_int
-             );
+    -- DMA
+    dmagen : if HAVE_DMA generate
+        dma1 : dma
+        port map (
+                  I_clk => clk_int,
+                  I_areset => areset_sys_int,
+                  I_sreset => sreset_sys_int,
+                  --
+                  I_mem_request => dma_request_int,
+                  O_mem_response => dma_response_int,
+                  --
+                  O_bus_request => bus_request_dma_int,
+                  I_bus_response => bus_response_dma_int,
+                  O_bus_hold => bus_hold_dma_int,
+                  I_bus_grant => bus_grant_dma_int,
+                  --
+                  I_trigger => dma_trigger_int,
+                  O_irq => irq_dma_int
+                 );
+    end generate;
+    dmagen_not : if not HAVE_DMA generate
+        dma1 : stub
+        port map (
+                  I_clk => clk_int,
+                  I_areset => areset_sys_int,
+                  I_sreset => sreset_sys_int,
+                  --
+                  I_mem_request => dma_request_int,
+                  O_mem_response => dma_response_int
+                 );
+        irq_dma_int <= '0';
+        -- The DMA never requests the bus
+        bus_request_dma_int.stb <= '0';
+        bus_request_dma_int.acc <= memaccess_nop;
+        bus_request_dma_int.size <= memsize_unknown;
+        bus_request_dma_int.addr <= (others => '0');
+        bus_request_dma_int.data <= (others => '0');
+        bus_hold_dma_int <= '0';
+    end generate;
+
+    -- DMA triggers, 0 is always active (memory to memory)
+    dma_trigger_int <= "000" &
+                       uart2_txempty_int & uart2_rxready_int &
+                       i2c2_txempty_int & i2c2_rxready_int &
+                       i2c1_txempty_int & i2c1_rxready_int &
+                       spi2_txempty_int & spi2_rxready_int &
+                       spi1_txempty_int & spi1_rxready_int &
+                       uart1_txempty_int & uart1_rxready_int &
+                       '1';
+
+    -- CLIC
+    clicgen : if HAVE_CLIC generate
+        clic1 : clic
+        port map (
+                  I_clk => clk_int,
+                  I_areset => areset_sys_int,
+                  I_sreset => sreset_sys_int,
+                  --
+                  I_mem_request => clic_request_int,
+                  O_mem_response => clic_response_int,
+                  --
+                  I_intrio => intrio_int,
+                  O_clic => clic_int
+                 );
+    end generate;
+    clicgen_not : if not HAVE_CLIC generate
+        clic1 : stub
+        port map (
+                  I_clk => clk_int,
+                  I_areset => areset_sys_int,
+                  I_sreset => sreset_sys_int,
+                  --
+                  I_mem_request => clic_request_int,
+                  O_mem_response => clic_response_int
+                 );
+        clic_int <= clic_request_none_c;
+    end generate;
+
+    -- Instruction trace buffer
+    tracegen : if HAVE_TRACE generate
+        trace1 : trace
+        generic map (
+                  TRACE_ADDRESS_BITS => trace_address_bits_c
+                 )
+        port map (
+                  I_clk => clk_int,
+                  I_areset => areset_sys_int,
+                  I_sreset => sreset_sys_int,
+                  --
+                  I_mem_request => trace_request_int,
+                  O_mem_response => trace_response_int,
+                  --
+                  I_trace => trace_int
+                 );
+    end generate;
+    tracegen_not : if not HAVE_TRACE generate
+        trace1 : stub
+        port map (
+                  I_clk => clk_int,
+                  I_areset => areset_sys_int,
+                  I_sreset => sreset_sys_int,
+                  --
+                  I_mem_request => trace_request_int,
+                  O_mem_response => trace_response_int
+                 );
+    end generate;
 
 
     -- Bundle all interrupt lines together
     process (irq_gpioa_int, irq_uart1_int, irq_mtime_int, irq_wdt_int,
              irq_msi_int, irq_i2c1_int, irq_i2c2_int, irq_spi1_int,
-             irq_spi2_int, irq_timer1_int, irq_timer2_int, irq_uart2_int) is
+             irq_spi2_int, irq_timer1_int, irq_timer2_int, irq_uart2_int,
+             irq_dma_int) is
     begin
         intrio_int <= all_zeros_c;
         
@@ -1507,6 +1928,7 @@ begin
         intrio_int(INTR_PRIO_MTIME) <= irq_mtime_int;
         intrio_int(INTR_PRIO_MSI) <= irq_msi_int;
         intrio_int(INTR_PRIO_UART2) <= irq_uart2_int;
+        intrio_int(INTR_PRIO_DMA) <= irq_dma_int;
     end process;
  
 end architecture rtl;
@@ -55,7 +55,10 @@ entity spi is
           O_sck : out std_logic;
           O_mosi : out std_logic;
           I_miso : in std_logic;
-          O_irq : out std_logic
+          O_irq : out std_logic;
+          -- DMA requests
+          O_rxready : out std_logic;
+          O_txempty : out std_logic
          );
 end entity spi;
 
@@ -314,4 +317,8 @@ begin
     O_mosi <= spi.mosi;
     O_irq <= spi.tcie and spi.tc;
 
+    -- DMA requests: transfer complete, ready for a new transfer
+    O_rxready <= spi.tc;
+    O_txempty <= '1' when spi.state = idle and spi.start = '0' else '0';
+
 end architecture rtl;
@@ -0,0 +1,298 @@
+-- #################################################################################################
+-- # store_buffer.vhd -- Posted store buffer between core and data bus                             #
+-- # ********************************************************************************************* #
+-- # This file is part of the THUAS RISCV RV32 Project                                             #
+-- # ********************************************************************************************* #
+-- # BSD 3-Clause License                                                                          #
+-- #                                                                                               #
+-- # Copyright (c) 2026, Jesse op den Brouw. All rights reserved.                                  #
+-- #                                                                                               #
+-- # Redistribution and use in source and binary forms, with or without modification, are          #
+-- # permitted provided that the following conditions are met:                                     #
+-- #                                                                                               #
+-- # 1. Redistributions of source code must retain the above copyright notice, this list of        #
+-- #    conditions and the following disclaimer.                                                   #
+-- #                                                                                               #
+-- # 2. Redistributions in binary form must reproduce the above copyright notice, this list of     #
+-- #    conditions and the following disclaimer in the documentation and/or other materials        #
+-- #    provided with the distribution.                                                            #
+-- #                                                                                               #
+-- # 3. Neither the name of the copyright holder nor the names of its contributors may be used to  #
+-- #    endorse or promote products derived from this software without specific prior written      #
+-- #    permission.                                                                                #
+-- #                                                                                               #
+-- # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS   #
+-- # OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF               #
+-- # MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE    #
+-- # COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,     #
+-- # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE #
+-- # GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED    #
+-- # AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING     #
+-- # NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED  #
+-- # OF THE POSSIBILITY OF SUCH DAMAGE.                                                            #
+-- # ********************************************************************************************* #
+-- # https:/github.com/jesseopdenbrouw/thuas-riscv                                                 #
+-- #################################################################################################
+
+
+-- This file contains the posted store buffer. It is placed between
+-- the core and the bus arbiter (or address decoder). A naturally
+-- aligned store to RAM, to ROM if the ROM is writable and to I/O if
+-- POST_IO_STORES is set (word stores only) is acknowledged immediately
+-- and written to the memory in the background. These stores cannot
+-- fault. Other stores wait until the buffer is empty, so they raise
+-- precise exceptions. A load from ROM or RAM that is covered
+-- by a buffered store gets the store data, a load that partially
+-- overlaps a buffered store waits until the buffer is empty, other
+-- loads from ROM or RAM pass the buffered stores. Loads from I/O wait
+-- until the buffer is empty. The buffer is emptied in order, so the
+-- ordering of I/O stores is preserved. FENCE and FENCE.I wait for the
+-- buffer to become empty.
+--
+-- The core strobes a request for one clock cycle and keeps the
+-- address, size and data stable until the ready. A request that
+-- cannot be handled immediately is recorded.
+
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.numeric_std.all;
+
+library work;
+use work.processor_common.all;
+
+entity store_buffer is
+    generic (
+          -- Post stores to I/O?
+          POST_IO_STORES : boolean;
+          -- Can the ROM be written?
+          ROM_WRITABLE : boolean;
+          -- 4 high bits of ROM address
+          ROM_HIGH_NIBBLE : memory_high_nibble;
+          -- 4 high bits of RAM address
+          RAM_HIGH_NIBBLE : memory_high_nibble;
+          -- 4 high bits of I/O address
+          IO_HIGH_NIBBLE : memory_high_nibble
+         );
+    port (I_clk : in std_logic;
+          I_areset : in std_logic;
+          I_sreset : in std_logic;
+          -- From and to core
+          I_bus_request : in bus_request_type;
+          O_bus_response : out bus_response_type;
+          -- All stores written
+          O_empty : out std_logic;
+          -- To and from bus arbiter or address decoder
+          O_bus_request : out bus_request_type;
+          I_bus_response : in bus_response_type
+         );
+end entity store_buffer;
+
+architecture rtl of store_buffer is
+
+-- Number of buffered stores
+constant STORE_BUFFER_DEPTH : integer := 4;
+
+type entry_type is record
+    addr : data_type;
+    data : data_type;
+    size : memsize_type;
+end record;
+type entry_array_type is array (0 to STORE_BUFFER_DEPTH-1) of entry_type;
+signal fifo : entry_array_type;
+signal count : integer range 0 to STORE_BUFFER_DEPTH;
+
+-- Core request recorded, core transfer and store on the bus
+signal hold : std_logic;
+signal cbusy : std_logic;
+signal dbusy : std_logic;
+
+-- Request decoding
+signal request : std_logic;
+signal post : std_logic;
+signal hit : std_logic;
+signal bypass : std_logic;
+signal hitdata : data_type;
+
+-- Request is handled now
+signal accept : std_logic;
+signal pass : std_logic;
+signal drain : std_logic;
+signal push : std_logic;
+signal pop : std_logic;
+
+constant bus_response_none_c : bus_response_type := (
+    data => (others => '0'),
+    ready => '0',
+    load_access_error => '0',
+    store_access_error => '0',
+    load_misaligned_error => '0',
+    store_misaligned_error => '0'
+   );
+
+begin
+
+    -- Decode the core request
+    process (I_bus_request, hold, fifo, count) is
+    variable nibble_v : memory_high_nibble;
+    variable ismem_v, iswritable_v, isio_v, aligned_v, covers_v, hit_v, overlap_v : boolean;
+    variable mask_v : std_logic_vector(1 downto 0);
+    variable data_v : data_type;
+    begin
+        nibble_v := I_bus_request.addr(31 downto 28);
+        ismem_v := nibble_v = ROM_HIGH_NIBBLE or nibble_v = RAM_HIGH_NIBBLE;
+        iswritable_v := nibble_v = RAM_HIGH_NIBBLE or (nibble_v = ROM_HIGH_NIBBLE and ROM_WRITABLE);
+        isio_v := nibble_v = IO_HIGH_NIBBLE;
+        case I_bus_request.size is
+            when memsize_word => aligned_v := I_bus_request.addr(1 downto 0) = "00";
+            when memsize_halfword => aligned_v := I_bus_request.addr(0) = '0';
+            when memsize_byte => aligned_v := true;
+            when others => aligned_v := false;
+        end case;
+
+        -- New or recorded request
+        if (I_bus_request.stb = '1' or hold = '1') and I_bus_request.acc /= memaccess_nop then
+            request <= '1';
+        else
+            request <= '0';
+        end if;
+
+        -- Store that may be posted, only stores that cannot fault
+        if I_bus_request.acc = memaccess_write and aligned_v and
+           (iswritable_v or (isio_v and POST_IO_STORES and I_bus_request.size = memsize_word)) then
+            post <= '1';
+        else
+            post <= '0';
+        end if;
+
+        -- Search the buffered stores to the same word, the newest
+        -- store must cover the load
+        hit_v := false;
+        overlap_v := false;
+        data_v := (others => '0');
+        for i in 0 to STORE_BUFFER_DEPTH-1 loop
+            if i < count and fifo(i).addr(31 downto 2) = I_bus_request.addr(31 downto 2) then
+                overlap_v := true;
+                case fifo(i).size is
+                    when memsize_word =>
+                        mask_v := "11";
+                        covers_v := true;
+                    when memsize_halfword =>
+                        mask_v := "01";
+                        covers_v := fifo(i).addr(1) = I_bus_request.addr(1) and I_bus_request.size /= memsize_word;
+                    when others =>
+                        mask_v := "00";
+                        covers_v := fifo(i).addr(1 downto 0) = I_bus_request.addr(1 downto 0) and I_bus_request.size = memsize_byte;
+                end case;
+                hit_v := covers_v;
+                if covers_v then
+                    data_v := std_logic_vector(shift_right(unsigned(fifo(i).data),
+                                               8*to_integer(unsigned(I_bus_request.addr(1 downto 0) and mask_v))));
+                end if;
+            end if;
+        end loop;
+
+        if I_bus_request.acc = memaccess_read and aligned_v and ismem_v and hit_v then
+            hit <= '1';
+        else
+            hit <= '0';
+        end if;
+        hitdata <= data_v;
+
+        -- Load from ROM or RAM may pass the buffered stores
+        if I_bus_request.acc = memaccess_read and ismem_v and not overlap_v then
+            bypass <= '1';
+        else
+            bypass <= '0';
+        end if;
+    end process;
+
+    -- Store is posted or load gets buffered data
+    accept <= '1' when request = '1' and cbusy = '0' and
+                       ((post = '1' and count < STORE_BUFFER_DEPTH) or hit = '1')
+                  else '0';
+    push <= accept and post;
+    -- Core request is put on the bus
+    pass <= '1' when request = '1' and cbusy = '0' and dbusy = '0' and post = '0' and hit = '0' and
+                     (count = 0 or bypass = '1')
+                else '0';
+    -- Oldest store is put on the bus
+    drain <= '1' when count /= 0 and (dbusy = '1' or (cbusy = '0' and pass = '0')) else '0';
+    -- Posted stores cannot fault, an error would only remove the store
+    pop <= drain and (I_bus_response.ready or I_bus_response.store_access_error or
+                      I_bus_response.store_misaligned_error);
+
+    -- Route the request and the response
+    process (I_bus_request, I_bus_response, pass, cbusy, drain, dbusy, accept, hitdata, fifo) is
+    begin
+        O_bus_response <= bus_response_none_c;
+        O_bus_request.stb <= '0';
+        O_bus_request.acc <= memaccess_nop;
+        O_bus_request.size <= memsize_unknown;
+        O_bus_request.addr <= I_bus_request.addr;
+        O_bus_request.data <= I_bus_request.data;
+        if pass = '1' or cbusy = '1' then
+            -- Core transfer, strobe only once
+            O_bus_request.stb <= pass;
+            O_bus_request.acc <= I_bus_request.acc;
+            O_bus_request.size <= I_bus_request.size;
+            O_bus_response <= I_bus_response;
+        elsif drain = '1' then
+            -- Oldest store, strobe only once
+            O_bus_request.stb <= not dbusy;
+            O_bus_request.acc <= memaccess_write;
+            O_bus_request.size <= fifo(0).size;
+            O_bus_request.addr <= fifo(0).addr;
+            O_bus_request.data <= fifo(0).data;
+        end if;
+        if accept = '1' then
+            O_bus_response.ready <= '1';
+            O_bus_response.data <= hitdata;
+        end if;
+    end process;
+
+    O_empty <= '1' when count = 0 else '0';
+
+    process (I_clk, I_areset) is
+    variable count_v : integer range 0 to STORE_BUFFER_DEPTH;
+    begin
+        if I_areset = '1' then
+            count <= 0;
+            hold <= '0';
+            cbusy <= '0';
+            dbusy <= '0';
+        elsif rising_edge(I_clk) then
+            if I_sreset = '1' then
+                count <= 0;
+                hold <= '0';
+                cbusy <= '0';
+                dbusy <= '0';
+            else
+                -- Record a request that has to wait
+                hold <= request and not accept and not pass;
+                -- Transfers waiting for the ready
+                if cbusy = '1' or pass = '1' then
+                    cbusy <= not I_bus_response.ready;
+                end if;
+                if drain = '1' then
+                    dbusy <= not pop;
+                end if;
+                -- Remove the oldest store, add the newest
+                count_v := count;
+                if pop = '1' then
+                    for i in 0 to STORE_BUFFER_DEPTH-2 loop
+                        fifo(i) <= fifo(i+1);
+                    end loop;
+                    count_v := count_v - 1;
+                end if;
+                if push = '1' then
+                    fifo(count_v).addr <= I_bus_request.addr;
+                    fifo(count_v).data <= I_bus_request.data;
+                    fifo(count_v).size <= I_bus_request.size;
+                    count_v := count_v + 1;
+                end if;
+                count <= count_v;
+            end if;
+        end if;
+    end process;
+
+end architecture rtl;
@@ -0,0 +1,340 @@
+-- #################################################################################################
+-- # trace.vhd - Instruction trace buffer                                                          #
+-- # ********************************************************************************************* #
+-- # This file is part of the THUAS RISCV RV32 Project                                             #
+-- # ********************************************************************************************* #
+-- # BSD 3-Clause License                                                                          #
+-- #                                                                                               #
+-- # Copyright (c) 2026, Jesse op den Brouw. All rights reserved.                                  #
+-- #                                                                                               #
+-- # Redistribution and use in source and binary forms, with or without modification, are          #
+-- # permitted provided that the following conditions are met:                                     #
+-- #                                                                                               #
+-- # 1. Redistributions of source code must retain the above copyright notice, this list of        #
+-- #    conditions and the following disclaimer.                                                   #
+-- #                                                                                               #
+-- # 2. Redistributions in binary form must reproduce the above copyright notice, this list of     #
+-- #    conditions and the following disclaimer in the documentation and/or other materials        #
+-- #    provided with the distribution.                                                            #
+-- #                                                                                               #
+-- # 3. Neither the name of the copyright holder nor the names of its contributors may be used to  #
+-- #    endorse or promote products derived from this software without specific prior written      #
+-- #    permission.                                                                                #
+-- #                                                                                               #
+-- # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS   #
+-- # OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF               #
+-- # MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE    #
+-- # COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,     #
+-- # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE #
+-- # GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED    #
+-- # AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING     #
+-- # NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED  #
+-- # OF THE POSSIBILITY OF SUCH DAMAGE.                                                            #
+-- # ********************************************************************************************* #
+-- # https:/github.com/jesseopdenbrouw/thuas-riscv                                                 #
+-- #################################################################################################
+
+-- Instruction trace buffer
+--
+-- Records the discontinuities in the instruction flow reported by the
+-- core (taken branches and jumps, traps, MRET and resuming from debug
+-- mode) as packets in a ring buffer of 2**TRACE_ADDRESS_BITS words.
+-- The events are queued and written one word per clock cycle, so the
+-- core is never stalled. If the queue is full, the event is lost and
+-- the first event queued after the loss is written as a marked full
+-- packet.
+--
+-- A packet starts with a header word, address words have bit 0 cleared:
+--   bit 0     - 1, header
+--   bits 3:1  - kind: 1 direct jump/branch, 2 indirect jump, 3 trap,
+--               4 MRET, 5 tail-chained trap, 6 resume from debug mode
+--   bit 4     - full packet, followed by the source and target address
+--   bit 5     - full packet only, events are lost before this packet
+--   bits 31:5 - compressed packet only, (source - previous target) / 2
+-- A compressed packet of an indirect jump, trap, MRET or tail-chained
+-- trap is followed by the target address. The target of a direct
+-- jump/branch is found in the program. A full packet is written after
+-- enabling, after lost events, every 64 packets and if the source is
+-- out of reach of the previous target.
+--
+-- Register map (offsets from base):
+-- 0x00 - CTRL, bit 0 EN, enable
+--              bit 1 CLR, clear the buffer (reads 0)
+--              bit 2 ONESHOT, stop when the buffer is full
+-- 0x04 - STAT, bit 0 WRAP, the buffer has wrapped (read only)
+--              bit 1 OVR, events are lost
+--              bit 2 FULL, stopped in one-shot mode
+-- 0x08 - WPTR, index of the next word to write (read only)
+-- 0x0c - RPTR, index of the next word to read
+-- 0x10 - DATA, word at RPTR, RPTR is incremented (read only)
+-- 0x14 - SIZE, number of words in the buffer (read only)
+
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.numeric_std.all;
+
+library work;
+use work.processor_common.all;
+
+entity trace is
+    generic (
+          -- Buffer size in words is 2**bits
+          TRACE_ADDRESS_BITS : integer
+         );
+    port (I_clk : in std_logic;
+          I_areset : in std_logic;
+          I_sreset : in std_logic;
+          -- 
+          I_mem_request : in mem_request_type;
+          O_mem_response : out mem_response_type;
+          -- Events from the core
+          I_trace : in trace_type
+         );
+end entity trace;
+
+architecture rtl of trace is
+
+constant buffer_size_c : integer := 2**TRACE_ADDRESS_BITS;
+-- Number of packets between full packets
+constant sync_interval_c : integer := 64;
+-- Number of events that can be queued
+constant queue_size_c : integer := 4;
+
+-- Queued event, lost is set on the first event after lost events
+type queue_entry_type is record
+    event : trace_type;
+    lost : std_logic;
+end record;
+constant queue_entry_none_c : queue_entry_type := (
+    event => trace_none_c,
+    lost => '0'
+   );
+type queue_type is array (0 to queue_size_c-1) of queue_entry_type;
+type packet_type is array (0 to 2) of data_type;
+type ram_type is array (0 to buffer_size_c-1) of data_type;
+
+type trace_reg_type is record
+    en : std_logic;
+    oneshot : std_logic;
+    wrap : std_logic;
+    ovr : std_logic;
+    full : std_logic;
+    wptr : unsigned(TRACE_ADDRESS_BITS-1 downto 0);
+    rptr : unsigned(TRACE_ADDRESS_BITS-1 downto 0);
+    -- Event queue
+    queue : queue_type;
+    head : integer range 0 to queue_size_c-1;
+    tail : integer range 0 to queue_size_c-1;
+    count : integer range 0 to queue_size_c;
+    -- Packet being written, word 0 first
+    packet : packet_type;
+    len : integer range 0 to 3;
+    -- Compression
+    last_target : data_type;
+    sync : integer range 0 to sync_interval_c-1;
+    needs_full : std_logic;
+    -- Events are lost, mark the next queued event
+    lost : std_logic;
+end record;
+constant trace_reg_reset_c : trace_reg_type := (
+    en => '0',
+    oneshot => '0',
+    wrap => '0',
+    ovr => '0',
+    full => '0',
+    wptr => (others => '0'),
+    rptr => (others => '0'),
+    queue => (others => queue_entry_none_c),
+    head => 0,
+    tail => 0,
+    count => 0,
+    packet => (others => (others => '0')),
+    len => 0,
+    last_target => (others => '0'),
+    sync => 0,
+    needs_full => '1',
+    lost => '0'
+   );
+signal tr : trace_reg_type;
+
+-- The trace buffer, inferred as block RAM
+signal ram : ram_type;
+signal ram_we : std_logic;
+signal ram_q : data_type;
+
+signal isword : boolean;
+
+begin
+
+    -- Check for misaligned access
+    O_mem_response.load_misaligned_error <= '1' when I_mem_request.stb = '1' and I_mem_request.wren = '0' and I_mem_request.size = memsize_word and I_mem_request.addr(1 downto 0) /= "00" else '0';
+    O_mem_response.store_misaligned_error <= '1' when I_mem_request.stb = '1' and I_mem_request.wren = '1' and I_mem_request.size = memsize_word and I_mem_request.addr(1 downto 0) /= "00" else '0';
+    -- Check for unsuppored data size
+    O_mem_response.load_access_error <= '1' when I_mem_request.stb = '1' and I_mem_request.wren = '0' and I_mem_request.size /= memsize_word else '0';
+    O_mem_response.store_access_error <= '1' when I_mem_request.stb = '1' and I_mem_request.wren = '1' and I_mem_request.size /= memsize_word  else '0';
+    
+    -- Correct size and address boundary
+    isword <= I_mem_request.size = memsize_word and I_mem_request.addr(1 downto 0) = "00";
+
+    -- Write the first word of the packet, unless stopped
+    ram_we <= '1' when tr.len /= 0 and tr.full = '0' else '0';
+
+    -- The buffer, the word at RPTR is always read so that
+    -- it is available on a read of DATA
+    process (I_clk) is
+    begin
+        if rising_edge(I_clk) then
+            if ram_we = '1' then
+                ram(to_integer(tr.wptr)) <= tr.packet(0);
+            end if;
+            ram_q <= ram(to_integer(tr.rptr));
+        end if;
+    end process;
+
+    process (I_clk, I_areset) is
+    variable push_v : boolean;
+    variable pop_v : boolean;
+    variable len_v : integer range 0 to 3;
+    variable event_v : trace_type;
+    variable lost_v : std_logic;
+    variable offset_v : unsigned(31 downto 0);
+    variable full_v : boolean;
+    begin
+        if I_areset = '1' then
+            tr <= trace_reg_reset_c;
+            O_mem_response.data <= all_zeros_c;
+            O_mem_response.ready <= '0';
+        elsif rising_edge(I_clk) then
+            O_mem_response.data <= all_zeros_c;
+            O_mem_response.ready <= '0';
+
+            if I_sreset = '1' then
+                tr <= trace_reg_reset_c;
+            else
+                -- Write out the packet, one word per clock cycle
+                len_v := tr.len;
+                if tr.len /= 0 then
+                    if tr.full = '0' then
+                        tr.wptr <= tr.wptr + 1;
+                        if tr.wptr = buffer_size_c-1 then
+                            tr.wrap <= '1';
+                            if tr.oneshot = '1' then
+                                tr.full <= '1';
+                                tr.en <= '0';
+                            end if;
+                        end if;
+                    end if;
+                    tr.packet(0) <= tr.packet(1);
+                    tr.packet(1) <= tr.packet(2);
+                    len_v := tr.len - 1;
+                end if;
+
+                -- Start the next packet if the current one is written
+                push_v := I_trace.valid = '1' and tr.en = '1';
+                pop_v := tr.count /= 0 and len_v = 0;
+
+                if pop_v then
+                    event_v := tr.queue(tr.tail).event;
+                    lost_v := tr.queue(tr.tail).lost;
+                    offset_v := unsigned(event_v.source) - unsigned(tr.last_target);
+                    full_v := tr.needs_full = '1' or lost_v = '1' or tr.sync = sync_interval_c-1 or
+                              event_v.kind = trace_resume_c or
+                              unsigned(event_v.source) < unsigned(tr.last_target) or
+                              offset_v(31 downto 28) /= "0000";
+                    if full_v then
+                        tr.packet(0) <= (others => '0');
+                        tr.packet(0)(5) <= lost_v;
+                        tr.packet(0)(4) <= '1';
+                        tr.packet(1) <= event_v.source;
+                        tr.packet(2) <= event_v.target;
+                        len_v := 3;
+                        tr.sync <= 0;
+                        tr.needs_full <= '0';
+                    else
+                        tr.packet(0) <= std_logic_vector(offset_v(27 downto 1)) & "00000";
+                        tr.packet(1) <= event_v.target;
+                        if event_v.kind = trace_direct_c then
+                            len_v := 1;
+                        else
+                            len_v := 2;
+                        end if;
+                        tr.sync <= tr.sync + 1;
+                    end if;
+                    tr.packet(0)(3 downto 1) <= event_v.kind;
+                    tr.packet(0)(0) <= '1';
+                    tr.last_target <= event_v.target;
+                    tr.tail <= (tr.tail + 1) mod queue_size_c;
+                end if;
+                tr.len <= len_v;
+
+                -- Queue the event from the core, if the queue is full
+                -- the event is lost and the next queued event is marked
+                if push_v and tr.count = queue_size_c and not pop_v then
+                    push_v := false;
+                    tr.ovr <= '1';
+                    tr.lost <= '1';
+                end if;
+                if push_v then
+                    tr.queue(tr.head).event <= I_trace;
+                    tr.queue(tr.head).lost <= tr.lost;
+                    tr.lost <= '0';
+                    tr.head <= (tr.head + 1) mod queue_size_c;
+                end if;
+                if push_v and not pop_v then
+                    tr.count <= tr.count + 1;
+                elsif pop_v and not push_v then
+                    tr.count <= tr.count - 1;
+                end if;
+
+                -- Register access
+                if I_mem_request.stb = '1' and isword then
+                    if I_mem_request.wren = '1' then
+                        -- Write
+                        case I_mem_request.addr(4 downto 2) is
+                            when "000" =>
+                                -- Enabling starts with a full packet, the
+                                -- events before are not in the buffer
+                                if I_mem_request.data(0) = '1' and tr.en = '0' then
+                                    tr.needs_full <= '1';
+                                    tr.lost <= '1';
+                                end if;
+                                tr.en <= I_mem_request.data(0);
+                                tr.oneshot <= I_mem_request.data(2);
+                                -- Clear the buffer
+                                if I_mem_request.data(1) = '1' then
+                                    tr.wrap <= '0';
+                                    tr.ovr <= '0';
+                                    tr.full <= '0';
+                                    tr.wptr <= (others => '0');
+                                    tr.rptr <= (others => '0');
+                                    tr.head <= 0;
+                                    tr.tail <= 0;
+                                    tr.count <= 0;
+                                    tr.len <= 0;
+                                    tr.sync <= 0;
+                                    tr.needs_full <= '1';
+                                end if;
+                            when "011" => tr.rptr <= unsigned(I_mem_request.data(TRACE_ADDRESS_BITS-1 downto 0));
+                            when others => null;
+                        end case;
+                    else
+                        -- Read
+                        case I_mem_request.addr(4 downto 2) is
+                            when "000" => O_mem_response.data(0) <= tr.en;
+                                          O_mem_response.data(2) <= tr.oneshot;
+                            when "001" => O_mem_response.data(2 downto 0) <= tr.full & tr.ovr & tr.wrap;
+                            when "010" => O_mem_response.data(TRACE_ADDRESS_BITS-1 downto 0) <= std_logic_vector(tr.wptr);
+                            when "011" => O_mem_response.data(TRACE_ADDRESS_BITS-1 downto 0) <= std_logic_vector(tr.rptr);
+                            when "100" => O_mem_response.data <= ram_q;
+                                          tr.rptr <= tr.rptr + 1;
+                            when "101" => O_mem_response.data <= std_logic_vector(to_unsigned(buffer_size_c, 32));
+                            when others => null;
+                        end case;
+                    end if;
+                    O_mem_response.ready <= '1';
+                end if;
+            end if; -- sreset
+        end if; -- posedge
+    end process;
+
+end architecture rtl;
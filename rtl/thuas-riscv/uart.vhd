@@ -58,7 +58,10 @@ entity uart is
           I_rxd : in std_logic;
           O_txd: out std_logic;
           O_break_received : out std_logic;
-          O_irq : out std_logic
+          O_irq : out std_logic;
+          -- DMA requests
+          O_rxready : out std_logic;
+          O_txempty : out std_logic
          );
 end entity uart;
 
@@ -458,6 +461,10 @@ begin
                       (uart.tc = '1' and uart.tcie = '1') or
                       (uart.rc = '1' and uart.rcie = '1') else '0';
 
+    -- DMA requests: a character is received, transmitter is free
+    O_rxready <= uart.rc;
+    O_txempty <= '1' when uart.txstate = tx_idle and uart.txstart = '0' and uart.en = '1' else '0';
+
 end architecture rtl;
 
 
@@ -0,0 +1,398 @@
+/*
+ * benchmark.c - FreeRTOS kernel benchmarks, all times
+ *               in clock cycles measured with mcycle
+ *
+ * Results are printed as comma separated lines:
+ *   info,<key>,<value>
+ *   bench,<name>,<samples>,<min>,<avg>,<max>
+ */
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "semphr.h"
+
+#include <thuasrv32.h>
+
+#ifndef F_CPU
+#define F_CPU (50000000UL)
+#endif
+
+// Number of samples per benchmark
+#define SAMPLES (1000)
+// Interrupt frequency of TIMER1 for the ISR wake-up benchmark
+#define TIMER1_FREQ (1000UL)
+// Interrupt code of TIMER1 in mcause
+#define MCAUSE_TIMER1 (0x80000000UL+CLIC_ID_TIMER1)
+// A longer gap between two reads of mcycle is an interrupt
+#define GAP_CYCLES (40)
+
+// Priorities, the runner preempts the yield tasks and
+// is preempted by the waiting tasks
+#define PRIORITY_YIELD  ( tskIDLE_PRIORITY + 1 )
+#define PRIORITY_RUNNER ( tskIDLE_PRIORITY + 2 )
+#define PRIORITY_WAITER ( tskIDLE_PRIORITY + 3 )
+
+// What the waiting task waits for
+#define WAIT_SEMAPHORE (0)
+#define WAIT_NOTIFY    (1)
+#define WAIT_ISR       (2)
+
+// Statistics of one benchmark
+typedef struct
+{
+    uint32_t ulCount;
+    uint32_t ulMin;
+    uint32_t ulMax;
+    uint32_t ulTotal;
+} BenchStat_t;
+
+static BenchStat_t xStat;
+static BenchStat_t xIsrStat;
+
+// Start time set by the sending side
+static volatile uint32_t ulStamp;
+
+static TaskHandle_t xRunner = NULL;
+static TaskHandle_t volatile xWaiter = NULL;
+static QueueHandle_t xRequest = NULL;
+static QueueHandle_t xReply = NULL;
+static SemaphoreHandle_t xSemaphore = NULL;
+
+// Import from main file
+void vSendString( const char * pcString );
+
+static void prvStatReset( BenchStat_t *pxStat )
+{
+    pxStat->ulCount = 0;
+    pxStat->ulMin = 0xffffffff;
+    pxStat->ulMax = 0;
+    pxStat->ulTotal = 0;
+}
+
+static void prvStatAdd( BenchStat_t *pxStat, uint32_t ulCycles )
+{
+    if( ulCycles < pxStat->ulMin )
+    {
+        pxStat->ulMin = ulCycles;
+    }
+    if( ulCycles > pxStat->ulMax )
+    {
+        pxStat->ulMax = ulCycles;
+    }
+    pxStat->ulTotal += ulCycles;
+    pxStat->ulCount++;
+}
+
+static void prvStatPrint( const char *pcName, BenchStat_t *pxStat )
+{
+    uart1_printf( "bench,%s,%lu,%lu,%lu,%lu\r\n", pcName, pxStat->ulCount,
+                  ( pxStat->ulCount != 0 ) ? pxStat->ulMin : 0,
+                  ( pxStat->ulCount != 0 ) ? pxStat->ulTotal / pxStat->ulCount : 0,
+                  pxStat->ulMax );
+}
+
+// Two tasks of equal priority yield to each other. The time from
+// the stamp before the yield in one task to the return from the
+// yield in the other task is one context switch. The last return
+// from the yield follows the exit of the other task and is not a
+// sample
+static void prvYieldTask( void *pvParameters )
+{
+    uint32_t ulNow;
+
+    ( void ) pvParameters;
+
+    while( xStat.ulCount < SAMPLES )
+    {
+        ulStamp = csr_read( mcycle );
+        taskYIELD();
+        ulNow = csr_read( mcycle );
+        if( xStat.ulCount < SAMPLES )
+        {
+            prvStatAdd( &xStat, ulNow - ulStamp );
+        }
+    }
+
+    xTaskNotifyGive( xRunner );
+    vTaskDelete( NULL );
+}
+
+// Returns every request as a reply
+static void prvEchoTask( void *pvParameters )
+{
+    uint32_t ulValue;
+
+    ( void ) pvParameters;
+
+    for( int i = 0; i < SAMPLES; i++ )
+    {
+        xQueueReceive( xRequest, &ulValue, portMAX_DELAY );
+        xQueueSend( xReply, &ulValue, portMAX_DELAY );
+    }
+
+    vTaskDelete( NULL );
+}
+
+// Waits for a semaphore, a notification from the runner or a
+// notification from the TIMER1 handler and records the time
+// from the give or the compare match to the wake-up
+static void prvWaiterTask( void *pvParameters )
+{
+    uint32_t ulMode = ( uint32_t ) pvParameters;
+    uint32_t ulNow;
+
+    for( int i = 0; i < SAMPLES; i++ )
+    {
+        if( ulMode == WAIT_SEMAPHORE )
+        {
+            xSemaphoreTake( xSemaphore, portMAX_DELAY );
+            ulNow = csr_read( mcycle );
+            prvStatAdd( &xStat, ulNow - ulStamp );
+        }
+        else if( ulMode == WAIT_NOTIFY )
+        {
+            ulTaskNotifyTake( pdTRUE, portMAX_DELAY );
+            ulNow = csr_read( mcycle );
+            prvStatAdd( &xStat, ulNow - ulStamp );
+        }
+        else
+        {
+            ulTaskNotifyTake( pdTRUE, portMAX_DELAY );
+            // TIMER1 runs at the clock and restarts at the compare match
+            prvStatAdd( &xStat, TIMER1->CNTR );
+        }
+    }
+
+    if( ulMode == WAIT_ISR )
+    {
+        timer1_disable();
+        xWaiter = NULL;
+    }
+
+    xTaskNotifyGive( xRunner );
+    vTaskDelete( NULL );
+}
+
+// Called from the interrupt handlers in main.c, returns pdTRUE if
+// the interrupt is handled
+BaseType_t xBenchmarkInterrupt( uint32_t ulMcause )
+{
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+    uint32_t ulCounter;
+
+    if( ulMcause != MCAUSE_TIMER1 )
+    {
+        return pdFALSE;
+    }
+
+    ulCounter = TIMER1->CNTR;
+    timer1_clear_interrupt();
+    prvStatAdd( &xIsrStat, ulCounter );
+
+    if( xWaiter != NULL )
+    {
+        vTaskNotifyGiveFromISR( xWaiter, &xHigherPriorityTaskWoken );
+    }
+    portYIELD_FROM_ISR( xHigherPriorityTaskWoken );
+
+    return pdTRUE;
+}
+
+// Let the idle task free the deleted tasks
+static void prvSettle( void )
+{
+    vTaskDelay( 2 );
+}
+
+static void prvContextSwitch( void )
+{
+    prvStatReset( &xStat );
+    xTaskCreate( prvYieldTask, "Yield1", configMINIMAL_STACK_SIZE, NULL, PRIORITY_YIELD, NULL );
+    xTaskCreate( prvYieldTask, "Yield2", configMINIMAL_STACK_SIZE, NULL, PRIORITY_YIELD, NULL );
+    ulTaskNotifyTake( pdFALSE, portMAX_DELAY );
+    ulTaskNotifyTake( pdFALSE, portMAX_DELAY );
+    prvStatPrint( "context_switch", &xStat );
+    prvSettle();
+}
+
+// Send and receive in the same task, no task switch
+static void prvQueuePair( void )
+{
+    uint32_t ulValue = 0;
+    uint32_t ulStart;
+
+    prvStatReset( &xStat );
+    for( int i = 0; i < SAMPLES; i++ )
+    {
+        ulStart = csr_read( mcycle );
+        xQueueSend( xRequest, &ulValue, 0 );
+        xQueueReceive( xRequest, &ulValue, 0 );
+        prvStatAdd( &xStat, csr_read( mcycle ) - ulStart );
+    }
+    prvStatPrint( "queue_pair", &xStat );
+}
+
+// Send to a task of higher priority and wait for the reply,
+// two task switches
+static void prvQueueRoundTrip( void )
+{
+    uint32_t ulValue = 0;
+    uint32_t ulStart;
+
+    prvStatReset( &xStat );
+    xTaskCreate( prvEchoTask, "Echo", configMINIMAL_STACK_SIZE, NULL, PRIORITY_WAITER, NULL );
+    for( int i = 0; i < SAMPLES; i++ )
+    {
+        ulStart = csr_read( mcycle );
+        xQueueSend( xRequest, &ulValue, portMAX_DELAY );
+        xQueueReceive( xReply, &ulValue, portMAX_DELAY );
+        prvStatAdd( &xStat, csr_read( mcycle ) - ulStart );
+    }
+    prvStatPrint( "queue_roundtrip", &xStat );
+    prvSettle();
+}
+
+// Give and take in the same task, no task switch
+static void prvSemaphorePair( void )
+{
+    uint32_t ulStart;
+
+    prvStatReset( &xStat );
+    for( int i = 0; i < SAMPLES; i++ )
+    {
+        ulStart = csr_read( mcycle );
+        xSemaphoreGive( xSemaphore );
+        xSemaphoreTake( xSemaphore, 0 );
+        prvStatAdd( &xStat, csr_read( mcycle ) - ulStart );
+    }
+    prvStatPrint( "semaphore_pair", &xStat );
+}
+
+// Wake a task of higher priority with a semaphore or a notification
+static void prvWake( const char *pcName, uint32_t ulMode )
+{
+    TaskHandle_t xTask;
+
+    prvStatReset( &xStat );
+    xTaskCreate( prvWaiterTask, "Waiter", configMINIMAL_STACK_SIZE, ( void * ) ulMode, PRIORITY_WAITER, &xTask );
+    for( int i = 0; i < SAMPLES; i++ )
+    {
+        ulStamp = csr_read( mcycle );
+        if( ulMode == WAIT_SEMAPHORE )
+        {
+            xSemaphoreGive( xSemaphore );
+        }
+        else
+        {
+            xTaskNotifyGive( xTask );
+        }
+    }
+    ulTaskNotifyTake( pdFALSE, portMAX_DELAY );
+    prvStatPrint( pcName, &xStat );
+    prvSettle();
+}
+
+// TIMER1 interrupts, the handler notifies a task of higher priority.
+// Both are measured from the compare match
+static void prvIsrWake( uint32_t ulSpeed )
+{
+    prvStatReset( &xStat );
+    prvStatReset( &xIsrStat );
+    xTaskCreate( prvWaiterTask, "Waiter", configMINIMAL_STACK_SIZE, ( void * ) WAIT_ISR, PRIORITY_WAITER, ( TaskHandle_t * ) &xWaiter );
+
+    TIMER1->CTRL = 0;
+    TIMER1->STAT = 0;
+    timer1_setcounter( 0 );
+    timer1_setcompare( ulSpeed / TIMER1_FREQ - 1UL );
+    timer1_enable_interrupt();
+    timer1_enable();
+
+    ulTaskNotifyTake( pdFALSE, portMAX_DELAY );
+
+    TIMER1->CTRL = 0;
+    TIMER1->STAT = 0;
+
+    prvStatPrint( "isr_entry", &xIsrStat );
+    prvStatPrint( "isr_wakeup", &xStat );
+    prvSettle();
+}
+
+// Read mcycle in a tight loop for one second, every gap is an
+// interrupt, here only the tick interrupt
+static void prvTick( uint32_t ulSpeed )
+{
+    uint32_t ulStart, ulLast, ulNow, ulGap;
+    uint64_t ullLost = 0;
+
+    prvStatReset( &xStat );
+
+    // Start right after a tick
+    vTaskDelay( 1 );
+
+    ulStart = ulLast = csr_read( mcycle );
+    do
+    {
+        ulNow = csr_read( mcycle );
+        ulGap = ulNow - ulLast;
+        if( ulGap > GAP_CYCLES )
+        {
+            prvStatAdd( &xStat, ulGap );
+            ullLost += ulGap;
+        }
+        ulLast = ulNow;
+    } while( ulNow - ulStart < ulSpeed );
+
+    prvStatPrint( "tick_isr", &xStat );
+    uart1_printf( "info,tick_load_ppm,%lu\r\n", ( uint32_t ) ( ullLost * 1000000ULL / ( ulNow - ulStart ) ) );
+}
+
+static void prvRunner( void *pvParameters )
+{
+    uint32_t ulSpeed = csr_read( 0xfc1 );
+
+    ( void ) pvParameters;
+
+    ulSpeed = ( ulSpeed == 0 ) ? F_CPU : ulSpeed;
+
+    while( 1 )
+    {
+        uart1_printf( "info,kernel,%s\r\n", tskKERNEL_VERSION_NUMBER );
+        uart1_printf( "info,clock_hz,%lu\r\n", ulSpeed );
+        uart1_printf( "info,tick_rate_hz,%lu\r\n", ( uint32_t ) configTICK_RATE_HZ );
+        uart1_printf( "bench,name,samples,min,avg,max\r\n" );
+
+        prvContextSwitch();
+        prvQueuePair();
+        prvQueueRoundTrip();
+        prvSemaphorePair();
+        prvWake( "semaphore_wakeup", WAIT_SEMAPHORE );
+        prvWake( "notify_wakeup", WAIT_NOTIFY );
+        prvIsrWake( ulSpeed );
+        prvTick( ulSpeed );
+
+        uart1_printf( "info,done,1\r\n" );
+
+        vTaskDelay( pdMS_TO_TICKS( 5000 ) );
+    }
+}
+
+void benchmark( void )
+{
+    xRequest = xQueueCreate( 1, sizeof( uint32_t ) );
+    xReply = xQueueCreate( 1, sizeof( uint32_t ) );
+    xSemaphore = xSemaphoreCreateBinary();
+
+    if( xRequest == NULL || xReply == NULL || xSemaphore == NULL )
+    {
+        vSendString( "Cannot create the queues and the semaphore\r\n" );
+        while( 1 );
+    }
+
+    xTaskCreate( prvRunner, "Runner", 4 * configMINIMAL_STACK_SIZE, NULL, PRIORITY_RUNNER, &xRunner );
+
+    vTaskStartScheduler();
+
+    // Should never get here
+    while( 1 );
+}
@@ -0,0 +1,228 @@
+/*
+ * storage.c - asynchronous FatFs access through a storage task
+ *
+ * All slow SD card transfers are done by a single storage task
+ * that is fed by a request queue. Append requests carry a copy
+ * of the data, so a producer only waits for a free queue slot.
+ * Completion is signalled with a task notification holding the
+ * FRESULT. FatFs is built with FF_FS_REENTRANT so other tasks
+ * may still call f_* functions directly.
+ */
+
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+
+#include "ff.h"
+#include "storage.h"
+
+static QueueHandle_t xStorageQueue;
+
+static FATFS fs;
+/* The file currently kept open by the storage task */
+static FIL fil;
+static const TCHAR *pcOpenPath = NULL;
+static BYTE xOpenMode = 0;
+
+/* Make sure path is the open file with at least the access
+ * rights in mode, reopens a read only file for writing */
+static FRESULT prvOpen( const TCHAR *path, BYTE mode )
+{
+    FRESULT fr;
+    BYTE access = mode & ( FA_READ | FA_WRITE );
+
+    if( pcOpenPath != NULL && strcmp( pcOpenPath, path ) == 0 &&
+        ( xOpenMode & access ) == access )
+    {
+        return FR_OK;
+    }
+    if( pcOpenPath != NULL )
+    {
+        f_close( &fil );
+        pcOpenPath = NULL;
+    }
+    fr = f_open( &fil, path, mode );
+    if( fr == FR_OK )
+    {
+        pcOpenPath = path;
+        xOpenMode = access;
+    }
+    return fr;
+}
+
+static FRESULT prvHandle( storage_request_t *req )
+{
+    FRESULT fr = FR_OK;
+    UINT n = 0;
+
+    switch( req->op )
+    {
+        case STORAGE_APPEND:
+            fr = prvOpen( req->path, FA_OPEN_ALWAYS | FA_READ | FA_WRITE );
+            if( fr == FR_OK )
+            {
+                fr = f_lseek( &fil, f_size( &fil ) );
+            }
+            if( fr == FR_OK )
+            {
+                fr = f_write( &fil, req->data, req->len, &n );
+            }
+            break;
+        case STORAGE_READ:
+            /* Never creates the file */
+            fr = prvOpen( req->path, FA_READ );
+            if( fr == FR_OK )
+            {
+                fr = f_lseek( &fil, req->offset );
+            }
+            if( fr == FR_OK )
+            {
+                fr = f_read( &fil, req->buff, req->len, &n );
+            }
+            break;
+        case STORAGE_SYNC:
+            if( pcOpenPath != NULL )
+            {
+                fr = f_sync( &fil );
+            }
+            break;
+        case STORAGE_CLOSE:
+            if( pcOpenPath != NULL )
+            {
+                fr = f_close( &fil );
+                pcOpenPath = NULL;
+            }
+            break;
+        default:
+            fr = FR_INVALID_PARAMETER;
+            break;
+    }
+
+    if( req->done != NULL )
+    {
+        *req->done = n;
+    }
+    return fr;
+}
+
+/* The storage task */
+static void vStorageTask( void *pvParameters )
+{
+    storage_request_t req;
+    FRESULT fr;
+    TickType_t xLastSync = xTaskGetTickCount();
+    TickType_t xElapsed;
+
+    ( void ) pvParameters;
+
+    while( 1 )
+    {
+        /* Wait for a request, but not beyond the next sync */
+        xElapsed = xTaskGetTickCount() - xLastSync;
+        if( xQueueReceive( xStorageQueue, &req,
+                           ( xElapsed < STORAGE_SYNC_TICKS ) ? STORAGE_SYNC_TICKS - xElapsed : 0 ) == pdPASS )
+        {
+            fr = prvHandle( &req );
+            if( req.notify != NULL )
+            {
+                xTaskNotifyIndexed( req.notify, STORAGE_NOTIFY_INDEX, ( uint32_t ) fr, eSetValueWithOverwrite );
+            }
+        }
+
+        /* Write cached data and the directory entry to the card at
+         * least every STORAGE_SYNC_TICKS, also under a steady load */
+        if( xTaskGetTickCount() - xLastSync >= STORAGE_SYNC_TICKS )
+        {
+            if( pcOpenPath != NULL )
+            {
+                f_sync( &fil );
+            }
+            xLastSync = xTaskGetTickCount();
+        }
+    }
+}
+
+BaseType_t storage_init( UBaseType_t uxPriority )
+{
+    /* Delayed mount, the card is initialized by the storage task
+     * on the first request */
+    if( f_mount( &fs, "", 0 ) != FR_OK )
+    {
+        return pdFAIL;
+    }
+
+    xStorageQueue = xQueueCreate( STORAGE_QUEUE_LENGTH, sizeof( storage_request_t ) );
+    if( xStorageQueue == NULL )
+    {
+        return pdFAIL;
+    }
+
+    return xTaskCreate( vStorageTask, "Storage", 1024, NULL, uxPriority, NULL );
+}
+
+BaseType_t storage_submit( const storage_request_t *req, TickType_t xTicksToWait )
+{
+    return xQueueSend( xStorageQueue, req, xTicksToWait );
+}
+
+BaseType_t storage_append_async( const TCHAR *path, const void *data, UINT len, TickType_t xTicksToWait )
+{
+    storage_request_t req;
+
+    if( len > STORAGE_DATA_SIZE )
+    {
+        return pdFAIL;
+    }
+
+    req.op = STORAGE_APPEND;
+    req.path = path;
+    req.len = len;
+    req.done = NULL;
+    req.notify = NULL;
+    memcpy( req.data, data, len );
+
+    return storage_submit( &req, xTicksToWait );
+}
+
+/* Submit a request and wait for its completion notification */
+static FRESULT prvSubmitAndWait( storage_request_t *req )
+{
+    uint32_t ulResult;
+
+    req->notify = xTaskGetCurrentTaskHandle();
+    xTaskNotifyStateClearIndexed( NULL, STORAGE_NOTIFY_INDEX );
+
+    if( storage_submit( req, portMAX_DELAY ) != pdPASS )
+    {
+        return FR_TIMEOUT;
+    }
+    xTaskNotifyWaitIndexed( STORAGE_NOTIFY_INDEX, 0, 0xffffffffUL, &ulResult, portMAX_DELAY );
+
+    return ( FRESULT ) ulResult;
+}
+
+FRESULT storage_read( const TCHAR *path, void *buff, UINT len, FSIZE_t offset, UINT *done )
+{
+    storage_request_t req;
+
+    req.op = STORAGE_READ;
+    req.path = path;
+    req.buff = buff;
+    req.len = len;
+    req.offset = offset;
+    req.done = done;
+
+    return prvSubmitAndWait( &req );
+}
+
+FRESULT storage_sync( void )
+{
+    storage_request_t req;
+
+    req.op = STORAGE_SYNC;
+    req.done = NULL;
+
+    return prvSubmitAndWait( &req );
+}
@@ -0,0 +1,62 @@
+/*
+ * storage.h - asynchronous FatFs access through a storage task
+ */
+
+#ifndef STORAGE_H
+#define STORAGE_H
+
+#include <stdint.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "ff.h"
+
+/* Maximum number of bytes copied into an append request */
+#ifndef STORAGE_DATA_SIZE
+#define STORAGE_DATA_SIZE 64
+#endif
+/* Number of requests the queue holds */
+#ifndef STORAGE_QUEUE_LENGTH
+#define STORAGE_QUEUE_LENGTH 8
+#endif
+/* Maximum time between syncs of the open file */
+#ifndef STORAGE_SYNC_TICKS
+#define STORAGE_SYNC_TICKS pdMS_TO_TICKS( 1000 )
+#endif
+/* Task notification index used for completion */
+#ifndef STORAGE_NOTIFY_INDEX
+#define STORAGE_NOTIFY_INDEX 1
+#endif
+
+/* Request operations */
+typedef enum {
+    STORAGE_APPEND,  /* Append data[] to the file */
+    STORAGE_READ,    /* Read len bytes at offset into buff */
+    STORAGE_SYNC,    /* Flush the open file */
+    STORAGE_CLOSE    /* Close the open file */
+} storage_op_t;
+
+typedef struct {
+    storage_op_t op;
+    const TCHAR *path;      /* File name, must stay valid */
+    void *buff;             /* Read buffer, must stay valid */
+    UINT len;               /* Number of bytes to append or read */
+    FSIZE_t offset;         /* Read offset */
+    UINT *done;             /* Bytes transferred, may be NULL */
+    TaskHandle_t notify;    /* Task to notify with the FRESULT, may be NULL */
+    uint8_t data[STORAGE_DATA_SIZE]; /* Append data, copied */
+} storage_request_t;
+
+/* Mount the card and start the storage task */
+BaseType_t storage_init( UBaseType_t uxPriority );
+/* Queue a request, does not wait for completion */
+BaseType_t storage_submit( const storage_request_t *req, TickType_t xTicksToWait );
+/* Queue an append of up to STORAGE_DATA_SIZE bytes without waiting
+ * for completion */
+BaseType_t storage_append_async( const TCHAR *path, const void *data, UINT len, TickType_t xTicksToWait );
+/* Read from a file and wait for completion */
+FRESULT storage_read( const TCHAR *path, void *buff, UINT len, FSIZE_t offset, UINT *done );
+/* Flush the open file and wait for completion */
+FRESULT storage_sync( void );
+
+#endif
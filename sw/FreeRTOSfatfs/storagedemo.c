@@ -0,0 +1,108 @@
+/*
+ * storagedemo.c - sensor logging to the SD card without
+ *                 stalling the time critical tasks
+ */
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include <stdio.h>
+#include <string.h>
+
+#include <thuasrv32.h>
+
+#include "storage.h"
+#include "storagedemo.h"
+
+#define LOG_FILE "0:sensor.txt"
+
+// Import from main file
+void vToggleLED( void );
+void vSendString( const char * pcString );
+
+// Number of records dropped because the queue was full
+static volatile uint32_t ulDropped = 0;
+// Number of records logged
+static volatile uint32_t ulLogged = 0;
+
+// Control task, highest priority, must never be delayed by the card
+void vControl( void *pvParameters )
+{
+    TickType_t xLastWake = xTaskGetTickCount();
+
+    while( 1 )
+    {
+        vToggleLED();
+        vTaskDelayUntil( &xLastWake, pdMS_TO_TICKS( 10 ) );
+    }
+}
+
+// Sensor task, samples the input port and logs without waiting
+void vSensor( void *pvParameters )
+{
+    char record[STORAGE_DATA_SIZE];
+    TickType_t xLastWake = xTaskGetTickCount();
+    int len;
+
+    while( 1 )
+    {
+        len = snprintf( record, sizeof record, "%lu,%08lx\n", ( unsigned long ) xTaskGetTickCount(), ( unsigned long ) GPIOA->PIN );
+        if( storage_append_async( LOG_FILE, record, len, 0 ) == pdPASS )
+        {
+            ulLogged++;
+        }
+        else
+        {
+            ulDropped++;
+        }
+        vTaskDelayUntil( &xLastWake, pdMS_TO_TICKS( 50 ) );
+    }
+}
+
+// Report task, reads back the start of the log and waits for completion
+void vReport( void *pvParameters )
+{
+    char buffer[STORAGE_DATA_SIZE];
+    UINT n;
+    FRESULT fr;
+
+    while( 1 )
+    {
+        vTaskDelay( pdMS_TO_TICKS( 2000 ) );
+
+        fr = storage_read( LOG_FILE, buffer, sizeof buffer - 1, 0, &n );
+        vSendString( "Logged " );
+        printdec( ulLogged );
+        vSendString( ", dropped " );
+        printdec( ulDropped );
+        vSendString( ", read " );
+        printdec( fr );
+        vSendString( ": " );
+        if( fr == FR_OK )
+        {
+            buffer[n] = '\0';
+            vSendString( buffer );
+        }
+        vSendString( "\r\n" );
+    }
+}
+
+void storagedemo( void )
+{
+    // Storage task runs below the time critical tasks
+    if( storage_init( 1 ) != pdPASS )
+    {
+        vSendString( "Storage init failed!\r\n" );
+        while( 1 );
+    }
+
+    // Create tasks
+    xTaskCreate( vControl, "Control", 256, NULL, 4, NULL );
+    xTaskCreate( vSensor, "Sensor", 512, NULL, 3, NULL );
+    xTaskCreate( vReport, "Report", 512, NULL, 2, NULL );
+
+    // Start scheduler
+    vTaskStartScheduler();
+
+    // Should not come here
+    while( 1 );
+}
@@ -0,0 +1,12 @@
+/*
+ * storagedemo.h - sensor logging to the SD card without
+ *                 stalling the time critical tasks
+ */
+
+#ifndef STORAGEDEMO_H
+#define STORAGEDEMO_H
+
+/* Create the demo tasks and start the scheduler, does not return */
+void storagedemo( void );
+
+#endif
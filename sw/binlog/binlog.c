@@ -0,0 +1,80 @@
+/*
+ * binlog.c -- log from an interrupt handler with the binary log
+ *
+ * Save the bytes from UART1 in a file and decode them with:
+ *   binlogdecode binlog.elf <file>
+ */
+
+#include <stdint.h>
+
+#include <thuasrv32.h>
+
+#ifndef F_CPU
+#define F_CPU (50000000UL)
+#endif
+#ifndef BAUD_RATE
+#define BAUD_RATE (115200UL)
+#endif
+
+/* Interrupt frequency TIMER1 */
+#define TIMER1_FREQ (1000UL)
+
+/* Interrupt codes in mcause */
+#define MCAUSE_TIMER1 (0x80000000UL+CLIC_ID_TIMER1)
+#define MCAUSE_UART1 (0x80000000UL+CLIC_ID_UART1)
+
+static volatile uint32_t ticks = 0;
+static volatile uint32_t cycles = 0;
+
+__attribute__ ((interrupt, used))
+void trap_handler(void);
+
+int main(void)
+{
+	/* Get clock frequency */
+	uint32_t speed = csr_read(0xfc1);
+	speed = (speed == 0) ? F_CPU : speed;
+
+	uart1_init(BAUD_RATE, UART_CTRL_EN);
+	binlog_init();
+
+	/* Redirect all traps to handler */
+	set_mtvec(trap_handler, TRAP_DIRECT_MODE);
+
+	timer1_setcompare(speed/TIMER1_FREQ-1UL);
+	timer1_enable_interrupt();
+	timer1_enable();
+
+	enable_irq();
+
+	BINLOG("binlog test, %u Hz, %u interrupts per second\n", speed, TIMER1_FREQ);
+
+	while (1) {
+		if (ticks >= TIMER1_FREQ) {
+			ticks = 0;
+			BINLOG("second, logging in the handler takes %u cycles\n", cycles);
+			BINLOG("inputs %08x, string %s\n", GPIOA->PIN, "from ROM");
+		}
+	}
+
+	return 0;
+}
+
+/* Handles TIMER1 and UART1 interrupts */
+void trap_handler(void)
+{
+	uint32_t mcause = csr_read(mcause);
+
+	if (mcause == MCAUSE_TIMER1) {
+		uint32_t start = csr_read(mcycle);
+
+		timer1_clear_interrupt();
+		ticks++;
+		if ((ticks % 100) == 0) {
+			BINLOG("tick %u, counter %u\n", ticks, timer1_getcounter());
+			cycles = csr_read(mcycle) - start;
+		}
+	} else if (mcause == MCAUSE_UART1) {
+		binlog_uart1_service();
+	}
+}
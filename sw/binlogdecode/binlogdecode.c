@@ -0,0 +1,363 @@
+/*
+ * binlogdecode - rebuild the text of a binary log
+ *
+ * For use with the THUAS RISC-V processor
+ *
+ * (c)2026, J.E.J. op den Brouw <J.E.J.opdenBrouw@hhs.nl>
+ *
+ * This program reads the bytes sent by the binlog library via
+ * UART1, e.g. saved from the serial port in a file, and prints
+ * the log text. The format strings are read from the .binlog
+ * section of the ELF file of the program.
+ *
+ * A record is a header word with 0xa in bits 31-28, the number
+ * of arguments in bits 27-24 and the ID of the format string in
+ * bits 23-0, followed by the arguments. All words are sent least
+ * significant byte first. The ID is the offset of the format
+ * string in the .binlog section. Bytes that do not start a valid
+ * record are skipped, so decoding can start anywhere.
+ *
+ * Options:
+ *      -v         Verbose output
+ *      -q         Quiet output, only errors are reported
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <stdint.h>
+
+/* Test for Visual Studio */
+#if defined(_MSC_VER)
+
+#pragma warning(disable : 4996)
+#include <windows.h>
+#include "getopt.h"
+
+/* Test for GCC for Windows*/
+#elif defined(WIN32) || defined(WIN64) || defined (WINNT)
+#include <getopt.h>
+#include <unistd.h>
+
+/* Probably Linux */
+#else
+
+#include <getopt.h>
+#include <unistd.h>
+
+#endif
+
+#define VERSION "v0.1.0"
+
+/* ELF file definitions, only what is needed */
+#define ELFCLASS32    (1)
+#define ELFDATA2LSB   (1)
+#define EM_RISCV      (243)
+#define SHT_PROGBITS  (1)
+#define SHF_WRITE     (1)
+#define SHF_ALLOC     (2)
+
+/* Record definitions, see binlog.h */
+#define BINLOG_SYNC       (0xa)
+#define BINLOG_MAXARGS    (4)
+#define BINLOG_ID_DROPPED (0xffffffUL)
+
+/* A read-only section of the program, for %s */
+typedef struct {
+    uint32_t addr;
+    uint32_t size;
+    unsigned char *data;
+} section_t;
+
+static section_t *sections = NULL;
+static int nsections = 0;
+
+/* The format strings */
+static char *binlog = NULL;
+static uint32_t binlog_size = 0;
+
+/* Little Endian reads from the file image */
+static uint32_t get16(const unsigned char *p) {
+    return (uint32_t) p[0] | ((uint32_t) p[1] << 8);
+}
+
+static uint32_t get32(const unsigned char *p) {
+    return get16(p) | (get16(p+2) << 16);
+}
+
+/* Read the .binlog section and the read-only sections */
+static int read_elf(const char *filename) {
+
+    FILE *fp;
+    unsigned char *image;
+    long len;
+    uint32_t shoff, shentsize, shnum, shstrndx;
+    char *shstrtab;
+    uint32_t i;
+
+    fp = fopen(filename, "rb");
+    if (fp == NULL) {
+        fprintf(stderr, "Cannot open ELF file %s\n", filename);
+        return -1;
+    }
+    fseek(fp, 0, SEEK_END);
+    len = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    image = malloc(len);
+    if (image == NULL || fread(image, 1, len, fp) != (size_t) len) {
+        fprintf(stderr, "Cannot read ELF file %s\n", filename);
+        fclose(fp);
+        return -1;
+    }
+    fclose(fp);
+
+    if (len < 52 || memcmp(image, "\177ELF", 4) != 0 || image[4] != ELFCLASS32 ||
+        image[5] != ELFDATA2LSB || get16(image+18) != EM_RISCV) {
+        fprintf(stderr, "%s is not a 32-bit RISC-V ELF file\n", filename);
+        return -1;
+    }
+
+    shoff = get32(image+32);
+    shentsize = get16(image+46);
+    shnum = get16(image+48);
+    shstrndx = get16(image+50);
+    shstrtab = (char *) image + get32(image + shoff + shstrndx*shentsize + 16);
+
+    for (i = 0; i < shnum; i++) {
+        unsigned char *sh = image + shoff + i*shentsize;
+        uint32_t type = get32(sh+4);
+        uint32_t flags = get32(sh+8);
+
+        if (strcmp(shstrtab + get32(sh), ".binlog") == 0) {
+            binlog = (char *) image + get32(sh+16);
+            binlog_size = get32(sh+20);
+        } else if (type == SHT_PROGBITS && (flags & SHF_ALLOC) && !(flags & SHF_WRITE)) {
+            sections = realloc(sections, (nsections + 1) * sizeof(section_t));
+            if (sections == NULL) {
+                fprintf(stderr, "Cannot allocate memory\n");
+                return -1;
+            }
+            sections[nsections].addr = get32(sh+12);
+            sections[nsections].size = get32(sh+20);
+            sections[nsections].data = image + get32(sh+16);
+            nsections++;
+        }
+    }
+
+    if (binlog == NULL) {
+        fprintf(stderr, "No .binlog section in %s\n", filename);
+        return -1;
+    }
+
+    return 0;
+}
+
+/* Find a string in the read-only sections */
+static const char *find_string(uint32_t addr) {
+    int i;
+
+    for (i = 0; i < nsections; i++) {
+        if (addr >= sections[i].addr && addr < sections[i].addr + sections[i].size &&
+            memchr(sections[i].data + (addr - sections[i].addr), '\0',
+                   sections[i].addr + sections[i].size - addr) != NULL) {
+            return (const char *) sections[i].data + (addr - sections[i].addr);
+        }
+    }
+    return NULL;
+}
+
+/* A valid ID is the start of a format string */
+static int valid_id(uint32_t id) {
+    return id < binlog_size && binlog[id] != '\0' && (id == 0 || binlog[id-1] == '\0');
+}
+
+/* Print the format string with the arguments */
+static void print_record(FILE *fout, const char *fmt, const uint32_t *args, int nargs) {
+
+    char spec[32];
+    const char *str;
+    int argc = 0;
+    int n;
+
+    while (*fmt != '\0') {
+        if (*fmt != '%') {
+            fputc(*fmt++, fout);
+            continue;
+        }
+        if (fmt[1] == '%') {
+            fputc('%', fout);
+            fmt += 2;
+            continue;
+        }
+
+        /* Copy flags, width and precision, skip the length modifiers */
+        n = 0;
+        spec[n++] = *fmt++;
+        while (*fmt != '\0' && strchr("-+ #0123456789.", *fmt) != NULL && n < (int) sizeof spec - 2) {
+            spec[n++] = *fmt++;
+        }
+        while (*fmt != '\0' && strchr("hlLqjzt", *fmt) != NULL) {
+            fmt++;
+        }
+        if (*fmt == '\0') {
+            break;
+        }
+        spec[n++] = *fmt;
+        spec[n] = '\0';
+
+        if (argc >= nargs) {
+            fprintf(fout, "<missing>");
+            fmt++;
+            continue;
+        }
+
+        switch (*fmt) {
+        case 'd':
+        case 'i':
+        case 'c':
+            fprintf(fout, spec, (int) (int32_t) args[argc]);
+            break;
+        case 'u':
+        case 'x':
+        case 'X':
+        case 'o':
+            fprintf(fout, spec, (unsigned int) args[argc]);
+            break;
+        case 'p':
+            fprintf(fout, "0x%08x", (unsigned int) args[argc]);
+            break;
+        case 's':
+            str = find_string(args[argc]);
+            if (str != NULL) {
+                fprintf(fout, spec, str);
+            } else {
+                fprintf(fout, "<0x%08x>", (unsigned int) args[argc]);
+            }
+            break;
+        default:
+            /* Floating point and others are not supported */
+            fprintf(fout, "<?>");
+            break;
+        }
+        argc++;
+        fmt++;
+    }
+}
+
+/* main */
+int main(int argc, char *argv[]) {
+
+    FILE *fp, *fout;
+    unsigned char *data;
+    long len, pos = 0;
+    unsigned long records = 0, skipped = 0, dropped = 0;
+
+    /* Options */
+    int opt;
+    int verbose = 0;
+
+    /* Check for 0 extra arguments */
+    if (argc == 1) {
+        printf("binlogdecode " VERSION " -- rebuild the text of a binary log\n");
+        printf("Usage: binlogdecode [-vq] elffile logfile [outputfile]\n");
+        printf("   -v        Verbose\n");
+        printf("   -q        Quiet. Only errors are reported\n\n");
+        printf("If outputfile is omitted, stdout is used\n");
+        printf("The log file contains the bytes received from UART1.\n");
+        exit(EXIT_SUCCESS);
+    }
+
+    /* Parse options */
+    while ((opt = getopt(argc, argv, "vq")) != -1) {
+        switch (opt) {
+        case 'v':
+            verbose = 1;
+            break;
+        case 'q':
+            verbose = 0;
+            break;
+        default: /* '?' */
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    if (optind + 1 >= argc) {
+        fprintf(stderr, "Please supply an ELF file and a log file\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (read_elf(argv[optind]) < 0) {
+        exit(EXIT_FAILURE);
+    }
+
+    fp = fopen(argv[optind+1], "rb");
+    if (fp == NULL) {
+        fprintf(stderr, "Cannot open log file %s\n", argv[optind+1]);
+        exit(EXIT_FAILURE);
+    }
+    fseek(fp, 0, SEEK_END);
+    len = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    data = malloc(len + 1);
+    if (data == NULL || fread(data, 1, len, fp) != (size_t) len) {
+        fprintf(stderr, "Cannot read log file %s\n", argv[optind+1]);
+        fclose(fp);
+        exit(EXIT_FAILURE);
+    }
+    fclose(fp);
+
+    if (argv[optind+2] == NULL) {
+        fout = stdout;
+    } else {
+        fout = fopen(argv[optind+2], "w");
+        if (fout == NULL) {
+            fprintf(stderr, "Cannot open output file %s\n", argv[optind+2]);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    while (pos + 4 <= len) {
+        uint32_t header = get32(data + pos);
+        uint32_t id = header & 0xffffff;
+        int nargs = (header >> 24) & 0xf;
+        uint32_t args[BINLOG_MAXARGS];
+        int i;
+
+        /* Skip bytes until a valid header */
+        if ((header >> 28) != BINLOG_SYNC || nargs > BINLOG_MAXARGS ||
+            !(valid_id(id) || (id == BINLOG_ID_DROPPED && nargs == 1))) {
+            pos++;
+            skipped++;
+            continue;
+        }
+        /* Incomplete record at the end */
+        if (pos + 4 + 4*nargs > len) {
+            break;
+        }
+        for (i = 0; i < nargs; i++) {
+            args[i] = get32(data + pos + 4 + 4*i);
+        }
+        pos += 4 + 4*nargs;
+        records++;
+
+        if (id == BINLOG_ID_DROPPED) {
+            fprintf(fout, "<%lu records dropped>\n", (unsigned long) args[0]);
+            dropped += args[0];
+        } else {
+            print_record(fout, binlog + id, args, nargs);
+        }
+    }
+
+    if (verbose) {
+        fprintf(stderr, "%lu records, %lu dropped, %lu bytes skipped, %lu bytes left\n",
+                records, dropped, skipped, (unsigned long) (len - pos));
+    }
+
+    if (fout != stdout) {
+        fclose(fout);
+    }
+
+    return 0;
+}
@@ -0,0 +1,95 @@
+/*
+ * clic.c - test the CLIC interrupt controller
+ *
+ */
+
+#include <thuasrv32.h>
+
+/* Frequency of the DE0-CV board */
+#ifndef F_CPU
+#define F_CPU (50000000UL)
+#endif
+
+/* Interrupt frequency TIMER1 */
+#define TIMER1_FREQ (10UL)
+/* Interrupt frequency TIMER2 */
+#define TIMER2_FREQ (10000UL)
+
+void timer1_handler(void);
+void timer2_handler(void);
+void trap_handler(void);
+
+int main(void)
+{
+	/* Get clock frequency */
+	uint32_t speed = csr_read(0xfc1);
+	speed = (speed == 0) ? F_CPU : speed;
+
+	if ((csr_read(0xfc2) & CSR_MXHW2_CLIC) == 0) {
+		/* No CLIC, just stop */
+		while (1);
+	}
+
+	/* Exceptions and non-vectored interrupts to trap_handler */
+	set_mtvec(trap_handler, TRAP_CLIC_MODE);
+
+	clic_init();
+	/* TIMER2 has the highest level and jumps directly to its handler */
+	clic_enable(CLIC_ID_TIMER2, 15, timer2_handler);
+	/* TIMER1 has a low level and can be preempted by TIMER2 */
+	clic_enable(CLIC_ID_TIMER1, 1, timer1_handler);
+
+	/* Activate TIMER2 compare T interrupt */
+	TIMER2->PRSC = 0;
+	TIMER2->CMPT = speed/TIMER2_FREQ-1UL;
+	TIMER2->CTRL = (1<<4)|(1<<0);
+
+	/* Set CMPT register */
+	timer1_setcompare(speed/TIMER1_FREQ-1UL);
+	/* Enable interrupt */
+	timer1_enable_interrupt();
+	/* Enable timer */
+	timer1_enable();
+
+	/* Enable global IRQ */
+	enable_irq();
+
+	while(1);
+}
+
+/* The time critical loop, toggles POUT bit 15 */
+__attribute__((interrupt, used))
+void timer2_handler(void)
+{
+	TIMER2->STAT &= ~(0xf<<4);
+	GPIOA->POUT ^= (1 << 15);
+}
+
+/* A long running handler that allows preemption by a higher
+ * level. mepc and mcause (holding the previous level) must be
+ * saved before interrupts are enabled. */
+__attribute__((interrupt, used))
+void timer1_handler(void)
+{
+	uint32_t epc = csr_read(mepc);
+	uint32_t cause = csr_read(mcause);
+
+	timer1_clear_interrupt();
+
+	/* Allow preemption */
+	csr_set(mstatus, 1 << 3);
+
+	for (volatile uint32_t i = 0; i < 10000; i++);
+	GPIOA->POUT ^= (1 << 2);
+
+	csr_clear(mstatus, 1 << 3);
+	csr_write(mepc, epc);
+	csr_write(mcause, cause);
+}
+
+/* Exceptions end here */
+__attribute__((interrupt, used))
+void trap_handler(void)
+{
+	while (1);
+}
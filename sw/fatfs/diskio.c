@@ -11,6 +11,7 @@
 #include "diskio.h"		/* Declarations of disk functions */
 
 #include <stdio.h>
+#include <string.h>
 
 /* begin THUAS RISC-V specific */
 #include <thuasrv32.h>
@@ -24,6 +25,173 @@
 #define DEV_USB		2	/* Example: Map USB MSD to physical drive 2 */
 
 
+/* begin THUAS RISC-V specific */
+/*-----------------------------------------------------------------------*/
+/* Sector cache                                                          */
+/*-----------------------------------------------------------------------*/
+/* Small fully associative (N-way) sector cache with LRU replacement.    */
+/* Single sector writes (FAT, directory) are written back on eviction or */
+/* CTRL_SYNC. A miss directly following a miss on the previous sector    */
+/* also fetches the next sector (sequential read-ahead). Multi sector    */
+/* transfers bypass the cache. Each way costs FF_MAX_SS bytes of RAM, so */
+/* keep the number of ways low on the 32 kB RAM. Set to 0 to disable.    */
+
+#ifndef DISKIO_CACHE_WAYS
+#define DISKIO_CACHE_WAYS (4)
+#endif
+#ifndef DISKIO_CACHE_READAHEAD
+#define DISKIO_CACHE_READAHEAD (1)
+#endif
+
+#if DISKIO_CACHE_WAYS > 0
+
+#define CACHE_VALID (0x01)
+#define CACHE_DIRTY (0x02)
+
+typedef struct {
+	LBA_t sector;		/* Sector held by this way */
+	uint32_t age;		/* LRU time stamp, higher is more recent */
+	uint32_t flags;		/* CACHE_VALID, CACHE_DIRTY */
+	BYTE data[FF_MAX_SS];	/* Sector contents */
+} cache_way_t;
+
+static cache_way_t cache[DISKIO_CACHE_WAYS];
+static uint32_t cache_clock;
+static LBA_t cache_lastmiss;
+static BYTE cache_lastmiss_valid = 0;
+
+/* Invalidate the whole cache, dirty contents are lost */
+static void cache_invalidate(void)
+{
+	for (uint32_t i = 0; i < DISKIO_CACHE_WAYS; i++) {
+		cache[i].flags = 0;
+	}
+	cache_lastmiss_valid = 0;
+}
+
+/* Find a sector in the cache, returns NULL if not present */
+static cache_way_t *cache_lookup(LBA_t sector)
+{
+	for (uint32_t i = 0; i < DISKIO_CACHE_WAYS; i++) {
+		if ((cache[i].flags & CACHE_VALID) && cache[i].sector == sector) {
+			return &cache[i];
+		}
+	}
+	return NULL;
+}
+
+/* Write back a dirty way */
+static uint32_t cache_writeback(cache_way_t *way)
+{
+	if (way->flags & CACHE_DIRTY) {
+		if (SD_writesector(way->sector, way->data) == SD_ERROR) {
+			return SD_ERROR;
+		}
+		way->flags &= ~CACHE_DIRTY;
+	}
+	return SD_SUCCESS;
+}
+
+/* Select a way for a new sector: an invalid way or the least recently
+ * used one. A dirty victim is written back first. Returns NULL if
+ * the write back fails. */
+static cache_way_t *cache_victim(void)
+{
+	cache_way_t *way = &cache[0];
+
+	for (uint32_t i = 0; i < DISKIO_CACHE_WAYS; i++) {
+		if (!(cache[i].flags & CACHE_VALID)) {
+			return &cache[i];
+		}
+		if (cache[i].age < way->age) {
+			way = &cache[i];
+		}
+	}
+	if (cache_writeback(way) == SD_ERROR) {
+		return NULL;
+	}
+	way->flags = 0;
+	return way;
+}
+
+/* Mark a way as most recently used */
+static void cache_touch(cache_way_t *way)
+{
+	way->age = ++cache_clock;
+}
+
+/* Write back all dirty ways */
+static uint32_t cache_sync(void)
+{
+	uint32_t ret = SD_SUCCESS;
+
+	for (uint32_t i = 0; i < DISKIO_CACHE_WAYS; i++) {
+		if (cache_writeback(&cache[i]) == SD_ERROR) {
+			ret = SD_ERROR;
+		}
+	}
+	return ret;
+}
+
+/* Read a single sector through the cache */
+static uint32_t cache_read(LBA_t sector, BYTE *buff)
+{
+	cache_way_t *way = cache_lookup(sector);
+
+	if (way == NULL) {
+		way = cache_victim();
+		if (way == NULL || SD_readsector(sector, way->data) == SD_ERROR) {
+			return SD_ERROR;
+		}
+		way->sector = sector;
+		way->flags = CACHE_VALID;
+#if DISKIO_CACHE_READAHEAD == 1
+		/* Sequential access detected, fetch the next sector too, but
+		 * make it older than the requested sector */
+		if (cache_lastmiss_valid && sector == cache_lastmiss + 1 &&
+		    cache_lookup(sector + 1) == NULL) {
+			cache_way_t *next;
+			cache_touch(way);
+			next = cache_victim();
+			if (next != NULL && next != way) {
+				if (SD_readsector(sector + 1, next->data) == SD_SUCCESS) {
+					next->sector = sector + 1;
+					next->flags = CACHE_VALID;
+					next->age = cache_clock - 1;
+				}
+			}
+		}
+#endif
+		cache_lastmiss = sector;
+		cache_lastmiss_valid = 1;
+	}
+	cache_touch(way);
+	memcpy(buff, way->data, SD_getsectorsize());
+	return SD_SUCCESS;
+}
+
+/* Write a single sector into the cache, written back later */
+static uint32_t cache_write(LBA_t sector, const BYTE *buff)
+{
+	cache_way_t *way = cache_lookup(sector);
+
+	if (way == NULL) {
+		way = cache_victim();
+		if (way == NULL) {
+			return SD_ERROR;
+		}
+		way->sector = sector;
+	}
+	memcpy(way->data, buff, SD_getsectorsize());
+	way->flags = CACHE_VALID | CACHE_DIRTY;
+	cache_touch(way);
+	return SD_SUCCESS;
+}
+
+#endif
+/* end THUAS RISC-V specific */
+
+
 /*-----------------------------------------------------------------------*/
 /* Get Drive Status                                                      */
 /*-----------------------------------------------------------------------*/
@@ -89,6 +257,9 @@ DSTATUS disk_initialize (
 #endif
 			return STA_NODISK;
 		}
+#if DISKIO_CACHE_WAYS > 0
+		cache_invalidate();
+#endif
 #if DISKIO_DEBUG == 1
 		usart_puts("ok\r\n");
 #endif
@@ -126,7 +297,20 @@ DRESULT disk_read (
 	switch (pdrv) {
 	case DEV_MMC :
 		uint32_t ret;
+#if DISKIO_CACHE_WAYS > 0
+		if (count == 1) {
+			return cache_read(sector, buff) == SD_ERROR ? RES_ERROR : RES_OK;
+		}
+#endif
 		for (uint32_t i = 0; i < count; i++) {
+#if DISKIO_CACHE_WAYS > 0
+			/* Cached copy may be newer than the card */
+			cache_way_t *way = cache_lookup(sector);
+			if (way != NULL) {
+				memcpy(buff, way->data, SD_getsectorsize());
+				ret = SD_SUCCESS;
+			} else
+#endif
 			ret = SD_readsector(sector, buff);
 			if (ret == SD_ERROR) {
 				return RES_ERROR;
@@ -168,7 +352,19 @@ DRESULT disk_write (
 	switch (pdrv) {
 	case DEV_MMC :
 		uint32_t ret;
+#if DISKIO_CACHE_WAYS > 0
+		if (count == 1) {
+			return cache_write(sector, buff) == SD_ERROR ? RES_ERROR : RES_OK;
+		}
+#endif
 		for (uint32_t i = 0; i < count; i++) {
+#if DISKIO_CACHE_WAYS > 0
+			/* Drop a stale cached copy, the card gets the new data */
+			cache_way_t *way = cache_lookup(sector);
+			if (way != NULL) {
+				way->flags = 0;
+			}
+#endif
 			ret = SD_writesector(sector, buff);
 			if (ret == SD_ERROR) {
 				return RES_ERROR;
@@ -206,8 +402,26 @@ DRESULT disk_ioctl (
 
 	switch (pdrv) {
 	case DEV_MMC :
-		/* Currently not supported */
-		return RES_PARERR;
+		switch (cmd) {
+		case CTRL_SYNC :
+			/* Flush dirty sectors to the card */
+#if DISKIO_CACHE_WAYS > 0
+			if (cache_sync() == SD_ERROR) {
+				return RES_ERROR;
+			}
+#endif
+			return RES_OK;
+		case GET_SECTOR_SIZE :
+			*(WORD *) buff = (WORD) SD_getsectorsize();
+			return RES_OK;
+		case GET_BLOCK_SIZE :
+			/* Erase block size unknown */
+			*(DWORD *) buff = 1;
+			return RES_OK;
+		default :
+			/* Currently not supported */
+			return RES_PARERR;
+		}
 	}
 
 	return RES_PARERR;
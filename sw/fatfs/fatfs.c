@@ -1,6 +1,8 @@
 #include <stdio.h>
+#include <string.h>
 
 #include "ff.h"
+#include "logfile.h"
 #include <thuasrv32.h>
 
 #ifndef F_CPU
@@ -12,6 +14,10 @@
 
 /* Set to 1 for write test on the SD card */
 #define WRITE_TEST (1)
+/* Set to 1 for preallocated fast seek log test on the SD card */
+#define LOG_TEST (1)
+#define LOG_SIZE (64UL*1024UL)
+#define LOG_RECORDS (200)
 #define PRINT_INFO (1)
 
 int main(void)
@@ -105,6 +111,49 @@ int main(void)
 #endif
 	f_close(&fp);
 #endif
+
+#if LOG_TEST == 1
+	LOGFILE lf;
+	UINT bw;
+
+	/* Open with LOG_SIZE bytes preallocated and in fast seek mode */
+	fr = logfile_open(&lf, "0:log.txt", LOG_SIZE);
+#if PRINT_INFO == 1
+	snprintf(buffer, sizeof buffer, "logfile_open: %d %s\r\n", fr, logfile_isfast(&lf) ? "fast" : "normal");
+	uart1_puts(buffer);
+#endif
+	if (fr == FR_OK) {
+		FSIZE_t start = logfile_size(&lf);
+
+		uart1_puts("Logging\r\n");
+		for (int i = 0; i < LOG_RECORDS; i++) {
+			snprintf(line, sizeof line, "record %5d\n", i);
+			fr = logfile_write(&lf, line, strlen(line), &bw);
+			if (fr != FR_OK || bw != strlen(line)) {
+				break;
+			}
+		}
+#if PRINT_INFO == 1
+		snprintf(buffer, sizeof buffer, "logfile_write: %d\r\n", fr);
+		uart1_puts(buffer);
+#endif
+		logfile_sync(&lf);
+
+		/* Random access read back of the middle record */
+		fr = logfile_seek(&lf, start + (LOG_RECORDS/2)*strlen(line));
+		if (fr == FR_OK) {
+			fr = logfile_read(&lf, line, strlen(line), &bw);
+			line[bw] = '\0';
+			uart1_puts(line);
+			uart1_puts("\r");
+		}
+		fr = logfile_close(&lf);
+#if PRINT_INFO == 1
+		snprintf(buffer, sizeof buffer, "logfile_close: %d\r\n", fr);
+		uart1_puts(buffer);
+#endif
+	}
+#endif
 	uart1_puts("Done\r\n");
 
 	while (1);
@@ -34,11 +34,11 @@
 /* This option switches f_mkfs() function. (0:Disable or 1:Enable) */
 
 
-#define FF_USE_FASTSEEK	0
+#define FF_USE_FASTSEEK	1
 /* This option switches fast seek function. (0:Disable or 1:Enable) */
 
 
-#define FF_USE_EXPAND	0
+#define FF_USE_EXPAND	1
 /* This option switches f_expand function. (0:Disable or 1:Enable) */
 
 
@@ -275,7 +275,10 @@
 /      lock control is independent of re-entrancy. */
 
 
+/* THUAS RISC-V: may be set by the Makefile, e.g. for FreeRTOS builds */
+#ifndef FF_FS_REENTRANT
 #define FF_FS_REENTRANT	0
+#endif
 #define FF_FS_TIMEOUT	1000
 /* The option FF_FS_REENTRANT switches the re-entrancy (thread safe) of the FatFs
 /  module itself. Note that regardless of this option, file access to different
@@ -39,7 +39,10 @@ void ff_memfree (
 /* Definitions of Mutex                                                   */
 /*------------------------------------------------------------------------*/
 
-#define OS_TYPE	0	/* 0:Win32, 1:uITRON4.0, 2:uC/OS-II, 3:FreeRTOS, 4:CMSIS-RTOS */
+/* THUAS RISC-V: FreeRTOS is the default, may be set by the Makefile */
+#ifndef OS_TYPE
+#define OS_TYPE	3	/* 0:Win32, 1:uITRON4.0, 2:uC/OS-II, 3:FreeRTOS, 4:CMSIS-RTOS */
+#endif
 
 
 #if   OS_TYPE == 0	/* Win32 */
@@ -0,0 +1,235 @@
+/*
+ *
+ * Preallocated log files with fast seek for THUAS RISC-V processor
+ *
+ * A log file is opened with its clusters allocated up front,
+ * preferably contiguous with f_expand, and with a cluster link
+ * map table (CLMT) so that seeking and writing never walk the
+ * FAT. Fast seek mode cannot grow a file, so the space is
+ * reserved at open and the unused tail is cut off at close.
+ *
+ * The reserved space is filled with LOGFILE_FILL bytes. If the
+ * file was not closed, e.g. after a power loss, the end of the
+ * logged data is found at open as the start of the first block
+ * of 512 bytes with only fill bytes, minus the fill bytes before
+ * it. The logged data must not contain a block of fill bytes and
+ * trailing fill bytes are lost, which is no problem for text.
+ *
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "ff.h"
+#include "logfile.h"
+
+#define LOGFILE_BLOCK (512)
+
+/* Write fill bytes from offset from up to offset to */
+static FRESULT logfile_fill(FIL *fp, FSIZE_t from, FSIZE_t to)
+{
+	BYTE buf[32];
+	FRESULT fr;
+	UINT n, bw;
+
+	memset(buf, LOGFILE_FILL, sizeof buf);
+
+	fr = f_lseek(fp, from);
+	while (fr == FR_OK && from < to) {
+		n = (to - from < sizeof buf) ? to - from : sizeof buf;
+		fr = f_write(fp, buf, n, &bw);
+		if (fr == FR_OK && bw != n) {
+			fr = FR_DENIED;
+		}
+		from += n;
+	}
+	return fr;
+}
+
+/* Find the offset after the last byte that is not a fill
+ * byte in the block at offset ofs, ofs if there is none */
+static FRESULT logfile_scan(FIL *fp, FSIZE_t ofs, FSIZE_t *last)
+{
+	BYTE buf[32];
+	FSIZE_t pos = ofs;
+	FSIZE_t stop = ofs + LOGFILE_BLOCK;
+	FRESULT fr;
+	UINT n, br;
+
+	*last = ofs;
+	if (stop > f_size(fp)) {
+		stop = f_size(fp);
+	}
+
+	fr = f_lseek(fp, ofs);
+	while (fr == FR_OK && pos < stop) {
+		n = (stop - pos < sizeof buf) ? stop - pos : sizeof buf;
+		fr = f_read(fp, buf, n, &br);
+		if (fr == FR_OK && br != n) {
+			fr = FR_INT_ERR;
+		}
+		for (UINT i = 0; fr == FR_OK && i < n; i++) {
+			if (buf[i] != LOGFILE_FILL) {
+				*last = pos + i + 1;
+			}
+		}
+		pos += n;
+	}
+	return fr;
+}
+
+/* Find the end of the logged data with a binary search for
+ * the first block with only fill bytes */
+static FRESULT logfile_findend(FIL *fp, FSIZE_t *end)
+{
+	FSIZE_t lo = 0;
+	FSIZE_t hi = (f_size(fp) + LOGFILE_BLOCK - 1) / LOGFILE_BLOCK;
+	FSIZE_t mid, last;
+	FRESULT fr = FR_OK;
+
+	*end = 0;
+	while (fr == FR_OK && lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		fr = logfile_scan(fp, mid * LOGFILE_BLOCK, &last);
+		if (last > mid * LOGFILE_BLOCK) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	/* The data ends in the block before */
+	if (fr == FR_OK && lo > 0) {
+		fr = logfile_scan(fp, (lo - 1) * LOGFILE_BLOCK, end);
+	}
+	return fr;
+}
+
+/* Open or create a log file with at least size bytes of
+ * allocated space. The file pointer is placed at the end of
+ * the logged data. */
+FRESULT logfile_open(LOGFILE *lf, const TCHAR *path, FSIZE_t size)
+{
+	FIL *fp = &lf->fil;
+	FSIZE_t used;
+	FRESULT fr;
+
+	fr = f_open(fp, path, FA_OPEN_ALWAYS | FA_READ | FA_WRITE);
+	if (fr != FR_OK) {
+		return fr;
+	}
+
+	/* Find the end, the file may not have been closed */
+	used = f_size(fp);
+	fr = logfile_findend(fp, &lf->end);
+	if (fr != FR_OK) {
+		f_close(fp);
+		return fr;
+	}
+
+	if (used == 0) {
+		/* New file, try to allocate a contiguous area */
+		fr = f_expand(fp, size, 1);
+		if (fr == FR_DENIED) {
+			/* No contiguous space, allocate by extending */
+			fr = f_lseek(fp, size);
+		}
+	} else if (f_size(fp) < size) {
+		/* Existing file, extend it to the requested size */
+		fr = f_lseek(fp, size);
+	}
+	if (fr == FR_OK && f_size(fp) < size) {
+		fr = FR_DENIED;
+	}
+	/* Fill the new space, so the end can be found */
+	if (fr == FR_OK && f_size(fp) > used) {
+		fr = logfile_fill(fp, used, f_size(fp));
+	}
+	if (fr == FR_OK) {
+		fr = f_sync(fp);
+	}
+	if (fr != FR_OK) {
+		f_close(fp);
+		return fr;
+	}
+
+	/* Create the link map. If it does not fit, use the file
+	 * in normal mode */
+	lf->clmt[0] = LOGFILE_CLMT_SIZE;
+	fp->cltbl = lf->clmt;
+	fr = f_lseek(fp, CREATE_LINKMAP);
+	if (fr == FR_NOT_ENOUGH_CORE) {
+		fp->cltbl = 0;
+		fr = FR_OK;
+	}
+	if (fr == FR_OK) {
+		fr = f_lseek(fp, lf->end);
+	}
+	if (fr != FR_OK) {
+		f_close(fp);
+	}
+
+	return fr;
+}
+
+/* Write data at the file pointer, writes beyond the allocated
+ * space are cut short */
+FRESULT logfile_write(LOGFILE *lf, const void *buff, UINT btw, UINT *bw)
+{
+	FIL *fp = &lf->fil;
+	FRESULT fr;
+
+	fr = f_write(fp, buff, btw, bw);
+	if (f_tell(fp) > lf->end) {
+		lf->end = f_tell(fp);
+	}
+	return fr;
+}
+
+/* Read data at the file pointer, reading stops at the end of
+ * the logged data */
+FRESULT logfile_read(LOGFILE *lf, void *buff, UINT btr, UINT *br)
+{
+	FIL *fp = &lf->fil;
+
+	if (f_tell(fp) >= lf->end) {
+		*br = 0;
+		return FR_OK;
+	}
+	if (btr > lf->end - f_tell(fp)) {
+		btr = lf->end - f_tell(fp);
+	}
+	return f_read(fp, buff, btr, br);
+}
+
+/* Move the file pointer, clipped to the end of the logged data */
+FRESULT logfile_seek(LOGFILE *lf, FSIZE_t ofs)
+{
+	if (ofs > lf->end) {
+		ofs = lf->end;
+	}
+	return f_lseek(&lf->fil, ofs);
+}
+
+/* Flush cached data, the allocated space is kept */
+FRESULT logfile_sync(LOGFILE *lf)
+{
+	return f_sync(&lf->fil);
+}
+
+/* Release the unused allocated space and close the file */
+FRESULT logfile_close(LOGFILE *lf)
+{
+	FIL *fp = &lf->fil;
+	FRESULT fr;
+
+	fr = f_lseek(fp, lf->end);
+	if (fr == FR_OK) {
+		fr = f_truncate(fp);
+	}
+	if (fr == FR_OK) {
+		fr = f_close(fp);
+	} else {
+		f_close(fp);
+	}
+	return fr;
+}
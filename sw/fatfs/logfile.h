@@ -0,0 +1,43 @@
+/*
+ *
+ * Preallocated log files with fast seek
+ *
+ *
+ */
+
+#ifndef LOGFILE_H
+#define LOGFILE_H
+
+#include <stdint.h>
+
+#include "ff.h"
+
+/* Number of DWORDs in the cluster link map table. A contiguous
+ * file needs 4 entries, every extra fragment needs 2 more */
+#ifndef LOGFILE_CLMT_SIZE
+#define LOGFILE_CLMT_SIZE (16)
+#endif
+
+/* Byte used to fill the allocated space after the logged data */
+#ifndef LOGFILE_FILL
+#define LOGFILE_FILL (0x00)
+#endif
+
+typedef struct {
+	FIL fil;			/* FatFs file object */
+	FSIZE_t end;			/* End of the logged data */
+	DWORD clmt[LOGFILE_CLMT_SIZE];	/* Cluster link map table */
+} LOGFILE;
+
+FRESULT logfile_open(LOGFILE *lf, const TCHAR *path, FSIZE_t size);
+FRESULT logfile_write(LOGFILE *lf, const void *buff, UINT btw, UINT *bw);
+FRESULT logfile_read(LOGFILE *lf, void *buff, UINT btr, UINT *br);
+FRESULT logfile_seek(LOGFILE *lf, FSIZE_t ofs);
+FRESULT logfile_sync(LOGFILE *lf);
+FRESULT logfile_close(LOGFILE *lf);
+
+#define logfile_tell(lf) (f_tell(&(lf)->fil))
+#define logfile_size(lf) ((lf)->end)
+#define logfile_isfast(lf) ((lf)->fil.cltbl != 0)
+
+#endif
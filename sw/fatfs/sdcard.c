@@ -30,10 +30,21 @@
 
 #define SD_DEBUG (0)
 
+/* Check the CRC16 of read data blocks */
+#ifndef SD_CHECK_CRC
+#define SD_CHECK_CRC (1)
+#endif
+
+/* Data blocks are always 512 bytes, also on SDSC cards */
+#define SD_BLOCKSIZE (512)
+
+/* Internal: data phase failed (token, CRC), retry slower */
+#define SD_DATAERROR (2)
+
 /* Read time out = 100 ms, write timeout = 250 ms */
-/* As per SDC specification */
-#define SD_READ_TIMEOUT ((F_CPU/10)/((1<<(SD_FAST+1))*8))
-#define SD_WRITE_TIMEOUT ((F_CPU/4)/((1<<(SD_FAST+1))*8))
+/* As per SDC specification, in bytes at the current speed */
+#define SD_READ_TIMEOUT ((F_CPU/10)/((1<<(prescaler+1))*8))
+#define SD_WRITE_TIMEOUT ((F_CPU/4)/((1<<(prescaler+1))*8))
 
 /* Local variables with info */
 static struct {
@@ -57,6 +68,9 @@ static struct {
 	 uint32_t psn;
 } cid;
 
+/* Current SPI2 prescaler */
+static uint32_t prescaler = SD_SLOW;
+
 /*
  * SPI2 basic transfer commands
  */
@@ -65,6 +79,7 @@ void SPI2_init(uint32_t speed)
 {
 	/* Set speed, also sets 8-bit transfers and clocking mode 0 */
 	SPI2->CTRL = speed<<8;
+	prescaler = speed;
 }
 
 /* Activate low Chip Select */
@@ -442,6 +457,97 @@ static uint32_t ext_bits(uint8_t *data, uint32_t msb, uint32_t lsb) {
 	return bits;
 }
 
+#if SD_CHECK_CRC == 1
+/* CRC16-CCITT (polynomial 0x1021, initial value 0) as used
+ * for SD data blocks, table driven for speed */
+static const uint16_t crc16_table[256] = {
+	0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50a5, 0x60c6, 0x70e7,
+	0x8108, 0x9129, 0xa14a, 0xb16b, 0xc18c, 0xd1ad, 0xe1ce, 0xf1ef,
+	0x1231, 0x0210, 0x3273, 0x2252, 0x52b5, 0x4294, 0x72f7, 0x62d6,
+	0x9339, 0x8318, 0xb37b, 0xa35a, 0xd3bd, 0xc39c, 0xf3ff, 0xe3de,
+	0x2462, 0x3443, 0x0420, 0x1401, 0x64e6, 0x74c7, 0x44a4, 0x5485,
+	0xa56a, 0xb54b, 0x8528, 0x9509, 0xe5ee, 0xf5cf, 0xc5ac, 0xd58d,
+	0x3653, 0x2672, 0x1611, 0x0630, 0x76d7, 0x66f6, 0x5695, 0x46b4,
+	0xb75b, 0xa77a, 0x9719, 0x8738, 0xf7df, 0xe7fe, 0xd79d, 0xc7bc,
+	0x48c4, 0x58e5, 0x6886, 0x78a7, 0x0840, 0x1861, 0x2802, 0x3823,
+	0xc9cc, 0xd9ed, 0xe98e, 0xf9af, 0x8948, 0x9969, 0xa90a, 0xb92b,
+	0x5af5, 0x4ad4, 0x7ab7, 0x6a96, 0x1a71, 0x0a50, 0x3a33, 0x2a12,
+	0xdbfd, 0xcbdc, 0xfbbf, 0xeb9e, 0x9b79, 0x8b58, 0xbb3b, 0xab1a,
+	0x6ca6, 0x7c87, 0x4ce4, 0x5cc5, 0x2c22, 0x3c03, 0x0c60, 0x1c41,
+	0xedae, 0xfd8f, 0xcdec, 0xddcd, 0xad2a, 0xbd0b, 0x8d68, 0x9d49,
+	0x7e97, 0x6eb6, 0x5ed5, 0x4ef4, 0x3e13, 0x2e32, 0x1e51, 0x0e70,
+	0xff9f, 0xefbe, 0xdfdd, 0xcffc, 0xbf1b, 0xaf3a, 0x9f59, 0x8f78,
+	0x9188, 0x81a9, 0xb1ca, 0xa1eb, 0xd10c, 0xc12d, 0xf14e, 0xe16f,
+	0x1080, 0x00a1, 0x30c2, 0x20e3, 0x5004, 0x4025, 0x7046, 0x6067,
+	0x83b9, 0x9398, 0xa3fb, 0xb3da, 0xc33d, 0xd31c, 0xe37f, 0xf35e,
+	0x02b1, 0x1290, 0x22f3, 0x32d2, 0x4235, 0x5214, 0x6277, 0x7256,
+	0xb5ea, 0xa5cb, 0x95a8, 0x8589, 0xf56e, 0xe54f, 0xd52c, 0xc50d,
+	0x34e2, 0x24c3, 0x14a0, 0x0481, 0x7466, 0x6447, 0x5424, 0x4405,
+	0xa7db, 0xb7fa, 0x8799, 0x97b8, 0xe75f, 0xf77e, 0xc71d, 0xd73c,
+	0x26d3, 0x36f2, 0x0691, 0x16b0, 0x6657, 0x7676, 0x4615, 0x5634,
+	0xd94c, 0xc96d, 0xf90e, 0xe92f, 0x99c8, 0x89e9, 0xb98a, 0xa9ab,
+	0x5844, 0x4865, 0x7806, 0x6827, 0x18c0, 0x08e1, 0x3882, 0x28a3,
+	0xcb7d, 0xdb5c, 0xeb3f, 0xfb1e, 0x8bf9, 0x9bd8, 0xabbb, 0xbb9a,
+	0x4a75, 0x5a54, 0x6a37, 0x7a16, 0x0af1, 0x1ad0, 0x2ab3, 0x3a92,
+	0xfd2e, 0xed0f, 0xdd6c, 0xcd4d, 0xbdaa, 0xad8b, 0x9de8, 0x8dc9,
+	0x7c26, 0x6c07, 0x5c64, 0x4c45, 0x3ca2, 0x2c83, 0x1ce0, 0x0cc1,
+	0xef1f, 0xff3e, 0xcf5d, 0xdf7c, 0xaf9b, 0xbfba, 0x8fd9, 0x9ff8,
+	0x6e17, 0x7e36, 0x4e55, 0x5e74, 0x2e93, 0x3eb2, 0x0ed1, 0x1ef0,
+};
+
+static uint16_t crc16(const uint8_t *data, uint32_t len)
+{
+	uint16_t crc = 0;
+
+	for (uint32_t i = 0; i < len; i++) {
+		crc = (crc << 8) ^ crc16_table[((crc >> 8) ^ data[i]) & 0xff];
+	}
+	return crc;
+}
+#endif
+
+/* Convert the CSD TRAN_SPEED field to the maximum clock in Hz */
+static uint32_t SD_transpeed(uint32_t speed)
+{
+	/* Time values times 10, 0 is reserved */
+	static const uint8_t value[16] = { 0, 10, 12, 13, 15, 20, 25, 30,
+	                                   35, 40, 45, 50, 55, 60, 70, 80 };
+	/* Rate unit: 0 = 100 kbit/s ... 3 = 100 Mbit/s */
+	uint32_t hz = value[(speed >> 3) & 0x0f] * 10000UL;
+
+	for (uint32_t unit = speed & 0x07; unit > 0 && unit < 4; unit--) {
+		hz *= 10;
+	}
+	return hz;
+}
+
+static uint32_t SD_readblock(uint32_t sector, uint8_t *buf);
+
+/* Switch SPI2 to the fastest setting allowed by the card. The
+ * speed is verified by reading sector 0, on CRC or token errors
+ * the next slower setting is tried. */
+static uint32_t SD_setspeed(void)
+{
+	uint8_t buf[512];
+	uint32_t maxhz = SD_transpeed(csd.speed);
+	uint32_t speed;
+
+	/* Fastest prescaler not exceeding the card's maximum */
+	for (speed = 0; speed < SD_SLOW; speed++) {
+		if ((F_CPU >> (speed+1)) <= maxhz) {
+			break;
+		}
+	}
+
+	for (; speed <= SD_SLOW; speed++) {
+		SPI2_init(speed);
+		if (SD_readblock(0, buf) == SD_SUCCESS) {
+			return SD_SUCCESS;
+		}
+	}
+	return SD_ERROR;
+}
+
 /* Initialize SD card */
 uint32_t SD_initialize(void) {
 
@@ -542,7 +648,8 @@ uint32_t SD_initialize(void) {
 		return SD_ERROR;
 	}
 
-	/* Switch to fast access: Clock /4 */
+	/* Switch to fast access for reading CSD and CID, the
+	 * data phase speed is set from the CSD later on */
 	SPI2_init(SD_FAST);
 
 	/* Get CSD (CMD9) */
@@ -617,18 +724,33 @@ uint32_t SD_initialize(void) {
 	uart1_puts(buffer);
 #endif
 
+	/* Switch to the fastest verified speed */
 	ocr.status = 1;
+	if (SD_setspeed() == SD_ERROR) {
+#if SD_DEBUG == 1
+		uart1_puts("No working speed found!\r\n");
+#endif
+		ocr.status = 0;
+		return SD_ERROR;
+	}
+#if SD_DEBUG == 1
+	snprintf(buffer, sizeof buffer, "SPI prescaler: %lu\r\n", prescaler);
+	uart1_puts(buffer);
+#endif
+
 	return SD_SUCCESS;
 }
 
-/* Read a sector of 512 bytes */
-uint32_t SD_readsector(uint32_t sector, uint8_t *buf)
+/* Read a sector of 512 bytes, returns SD_DATAERROR if
+ * the start token or the CRC is wrong */
+static uint32_t SD_readblock(uint32_t sector, uint8_t *buf)
 {
 #if SD_DEBUG == 1
 	char buffer[30];
 #endif
 	uint8_t ret = 0xff;
 	uint32_t count;
+	uint16_t crc;
 
 	// assert chip select
 	SPI2_transfer(0xff);
@@ -671,24 +793,39 @@ uint32_t SD_readsector(uint32_t sector, uint8_t *buf)
 	uart1_puts(buffer);
 #endif
 
-	if (count == 0) {
-		return SD_ERROR;
+	if (count == 0 || ret != 0xfe) {
+		// deassert chip select
+		SPI2_transfer(0xff);
+		SPI2_csdisable();
+		SPI2_transfer(0xff);
+		return SD_DATAERROR;
 	}
 
 	/* Read in the sector of 512 bytes */
-	for (int i = 0; i < ocr.sectorsize; i++) {
+	for (int i = 0; i < SD_BLOCKSIZE; i++) {
 		buf[i] = SPI2_transfer(0xff);
 	}
 
-	// Gobble CRC
-	SPI2_transfer(0xff);
-	SPI2_transfer(0xff);
+	// Read CRC
+	crc = SPI2_transfer(0xff) << 8;
+	crc |= SPI2_transfer(0xff);
 
 	// deassert chip select
 	SPI2_transfer(0xff);
 	SPI2_csdisable();
 	SPI2_transfer(0xff);
 
+#if SD_CHECK_CRC == 1
+	if (crc != crc16(buf, SD_BLOCKSIZE)) {
+#if SD_DEBUG == 1
+		uart1_puts("CRC error!\r\n");
+#endif
+		return SD_DATAERROR;
+	}
+#else
+	(void) crc;
+#endif
+
 #if SD_DEBUG == 1
 	for (int i = 0; i < 512; i++) {
 		if (i % 16 == 0) {
@@ -702,8 +839,22 @@ uint32_t SD_readsector(uint32_t sector, uint8_t *buf)
 	return SD_SUCCESS;
 }
 
-/* Write a sector of 512 bytes */
-uint32_t SD_writesector(uint32_t sector, const uint8_t *buf)
+/* Read a sector of 512 bytes, on data phase errors the
+ * read is retried at the next slower SPI speed */
+uint32_t SD_readsector(uint32_t sector, uint8_t *buf)
+{
+	uint32_t ret;
+
+	while ((ret = SD_readblock(sector, buf)) == SD_DATAERROR && prescaler < SD_SLOW) {
+		SPI2_init(prescaler + 1);
+	}
+	return (ret == SD_SUCCESS) ? SD_SUCCESS : SD_ERROR;
+}
+
+/* Write a sector of 512 bytes, returns SD_DATAERROR if
+ * there is no valid data response or the card reports a
+ * CRC error */
+static uint32_t SD_writeblock(uint32_t sector, const uint8_t *buf)
 {
 #if SD_DEBUG == 1
 	char buffer[30];
@@ -742,7 +893,7 @@ uint32_t SD_writesector(uint32_t sector, const uint8_t *buf)
 	SPI2_transfer(0xfe);
 
 	/* Send buffer to SD card */
-	for (uint32_t i = 0; i < ocr.sectorsize; i++) {
+	for (uint32_t i = 0; i < SD_BLOCKSIZE; i++) {
 		SPI2_transfer(buf[i]);
 	}
 
@@ -762,8 +913,12 @@ uint32_t SD_writesector(uint32_t sector, const uint8_t *buf)
 	snprintf(buffer, sizeof buffer, "count = %ld, token = %02x, ", count, ret);
 	uart1_puts(buffer);
 #endif
-	if (count == 0) {
-		return SD_ERROR;
+	if (count == 0 || (ret & 0x11) != 0x01) {
+		/* No (valid) data response */
+		SPI2_transfer(0xff);
+		SPI2_csdisable();
+		SPI2_transfer(0xff);
+		return SD_DATAERROR;
 	}
 	
 	if ((ret & 0x1f) == 0x05) {
@@ -787,7 +942,11 @@ uint32_t SD_writesector(uint32_t sector, const uint8_t *buf)
 		}
 
 	} else if ((ret & 0x1f) == 0x0b) {
-		/* CRC error, cannot happen on SPI */
+		/* CRC error, only if CRC checking is on in the card */
+		SPI2_transfer(0xff);
+		SPI2_csdisable();
+		SPI2_transfer(0xff);
+		return SD_DATAERROR;
 	} else if ((ret & 0x1f) == 0x0d) {
 		/* Data rejected due to write error */
 		// deassert chip select
@@ -808,6 +967,18 @@ uint32_t SD_writesector(uint32_t sector, const uint8_t *buf)
 	return SD_SUCCESS;
 }
 
+/* Write a sector of 512 bytes, on data phase errors the
+ * write is retried at the next slower SPI speed */
+uint32_t SD_writesector(uint32_t sector, const uint8_t *buf)
+{
+	uint32_t ret;
+
+	while ((ret = SD_writeblock(sector, buf)) == SD_DATAERROR && prescaler < SD_SLOW) {
+		SPI2_init(prescaler + 1);
+	}
+	return (ret == SD_SUCCESS) ? SD_SUCCESS : SD_ERROR;
+}
+
 uint32_t SD_getsectorsize(void) {
 	return ocr.sectorsize;
 }
@@ -826,4 +997,7 @@ uint32_t SD_getcsdver(void) {
 uint32_t SD_getstatus(void) {
 	return ocr.status;
 }
+uint32_t SD_getprescaler(void) {
+	return prescaler;
+}
 
@@ -54,4 +54,5 @@ uint32_t SD_getccs(void);
 uint32_t SD_getspeed(void);
 uint32_t SD_getcsdver(void);
 uint32_t SD_getstatus(void);
+uint32_t SD_getprescaler(void);
 #endif
@@ -0,0 +1,328 @@
+/*
+ * flatprof - flat profile from a PC-sampling histogram
+ *
+ * For use with the THUAS RISC-V processor
+ *
+ * (c)2026, J.E.J. op den Brouw <J.E.J.opdenBrouw@hhs.nl>
+ *
+ * This program maps the histogram printed by profile_dump(), or
+ * written by the pc_sample procedure of the OpenOCD script,
+ * to the functions of the ELF file of the profiled program and
+ * prints a flat profile, the function with the most samples
+ * first. Samples of a bucket that spans more than one function
+ * are divided according to the overlap.
+ *
+ * The histogram starts with the line
+ *   profile <start> <shift> <buckets> <samples> <other> <period>
+ * followed by lines with the bucket address and the number of
+ * samples, and ends with the line "end". All numbers are in
+ * hexadecimal. Other lines, e.g. program output, are skipped.
+ *
+ * Options:
+ *      -v         Verbose output
+ *      -q         Quiet output, only errors are reported
+ *      -a         Also print the functions without samples
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <stdint.h>
+
+/* Test for Visual Studio */
+#if defined(_MSC_VER)
+
+#pragma warning(disable : 4996)
+#include <windows.h>
+#include "getopt.h"
+
+/* Test for GCC for Windows*/
+#elif defined(WIN32) || defined(WIN64) || defined (WINNT)
+#include <getopt.h>
+#include <unistd.h>
+
+/* Probably Linux */
+#else
+
+#include <getopt.h>
+#include <unistd.h>
+
+#endif
+
+#define VERSION "v0.1.0"
+
+/* 1000 should be enough */
+#define LEN_BUFFER (1000)
+
+/* ELF file definitions, only what is needed */
+#define ELFCLASS32    (1)
+#define ELFDATA2LSB   (1)
+#define EM_RISCV      (243)
+#define SHT_SYMTAB    (2)
+#define STT_FUNC      (2)
+
+/* A function with its samples */
+typedef struct {
+    uint32_t addr;
+    uint32_t size;
+    char *name;
+    double samples;
+} function_t;
+
+static function_t *functions = NULL;
+static int nfunctions = 0;
+
+/* Little Endian reads from the file image */
+static uint32_t get16(const unsigned char *p) {
+    return (uint32_t) p[0] | ((uint32_t) p[1] << 8);
+}
+
+static uint32_t get32(const unsigned char *p) {
+    return get16(p) | (get16(p+2) << 16);
+}
+
+/* Sort functions on address */
+static int compare_address(const void *a, const void *b) {
+    const function_t *fa = a;
+    const function_t *fb = b;
+
+    if (fa->addr < fb->addr) {
+        return -1;
+    }
+    return fa->addr > fb->addr;
+}
+
+/* Sort functions on samples, most first */
+static int compare_samples(const void *a, const void *b) {
+    const function_t *fa = a;
+    const function_t *fb = b;
+
+    if (fa->samples > fb->samples) {
+        return -1;
+    }
+    return fa->samples < fb->samples;
+}
+
+/* Read the function symbols */
+static int read_elf(const char *filename) {
+
+    FILE *fp;
+    unsigned char *image;
+    long len;
+    uint32_t shoff, shentsize, shnum;
+    uint32_t i, j;
+
+    fp = fopen(filename, "rb");
+    if (fp == NULL) {
+        fprintf(stderr, "Cannot open ELF file %s\n", filename);
+        return -1;
+    }
+    fseek(fp, 0, SEEK_END);
+    len = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    image = malloc(len);
+    if (image == NULL || fread(image, 1, len, fp) != (size_t) len) {
+        fprintf(stderr, "Cannot read ELF file %s\n", filename);
+        fclose(fp);
+        return -1;
+    }
+    fclose(fp);
+
+    if (len < 52 || memcmp(image, "\177ELF", 4) != 0 || image[4] != ELFCLASS32 ||
+        image[5] != ELFDATA2LSB || get16(image+18) != EM_RISCV) {
+        fprintf(stderr, "%s is not a 32-bit RISC-V ELF file\n", filename);
+        return -1;
+    }
+
+    shoff = get32(image+32);
+    shentsize = get16(image+46);
+    shnum = get16(image+48);
+
+    for (i = 0; i < shnum; i++) {
+        unsigned char *sh = image + shoff + i*shentsize;
+
+        /* Function symbols, names from the linked string table */
+        if (get32(sh+4) == SHT_SYMTAB) {
+            unsigned char *strsh = image + shoff + get32(sh+24)*shentsize;
+            char *strtab = (char *) image + get32(strsh+16);
+            uint32_t count = get32(sh+20) / 16;
+
+            functions = realloc(functions, (nfunctions + count) * sizeof(function_t));
+            if (functions == NULL) {
+                fprintf(stderr, "Cannot allocate memory\n");
+                return -1;
+            }
+            for (j = 0; j < count; j++) {
+                unsigned char *sym = image + get32(sh+16) + j*16;
+                if ((sym[12] & 0xf) == STT_FUNC) {
+                    functions[nfunctions].addr = get32(sym+4);
+                    functions[nfunctions].size = get32(sym+8);
+                    functions[nfunctions].name = strtab + get32(sym);
+                    functions[nfunctions].samples = 0.0;
+                    nfunctions++;
+                }
+            }
+        }
+    }
+
+    qsort(functions, nfunctions, sizeof(function_t), compare_address);
+
+    return 0;
+}
+
+/* main */
+int main(int argc, char *argv[]) {
+
+    FILE *fp, *fout;
+    char buffer[LEN_BUFFER];
+    unsigned long start = 0, shift = 0, nbuckets = 0, samples = 0, other = 0, period = 0;
+    unsigned long addr, count;
+    double unknown = 0.0, total;
+    int inside = 0, found = 0;
+    int i;
+
+    /* Options */
+    int opt;
+    int verbose = 0, all = 0;
+
+    /* Check for 0 extra arguments */
+    if (argc == 1) {
+        printf("flatprof " VERSION " -- flat profile from a PC-sampling histogram\n");
+        printf("Usage: flatprof [-vqa] elffile histfile [outputfile]\n");
+        printf("   -v        Verbose\n");
+        printf("   -q        Quiet. Only errors are reported\n");
+        printf("   -a        Also print the functions without samples\n\n");
+        printf("If outputfile is omitted, stdout is used\n");
+        printf("The histogram file contains the output of profile_dump() or pc_sample.\n");
+        exit(EXIT_SUCCESS);
+    }
+
+    /* Parse options */
+    while ((opt = getopt(argc, argv, "vqa")) != -1) {
+        switch (opt) {
+        case 'v':
+            verbose = 1;
+            break;
+        case 'q':
+            verbose = 0;
+            break;
+        case 'a':
+            all = 1;
+            break;
+        default: /* '?' */
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    if (optind + 1 >= argc) {
+        fprintf(stderr, "Please supply an ELF file and a histogram file\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (read_elf(argv[optind]) < 0) {
+        exit(EXIT_FAILURE);
+    }
+
+    fp = fopen(argv[optind+1], "r");
+    if (fp == NULL) {
+        fprintf(stderr, "Cannot open histogram file %s\n", argv[optind+1]);
+        exit(EXIT_FAILURE);
+    }
+
+    /* Read the last histogram in the file */
+    while (fgets(buffer, sizeof buffer, fp) != NULL) {
+        if (sscanf(buffer, "profile %lx %lx %lx %lx %lx %lx", &start, &shift, &nbuckets, &samples, &other, &period) == 6) {
+            for (i = 0; i < nfunctions; i++) {
+                functions[i].samples = 0.0;
+            }
+            unknown = 0.0;
+            inside = 1;
+            found = 1;
+            continue;
+        }
+        if (!inside) {
+            continue;
+        }
+        if (strncmp(buffer, "end", 3) == 0) {
+            inside = 0;
+            continue;
+        }
+        if (sscanf(buffer, "%lx %lx", &addr, &count) != 2) {
+            continue;
+        }
+
+        /* Divide the samples over the functions in the bucket */
+        {
+            uint32_t size = 1UL << shift;
+            uint32_t covered = 0;
+
+            for (i = 0; i < nfunctions; i++) {
+                uint32_t lo = functions[i].addr;
+                uint32_t hi = functions[i].addr + (functions[i].size ? functions[i].size : 1);
+                if (hi <= addr || lo >= addr + size) {
+                    continue;
+                }
+                if (lo < addr) {
+                    lo = addr;
+                }
+                if (hi > addr + size) {
+                    hi = addr + size;
+                }
+                functions[i].samples += (double) count * (hi - lo) / size;
+                covered += hi - lo;
+            }
+            if (covered < size) {
+                unknown += (double) count * (size - covered) / size;
+            }
+        }
+    }
+    fclose(fp);
+
+    if (!found) {
+        fprintf(stderr, "No histogram found in %s\n", argv[optind+1]);
+        exit(EXIT_FAILURE);
+    }
+
+    if (argv[optind+2] == NULL) {
+        fout = stdout;
+    } else {
+        fout = fopen(argv[optind+2], "w");
+        if (fout == NULL) {
+            fprintf(stderr, "Cannot open output file %s\n", argv[optind+2]);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    if (verbose) {
+        fprintf(stderr, "Range %08lx-%08lx, %lu buckets of %lu bytes, %lu functions\n",
+                start, start + (nbuckets << shift), nbuckets, 1UL << shift, (unsigned long) nfunctions);
+    }
+
+    total = (samples == 0) ? 1.0 : (double) samples;
+
+    fprintf(fout, "Flat profile, %lu samples, one sample every %lu us\n\n", samples, period);
+    fprintf(fout, "  %%time     samples  function\n");
+
+    qsort(functions, nfunctions, sizeof(function_t), compare_samples);
+
+    for (i = 0; i < nfunctions; i++) {
+        if (functions[i].samples > 0.0 || all) {
+            fprintf(fout, "%7.2f  %10.1f  %s\n", 100.0 * functions[i].samples / total,
+                    functions[i].samples, functions[i].name);
+        }
+    }
+    if (unknown > 0.0) {
+        fprintf(fout, "%7.2f  %10.1f  <no function>\n", 100.0 * unknown / total, unknown);
+    }
+    if (other > 0) {
+        fprintf(fout, "%7.2f  %10lu  <outside the range>\n", 100.0 * other / total, other);
+    }
+
+    if (fout != stdout) {
+        fclose(fout);
+    }
+
+    return 0;
+}
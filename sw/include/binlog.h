@@ -0,0 +1,72 @@
+/*
+ * binlog.h -- deferred binary logging via UART1
+ */
+
+#ifndef _BINLOG_H
+#define _BINLOG_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Size of the ring buffer in words, must be a power of 2 */
+#define BINLOG_SIZE (256)
+
+/* Record header: sync nibble, number of arguments and the ID of
+ * the format string, which is its offset in the .binlog section */
+#define BINLOG_HEADER(id, n) ((0xaUL << 28) | ((uint32_t) (n) << 24) | ((uint32_t) (id) & 0xffffffUL))
+/* ID of the record with the number of dropped records */
+#define BINLOG_ID_DROPPED (0xffffffUL)
+
+/* Clear the ring buffer. UART1 must be initialized */
+void binlog_init(void);
+/* Write a record of a header and 0 to 4 arguments */
+void binlog_write0(uint32_t header);
+void binlog_write1(uint32_t header, uint32_t a);
+void binlog_write2(uint32_t header, uint32_t a, uint32_t b);
+void binlog_write3(uint32_t header, uint32_t a, uint32_t b, uint32_t c);
+void binlog_write4(uint32_t header, uint32_t a, uint32_t b, uint32_t c, uint32_t d);
+/* Wait until all records are transmitted */
+void binlog_flush(void);
+/* UART1 interrupt handler, transmits the next byte. Use as vectored
+ * or CLIC handler, e.g. clic_enable(CLIC_ID_UART1, level, binlog_uart1_handler) */
+void binlog_uart1_handler(void);
+/* Transmit the next byte, for use in a trap handler that handles
+ * the UART1 interrupt itself */
+void binlog_uart1_service(void);
+
+/* The format string is stored in the .binlog section, which is not
+ * loaded in the ROM. Its offset is the ID of the format string */
+#define BINLOG_ID(fmt) \
+	({ static const char __binlog_fmt[] __attribute__ ((section(".binlog"), used)) = fmt; \
+	   (uint32_t) __binlog_fmt; })
+
+#define BINLOG_NARGS(...) BINLOG_NARGS_(0, ##__VA_ARGS__, 4, 3, 2, 1, 0)
+#define BINLOG_NARGS_(_0, _1, _2, _3, _4, N, ...) N
+#define BINLOG_CAT(a, b) BINLOG_CAT_(a, b)
+#define BINLOG_CAT_(a, b) a ## b
+
+#define BINLOG_0(fmt) \
+	binlog_write0(BINLOG_HEADER(BINLOG_ID(fmt), 0))
+#define BINLOG_1(fmt, a) \
+	binlog_write1(BINLOG_HEADER(BINLOG_ID(fmt), 1), (uint32_t) (a))
+#define BINLOG_2(fmt, a, b) \
+	binlog_write2(BINLOG_HEADER(BINLOG_ID(fmt), 2), (uint32_t) (a), (uint32_t) (b))
+#define BINLOG_3(fmt, a, b, c) \
+	binlog_write3(BINLOG_HEADER(BINLOG_ID(fmt), 3), (uint32_t) (a), (uint32_t) (b), (uint32_t) (c))
+#define BINLOG_4(fmt, a, b, c, d) \
+	binlog_write4(BINLOG_HEADER(BINLOG_ID(fmt), 4), (uint32_t) (a), (uint32_t) (b), (uint32_t) (c), (uint32_t) (d))
+
+/* Log a printf-like format string with up to 4 integer or pointer
+ * arguments. Only the ID and the arguments are written, the text
+ * is rebuilt on the host with binlogdecode. The format must be a
+ * string literal, %s only works for strings in the ROM */
+#define BINLOG(fmt, ...) BINLOG_CAT(BINLOG_, BINLOG_NARGS(__VA_ARGS__))(fmt, ##__VA_ARGS__)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
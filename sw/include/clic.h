@@ -0,0 +1,60 @@
+/*
+ * clic.h -- definitions for the CLIC-style interrupt controller
+ */
+
+#ifndef _CLIC_H
+#define _CLIC_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Number of interrupts handled, the NMI (31) is not */
+#define CLIC_SOURCES (31)
+
+/* Disable all interrupts and set the threshold to 0 */
+void clic_init(void);
+/* Enable an interrupt with a level (0-15, 15 is most urgent). If
+ * handler is not NULL, the core jumps directly to the handler,
+ * otherwise to the address in mtvec. */
+void clic_enable(uint32_t id, uint32_t level, void (*handler)(void));
+/* Disable an interrupt */
+void clic_disable(uint32_t id);
+/* Set the interrupt level threshold, use CLIC_THRESHOLD(n)
+ * to block all interrupts with a level up to and including n */
+void clic_set_threshold(uint32_t thresh);
+
+/* INTCTL bits */
+#define CLIC_IP         (1 << 0)
+#define CLIC_IE         (1 << 1)
+#define CLIC_SHV        (1 << 2)
+#define CLIC_LEVEL(x)   (((x) & 0xf) << 4)
+
+/* 8-bit threshold that blocks levels 0 to n */
+#define CLIC_THRESHOLD(n) ((((n) & 0xf) << 4) | 0xf)
+
+/* Interrupt IDs, the same as the cause in mcause */
+#define CLIC_ID_MSI     (3)
+#define CLIC_ID_MTIME   (7)
+#define CLIC_ID_EXTI    (18)
+#define CLIC_ID_UART2   (19)
+#define CLIC_ID_TIMER1  (20)
+#define CLIC_ID_TIMER2  (21)
+#define CLIC_ID_DMA     (22)
+#define CLIC_ID_UART1   (23)
+#define CLIC_ID_I2C2    (24)
+#define CLIC_ID_SPI2    (25)
+#define CLIC_ID_I2C1    (26)
+#define CLIC_ID_SPI1    (27)
+
+/* In CLIC mode, mcause holds the previous interrupt level (mpil)
+ * in bits 23:16, mask it off to get the cause */
+#define CLIC_MCAUSE_MASK (0x8000ffffUL)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
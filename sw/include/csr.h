@@ -33,6 +33,9 @@ uint64_t csr_get_mhpmcounter7(void);
 uint64_t csr_get_mhpmcounter8(void);
 /* Get mhpmcounter9 */
 uint64_t csr_get_mhpmcounter9(void);
+/* Load HPM counter 3 to 9 so that it overflows after period
+ * events and clear its overflow flag */
+void csr_hpm_set_period(uint32_t counter, uint32_t period);
 
 /* Some macros to read/write CSRs, based on */
 /* https://github.com/torvalds/linux/blob/master/arch/riscv/include/asm/csr.h */
@@ -108,6 +111,9 @@ uint64_t csr_get_mhpmcounter9(void);
 #define CSR_MXHW_SPI2      (1 << 9)
 #define CSR_MXHW_TIMER1    (1 << 10)
 #define CSR_MXHW_TIMER2    (1 << 11)
+#define CSR_MXHW_DMA       (1 << 12)
+#define CSR_MXHW_BP        (1 << 13)
+#define CSR_MXHW_BTB       (1 << 14)
 #define CSR_MXHW_MULDIV    (1 << 16)
 #define CSR_MXHW_FASTDV    (1 << 17)
 #define CSR_MXHW_BOOT      (1 << 18)
@@ -125,15 +131,65 @@ uint64_t csr_get_mhpmcounter9(void);
 #define CSR_MXHW_ZBB       (1 << 30)
 #define CSR_MXHW_CRC       (1 << 31)
 
+/* MXHW2 bits */
+#define CSR_MXHW2_FASTMUL  (1 << 0)
+#define CSR_MXHW2_EARLYDV  (1 << 1)
+#define CSR_MXHW2_PREFETCH (1 << 2)
+#define CSR_MXHW2_FASTLOAD (1 << 3)
+#define CSR_MXHW2_STOREBUF (1 << 4)
+#define CSR_MXHW2_ZCB      (1 << 5)
+#define CSR_MXHW2_ZCMP     (1 << 6)
+#define CSR_MXHW2_CLIC     (1 << 7)
+#define CSR_MXHW2_SHADOW   (1 << 8)
+#define CSR_MXHW2_TRACE    (1 << 9)
+
 /* HPM selection bits */
+/* Jumps/branches that flush the pipeline (mispredicted) */
 #define CSR_HPM_JUMP       (1 << 0)
 #define CSR_HPM_BRANCH     (1 << 0)
+#define CSR_HPM_MISPREDICT (1 << 0)
 #define CSR_HPM_STALLS     (1 << 1)
 #define CSR_HPM_STORES     (1 << 2)
 #define CSR_HPM_LOADS      (1 << 3)
 #define CSR_HPM_ECALLS     (1 << 4)
 #define CSR_HPM_EBREAKS    (1 << 5)
 #define CSR_HPM_MULDIV     (1 << 6)
+/* Jumps/branches correctly predicted */
+#define CSR_HPM_PREDICTED  (1 << 7)
+/* Pipeline flush cycles */
+#define CSR_HPM_FLUSH      (1 << 8)
+/* Cycles waiting in WFI */
+#define CSR_HPM_WFI        (1 << 9)
+/* Traps (interrupts and exceptions) taken */
+#define CSR_HPM_TRAPS      (1 << 10)
+/* Trap entry and MRET cycles */
+#define CSR_HPM_TRAPCYCLES (1 << 11)
+/* Interrupts taken */
+#define CSR_HPM_INTERRUPTS (1 << 12)
+/* I/O accesses */
+#define CSR_HPM_IO         (1 << 13)
+/* Cycles waiting for I/O */
+#define CSR_HPM_IOWAIT     (1 << 14)
+/* Cycles waiting for ROM, boot ROM or RAM */
+#define CSR_HPM_MEMWAIT    (1 << 15)
+/* Multiply/divide busy cycles */
+#define CSR_HPM_MULDIVBUSY (1 << 16)
+/* Load-use hazard cycles */
+#define CSR_HPM_LOADUSE    (1 << 17)
+/* Instructions retired */
+#define CSR_HPM_INSTRET    (1 << 18)
+/* Clock cycles */
+#define CSR_HPM_CYCLES     (1 << 19)
+/* MRETs */
+#define CSR_HPM_MRETS      (1 << 20)
+/* Inhibit counting (MINH) */
+#define CSR_HPM_MINH       (1 << 30)
+/* Counter overflow flag (OF) */
+#define CSR_HPM_OF         (1UL << 31)
+
+/* Counter overflow interrupt in mie/mip and mcause */
+#define CSR_MIE_LCOFIE     (1 << 13)
+#define CSR_MCAUSE_LCOFI   (13)
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,70 @@
+/*
+ * dma.h -- definitions for the DMA controller
+ */
+
+#ifndef _DMA_H
+#define _DMA_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Number of channels, lower channels have priority */
+#define DMA_CHANNELS (4)
+/* Channel used by dma_memcpy */
+#ifndef DMA_MEMCPY_CHANNEL
+#define DMA_MEMCPY_CHANNEL (DMA_CHANNELS-1)
+#endif
+
+/* Disable all channels and clear all flags */
+void dma_init(void);
+/* Set up and enable a channel */
+void dma_start(uint32_t ch, uint32_t ctrl, volatile void *src, volatile void *dst, uint32_t cnt);
+/* Disable a channel */
+void dma_stop(uint32_t ch);
+/* Wait for a channel to complete, returns 0 or -1 on bus error */
+int dma_wait(uint32_t ch);
+/* Copy a block of memory using DMA_MEMCPY_CHANNEL */
+int dma_memcpy(void *dst, const void *src, uint32_t len);
+
+/* CTRL bits */
+#define DMA_EN          (1 << 0)
+#define DMA_TCIE        (1 << 1)
+#define DMA_SSIZE8      (0 << 2)
+#define DMA_SSIZE16     (1 << 2)
+#define DMA_SSIZE32     (2 << 2)
+#define DMA_DSIZE8      (0 << 4)
+#define DMA_DSIZE16     (1 << 4)
+#define DMA_DSIZE32     (2 << 4)
+#define DMA_SINC        (1 << 6)
+#define DMA_DINC        (1 << 7)
+#define DMA_TRIG(x)     ((x) << 8)
+
+/* Trigger sources, SPI and I2C RX channels must have
+ * a lower channel number than the TX channels */
+#define DMA_TRIG_ALWAYS    (0)
+#define DMA_TRIG_UART1_RX  (1)
+#define DMA_TRIG_UART1_TX  (2)
+#define DMA_TRIG_SPI1_RX   (3)
+#define DMA_TRIG_SPI1_TX   (4)
+#define DMA_TRIG_SPI2_RX   (5)
+#define DMA_TRIG_SPI2_TX   (6)
+#define DMA_TRIG_I2C1_RX   (7)
+#define DMA_TRIG_I2C1_TX   (8)
+#define DMA_TRIG_I2C2_RX   (9)
+#define DMA_TRIG_I2C2_TX   (10)
+#define DMA_TRIG_UART2_RX  (11)
+#define DMA_TRIG_UART2_TX  (12)
+
+/* STAT bits */
+#define DMA_TC(ch)      (1 << (ch))
+#define DMA_ERR(ch)     (1 << ((ch)+4))
+#define DMA_BUSY(ch)    (1 << ((ch)+8))
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
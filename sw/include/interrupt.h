@@ -13,6 +13,7 @@
 
 #define TRAP_DIRECT_MODE (0)
 #define TRAP_VECTORED_MODE (1)
+#define TRAP_CLIC_MODE (3)
 
 /* Frame for traps */
 typedef struct {
@@ -46,7 +47,7 @@ typedef struct {
     __asm__ volatile ("csrr %0, mtvec" : "=r"(__tmp)); \
     __tmp; })
 
-/* Set the mtvec CSR, using mode TRAP_DIRECT_MODE or TRAP_VECTORED_MODE */
+/* Set the mtvec CSR, using mode TRAP_DIRECT_MODE, TRAP_VECTORED_MODE or TRAP_CLIC_MODE */
 #define set_mtvec(VECTOR, MODE) \
     __asm__ volatile (".option push;" \
                       ".option norelax;" \
@@ -60,6 +61,12 @@ typedef struct {
                           "csrsi mtvec,1;" \
                           ".option pop" \
                           ::: ); \
+    } else if (MODE == TRAP_CLIC_MODE) { \
+        __asm__ volatile (".option push;" \
+                          ".option norelax;" \
+                          "csrsi mtvec,3;" \
+                          ".option pop" \
+                          ::: ); \
     }
 
 #define enable_external_timer_irq() \
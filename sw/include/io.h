@@ -213,6 +213,61 @@ typedef struct {
 #define CRC_DATA (*(volatile uint32_t*)(CRC_BASE+0x00000010UL))
 
 
+/*
+ * DMA controller
+ */
+typedef struct {
+	volatile uint32_t CTRL;
+	volatile uint32_t SRC;
+	volatile uint32_t DST;
+	volatile uint32_t CNT;  /* only low 16 bits used */
+} DMA_channel_t;
+
+typedef struct {
+	volatile uint32_t STAT;
+	volatile uint32_t reserved[15];
+	DMA_channel_t CH[4];
+} DMA_struct_t;
+
+#define DMA_BASE (IO_BASE+0x00000d00UL)
+#define DMA ((DMA_struct_t *) DMA_BASE)
+#define DMA_STAT (*(volatile uint32_t*)(DMA_BASE+0x00000000UL))
+
+
+/*
+ * CLIC-style interrupt controller
+ */
+typedef struct {
+	volatile uint32_t INTCTL[32];  /* entry 31 not used */
+	volatile uint32_t VECTOR[32];  /* entry 31 not used */
+} CLIC_struct_t;
+
+#define CLIC_BASE (IO_BASE+0x00000e00UL)
+#define CLIC ((CLIC_struct_t *) CLIC_BASE)
+
+
+/*
+ * Instruction trace buffer
+ */
+typedef struct {
+	volatile uint32_t CTRL;
+	volatile uint32_t STAT;
+	volatile uint32_t WPTR;
+	volatile uint32_t RPTR;
+	volatile uint32_t DATA; /* RPTR is incremented on read */
+	volatile uint32_t SIZE;
+} TRACE_struct_t;
+
+#define TRACE_BASE (IO_BASE+0x00000f00UL)
+#define TRACE ((TRACE_struct_t *) TRACE_BASE)
+#define TRACE_CTRL (*(volatile uint32_t*)(TRACE_BASE+0x00000000UL))
+#define TRACE_STAT (*(volatile uint32_t*)(TRACE_BASE+0x00000004UL))
+#define TRACE_WPTR (*(volatile uint32_t*)(TRACE_BASE+0x00000008UL))
+#define TRACE_RPTR (*(volatile uint32_t*)(TRACE_BASE+0x0000000cUL))
+#define TRACE_DATA (*(volatile uint32_t*)(TRACE_BASE+0x00000010UL))
+#define TRACE_SIZE (*(volatile uint32_t*)(TRACE_BASE+0x00000014UL))
+
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,37 @@
+/*
+ * profile.h -- statistical PC-sampling profiler
+ */
+
+#ifndef _PROFILE_H
+#define _PROFILE_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Set up a histogram of nbuckets counters for the addresses from
+ * start to end, sampled rate times per second. The bucket size is
+ * rounded up to a power of 2. Sampling is stopped. */
+void profile_init(uint32_t *buckets, uint32_t nbuckets, uint32_t start, uint32_t end, uint32_t rate);
+/* Clear the histogram */
+void profile_clear(void);
+/* Start sampling, arms MTIMECMP and enables the MTIME interrupt */
+void profile_start(void);
+/* Stop sampling */
+void profile_stop(void);
+/* MTIME interrupt handler, records mepc. Use as vectored or CLIC
+ * handler, e.g. clic_enable(CLIC_ID_MTIME, level, profile_handler) */
+void profile_handler(void);
+/* Record the sample pc and rearm MTIMECMP, for use in a
+ * trap handler that handles the MTIME interrupt itself */
+void profile_sample(uint32_t pc);
+/* Print the histogram to UART1, decode with flatprof */
+void profile_dump(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,44 @@
+/*
+ * shadow.h -- shadow register bank for interrupt handlers
+ */
+
+#ifndef _SHADOW_H
+#define _SHADOW_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* mxbank CSR bits */
+#define SHADOW_BANK     (1 << 0)
+#define SHADOW_PBANK    (1 << 1)
+#define SHADOW_EN       (1 << 2)
+#define SHADOW_NEST     (1 << 3)
+
+/* Switch to the shadow bank on interrupt entry */
+#define shadow_enable() csr_set(0x7c0, SHADOW_EN)
+/* Interrupts use the normal bank */
+#define shadow_disable() csr_clear(0x7c0, SHADOW_EN)
+
+/* Set the stack pointer and global pointer of the shadow bank.
+ * Must be called from the main program, uses mepc and mscratch. */
+void shadow_init(void *stack_top);
+
+/* Create interrupt handler NAME that runs the normal C function
+ * FUNC in the shadow bank. No registers are saved or restored.
+ * Interrupts are not taken in the shadow bank, not even if the
+ * handler enables them. */
+#define SHADOW_HANDLER(NAME, FUNC) \
+	void __attribute__((naked, used)) NAME(void) \
+	{ \
+		__asm__ volatile ("call " #FUNC ";" \
+		                  "mret"); \
+	}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -22,6 +22,13 @@
 #include <timer.h>
 #include <wdt.h>
 #include <crc.h>
+#include <dma.h>
+#include <clic.h>
+#include <shadow.h>
+#include <trace.h>
+#include <profile.h>
+#include <timing.h>
+#include <binlog.h>
 
 #endif
 
@@ -0,0 +1,65 @@
+/*
+ * timing.h -- cycle accurate timing of code regions
+ */
+
+#ifndef _TIMING_H
+#define _TIMING_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Number of regions and maximum nesting depth */
+#define TIMING_REGIONS (16)
+#define TIMING_DEPTH (8)
+
+/* Statistics of a region, cycles and events exclude the
+ * overhead of the markers. self excludes nested regions */
+typedef struct {
+	const char *name;
+	uint32_t count;
+	uint32_t min;
+	uint32_t max;
+	uint64_t total;
+	uint64_t self;
+	uint64_t events;
+} timing_region_t;
+
+/* Set up the timing of regions. If event is not 0, it is
+ * counted with mhpmcounter3, e.g. CSR_HPM_STALLS. Measures the
+ * overhead of the markers and clears all regions */
+void timing_init(uint32_t event);
+/* Clear the statistics of all regions */
+void timing_reset(void);
+/* Start of region id, name is only copied the first time */
+void timing_begin(uint32_t id, const char *name);
+/* End of region id, must match the last started region */
+void timing_end(uint32_t id);
+/* Get the statistics of region id, NULL if out of range */
+const timing_region_t *timing_get(uint32_t id);
+/* Print the statistics of the used regions with UART1 */
+void timing_report(void);
+
+/* Use the macros in the code, compile with -DTIMING_DISABLE
+ * to remove all timing code */
+#ifdef TIMING_DISABLE
+#define TIMING_INIT(event) do { } while (0)
+#define TIMING_RESET() do { } while (0)
+#define TIMING_BEGIN(id, name) do { } while (0)
+#define TIMING_END(id) do { } while (0)
+#define TIMING_REPORT() do { } while (0)
+#else
+#define TIMING_INIT(event) timing_init(event)
+#define TIMING_RESET() timing_reset()
+#define TIMING_BEGIN(id, name) timing_begin(id, name)
+#define TIMING_END(id) timing_end(id)
+#define TIMING_REPORT() timing_report()
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,37 @@
+/*
+ * trace.h -- definitions for the instruction trace buffer
+ */
+
+#ifndef _TRACE_H
+#define _TRACE_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Clear the buffer and start tracing, use TRACE_ONESHOT to
+ * stop when the buffer is full instead of overwriting */
+void trace_start(uint32_t ctrl);
+/* Stop tracing, the buffer is kept */
+void trace_stop(void);
+/* Copy the newest words, at most len, from the buffer, oldest
+ * word first. Returns the number of words copied. */
+uint32_t trace_read(uint32_t *buf, uint32_t len);
+
+/* CTRL bits */
+#define TRACE_EN       (1 << 0)
+#define TRACE_CLR      (1 << 1)
+#define TRACE_ONESHOT  (1 << 2)
+
+/* STAT bits */
+#define TRACE_WRAP     (1 << 0)
+#define TRACE_OVR      (1 << 1)
+#define TRACE_FULL     (1 << 2)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,247 @@
+/*
+ * irqlatency.c -- interrupt latency and jitter benchmark
+ *
+ * TIMER2 runs at the system clock and generates a compare match T
+ * interrupt. The handler reads the TIMER2 counter, which is reset at
+ * the compare match, as soon as possible, so the counter holds the
+ * number of clock cycles from the compare match to the read. The
+ * latency is measured in direct and vectored mode, with the main
+ * program idle, dividing and multiplying or copying memory. The
+ * compare match value is varied, so that the interrupt hits the
+ * main program at different instructions. The handler duration is
+ * measured with mcycle. OCT (TIMER2 channel T output) toggles on
+ * every compare match and can be used to check the trigger.
+ */
+
+#include <stdint.h>
+
+#include <thuasrv32.h>
+
+#ifndef F_CPU
+#define F_CPU (50000000UL)
+#endif
+#ifndef BAUD_RATE
+#define BAUD_RATE (115200UL)
+#endif
+
+/* Number of samples per test */
+#define SAMPLES (1000)
+/* Number of histogram bins of one clock cycle, the last bin
+ * counts the samples that do not fit */
+#define BINS (64)
+/* Base compare match value, varied by up to 60 clock cycles */
+#define PERIOD (2000)
+
+/* Results of one test */
+static volatile uint32_t samples;
+static uint32_t histogram[BINS+1];
+static uint32_t minimum, maximum;
+static uint32_t total, handler_total;
+/* Buffers for the memory load */
+static volatile uint32_t copy_src[64], copy_dst[64];
+
+/* Stubs and handlers */
+void latency_direct(void);
+void latency_table(void);
+void latency_vectored(void);
+void latency_handler(void);
+void latency_default(void);
+
+/* Direct mode: check for the TIMER2 interrupt (mcause 0x80000015),
+ * then read the counter. The counter is passed in mscratch */
+__attribute__ ((naked, aligned(4)))
+void latency_direct(void)
+{
+	__asm__ volatile (".option push\n"
+	                  ".option norvc\n"
+	                  "csrw  mscratch, t0\n"
+	                  "csrr  t0, mcause\n"
+	                  "slli  t0, t0, 1\n"
+	                  "addi  t0, t0, -42\n"
+	                  "bnez  t0, 1f\n"
+	                  /* Read TIMER2_CNTR */
+	                  "lui   t0, %hi(0xf0000708)\n"
+	                  "lw    t0, %lo(0xf0000708)(t0)\n"
+	                  "csrrw t0, mscratch, t0\n"
+	                  "j     latency_handler\n"
+	                  "1:\n"
+	                  "csrr  t0, mscratch\n"
+	                  "j     latency_default\n"
+	                  ".option pop\n");
+}
+
+/* Vectored mode: the vector table jumps to the stub of TIMER2 (21).
+ * The entries must not be compressed */
+__attribute__ ((naked, aligned(4)))
+void latency_table(void)
+{
+	__asm__ volatile (".option push\n"
+	                  ".option norvc\n"
+	                  ".rept 21\n"
+	                  "j     latency_default\n"
+	                  ".endr\n"
+	                  "j     latency_vectored\n"
+	                  ".rept 10\n"
+	                  "j     latency_default\n"
+	                  ".endr\n"
+	                  ".option pop\n");
+}
+
+__attribute__ ((naked, aligned(4)))
+void latency_vectored(void)
+{
+	__asm__ volatile (".option push\n"
+	                  ".option norvc\n"
+	                  "csrw  mscratch, t0\n"
+	                  /* Read TIMER2_CNTR */
+	                  "lui   t0, %hi(0xf0000708)\n"
+	                  "lw    t0, %lo(0xf0000708)(t0)\n"
+	                  "csrrw t0, mscratch, t0\n"
+	                  "j     latency_handler\n"
+	                  ".option pop\n");
+}
+
+/* Records the latency in mscratch and sets the next compare match */
+__attribute__ ((interrupt, used))
+void latency_handler(void)
+{
+	uint32_t start = csr_read(mcycle);
+	uint32_t latency = csr_read(mscratch);
+
+	TIMER2->STAT &= ~(0xf<<4);
+
+	if (samples < SAMPLES) {
+		histogram[(latency < BINS) ? latency : BINS]++;
+		if (latency < minimum) {
+			minimum = latency;
+		}
+		if (latency > maximum) {
+			maximum = latency;
+		}
+		total += latency;
+		samples++;
+	}
+
+	TIMER2->CMPT = PERIOD + (samples * 37) % 61;
+
+	handler_total += csr_read(mcycle) - start;
+}
+
+/* Unexpected traps, hold the processor */
+__attribute__ ((interrupt, used))
+void latency_default(void)
+{
+	GPIOA->POUT |= (1 << 9);
+	while (1);
+}
+
+/* Loads for the main program, run until all samples are taken */
+static void load_idle(void)
+{
+	while (samples < SAMPLES) {
+	}
+}
+
+static void load_muldiv(void)
+{
+	volatile uint32_t a = 0x7fffffff, b = 3;
+	uint32_t q;
+
+	while (samples < SAMPLES) {
+		q = a / b;
+		q = q * a;
+		a = q | 0x40000000;
+	}
+}
+
+static void load_memory(void)
+{
+	while (samples < SAMPLES) {
+		for (int i = 0; i < 64; i++) {
+			copy_dst[i] = copy_src[i];
+		}
+	}
+}
+
+/* Run one test and print the histogram */
+static void run_test(const char *mode, const char *load, void (*func)(void))
+{
+	uint32_t peak = 1;
+
+	for (int i = 0; i <= BINS; i++) {
+		histogram[i] = 0;
+	}
+	minimum = -1;
+	maximum = 0;
+	total = 0;
+	handler_total = 0;
+	samples = 0;
+
+	/* Compare match T interrupt, OCT toggles */
+	TIMER2->CTRL = 0;
+	TIMER2->STAT = 0;
+	TIMER2->PRSC = 0;
+	TIMER2->CNTR = 0;
+	TIMER2->CMPT = PERIOD;
+	TIMER2->CTRL = (1 << 12) | (1 << 4) | (1 << 0);
+
+	enable_irq();
+	func();
+	disable_irq();
+
+	TIMER2->CTRL = 0;
+	TIMER2->STAT = 0;
+
+	uart1_printf("\r\n%s mode, %s: %d samples\r\n", mode, load, SAMPLES);
+	uart1_printf("min %lu, max %lu, avg %lu.%lu, jitter %lu cycles, handler %lu cycles\r\n",
+	             minimum, maximum, total / SAMPLES, (total * 10 / SAMPLES) % 10,
+	             maximum - minimum, handler_total / SAMPLES);
+
+	for (int i = 0; i <= BINS; i++) {
+		if (histogram[i] > peak) {
+			peak = histogram[i];
+		}
+	}
+	for (int i = 0; i <= BINS; i++) {
+		if (histogram[i] != 0) {
+			if (i < BINS) {
+				uart1_printf("%4d | %5lu ", i, histogram[i]);
+			} else {
+				uart1_printf(">=%2d | %5lu ", BINS, histogram[i]);
+			}
+			for (uint32_t j = 0; j < (histogram[i] * 50 + peak - 1) / peak; j++) {
+				uart1_putc('*');
+			}
+			uart1_puts("\r\n");
+		}
+	}
+}
+
+int main(void)
+{
+	int muldiv = (csr_read(0xfc0) & CSR_MXHW_MULDIV) != 0;
+
+	uart1_init(BAUD_RATE, UART_CTRL_EN);
+	uart1_puts("\r\nInterrupt latency benchmark\r\n");
+	uart1_puts("Cycles from TIMER2 compare match to the counter read in the handler\r\n");
+
+	while (1) {
+		set_mtvec(latency_direct, TRAP_DIRECT_MODE);
+		run_test("Direct", "idle", load_idle);
+		if (muldiv) {
+			run_test("Direct", "mul/div", load_muldiv);
+		}
+		run_test("Direct", "memory", load_memory);
+
+		set_mtvec(latency_table, TRAP_VECTORED_MODE);
+		run_test("Vectored", "idle", load_idle);
+		if (muldiv) {
+			run_test("Vectored", "mul/div", load_muldiv);
+		}
+		run_test("Vectored", "memory", load_memory);
+
+		delayms(5000);
+	}
+
+	return 0;
+}
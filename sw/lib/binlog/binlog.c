@@ -0,0 +1,156 @@
+/*
+ * binlog.c -- deferred binary logging via UART1
+ *
+ * A record is a header with the ID of the format string and the
+ * number of arguments, followed by the raw arguments. Records are
+ * written in a ring buffer with interrupts disabled and transmitted
+ * by the UART1 transmit interrupt, least significant byte first.
+ * Writing a record costs tens of clock cycles and can be done from
+ * interrupt handlers. If the buffer is full, the record is dropped
+ * and the number of dropped records is sent with the next record
+ * that fits.
+ */
+
+#include <thuasrv32.h>
+
+#define BINLOG_MASK (BINLOG_SIZE - 1)
+
+static struct {
+	uint32_t buffer[BINLOG_SIZE];
+	volatile uint32_t head;
+	volatile uint32_t tail;
+	volatile uint32_t byte;
+	volatile uint32_t busy;
+	uint32_t dropped;
+} binlog;
+
+/* Send the first byte of the word at the tail, interrupts are disabled */
+static void binlog_kick(void)
+{
+	binlog.busy = 1;
+	binlog.byte = 1;
+	UART1->DATA = binlog.buffer[binlog.tail] & 0xff;
+	UART1->CTRL |= UART_CTRL_TCIE;
+}
+
+static inline __attribute__ ((always_inline))
+void binlog_record(uint32_t header, uint32_t a, uint32_t b, uint32_t c, uint32_t d)
+{
+	uint32_t n = (header >> 24) & 0xf;
+	uint32_t mstatus = csr_read_clear(mstatus, 1 << 3);
+	uint32_t head = binlog.head;
+	uint32_t space = (binlog.tail - head - 1) & BINLOG_MASK;
+
+	if (binlog.dropped != 0) {
+		if (space < n + 3) {
+			binlog.dropped++;
+			csr_set(mstatus, mstatus & (1 << 3));
+			return;
+		}
+		binlog.buffer[head] = BINLOG_HEADER(BINLOG_ID_DROPPED, 1);
+		binlog.buffer[(head + 1) & BINLOG_MASK] = binlog.dropped;
+		head = (head + 2) & BINLOG_MASK;
+		binlog.dropped = 0;
+	} else if (space < n + 1) {
+		binlog.dropped++;
+		csr_set(mstatus, mstatus & (1 << 3));
+		return;
+	}
+
+	binlog.buffer[head] = header;
+	head = (head + 1) & BINLOG_MASK;
+	if (n > 0) {
+		binlog.buffer[head] = a;
+		head = (head + 1) & BINLOG_MASK;
+	}
+	if (n > 1) {
+		binlog.buffer[head] = b;
+		head = (head + 1) & BINLOG_MASK;
+	}
+	if (n > 2) {
+		binlog.buffer[head] = c;
+		head = (head + 1) & BINLOG_MASK;
+	}
+	if (n > 3) {
+		binlog.buffer[head] = d;
+		head = (head + 1) & BINLOG_MASK;
+	}
+	binlog.head = head;
+
+	if (!binlog.busy) {
+		binlog_kick();
+	}
+
+	csr_set(mstatus, mstatus & (1 << 3));
+}
+
+void binlog_init(void)
+{
+	UART1->CTRL &= ~UART_CTRL_TCIE;
+	binlog.head = 0;
+	binlog.tail = 0;
+	binlog.byte = 0;
+	binlog.busy = 0;
+	binlog.dropped = 0;
+}
+
+void binlog_write0(uint32_t header)
+{
+	binlog_record(header, 0, 0, 0, 0);
+}
+
+void binlog_write1(uint32_t header, uint32_t a)
+{
+	binlog_record(header, a, 0, 0, 0);
+}
+
+void binlog_write2(uint32_t header, uint32_t a, uint32_t b)
+{
+	binlog_record(header, a, b, 0, 0);
+}
+
+void binlog_write3(uint32_t header, uint32_t a, uint32_t b, uint32_t c)
+{
+	binlog_record(header, a, b, c, 0);
+}
+
+void binlog_write4(uint32_t header, uint32_t a, uint32_t b, uint32_t c, uint32_t d)
+{
+	binlog_record(header, a, b, c, d);
+}
+
+void binlog_flush(void)
+{
+	while (binlog.busy) {
+	}
+}
+
+void binlog_uart1_service(void)
+{
+	if ((UART1->STAT & UART_STAT_TC) == 0) {
+		return;
+	}
+
+	/* Word at the tail transmitted */
+	if (binlog.byte == 4) {
+		binlog.tail = (binlog.tail + 1) & BINLOG_MASK;
+		binlog.byte = 0;
+	}
+
+	if (binlog.tail == binlog.head) {
+		/* Buffer empty, disable TC interrupt and clear flag */
+		binlog.busy = 0;
+		UART1->CTRL &= ~UART_CTRL_TCIE;
+		UART1->STAT &= ~UART_STAT_TC;
+		return;
+	}
+
+	UART1->DATA = (binlog.buffer[binlog.tail] >> (8 * binlog.byte)) & 0xff;
+	binlog.byte++;
+}
+
+__attribute__ ((interrupt))
+void binlog_uart1_handler(void)
+{
+	binlog_uart1_service();
+}
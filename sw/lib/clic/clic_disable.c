@@ -0,0 +1,6 @@
+#include <thuasrv32.h>
+
+void clic_disable(uint32_t id)
+{
+	CLIC->INTCTL[id] &= ~CLIC_IE;
+}
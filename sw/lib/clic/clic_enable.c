@@ -0,0 +1,13 @@
+#include <stddef.h>
+
+#include <thuasrv32.h>
+
+void clic_enable(uint32_t id, uint32_t level, void (*handler)(void))
+{
+	if (handler != NULL) {
+		CLIC->VECTOR[id] = (uint32_t) handler;
+		CLIC->INTCTL[id] = CLIC_LEVEL(level) | CLIC_SHV | CLIC_IE;
+	} else {
+		CLIC->INTCTL[id] = CLIC_LEVEL(level) | CLIC_IE;
+	}
+}
@@ -0,0 +1,9 @@
+#include <thuasrv32.h>
+
+void clic_init(void)
+{
+	for (uint32_t id = 0; id < CLIC_SOURCES; id++) {
+		CLIC->INTCTL[id] = 0;
+	}
+	csr_write(0x347, 0);
+}
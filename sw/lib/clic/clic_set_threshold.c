@@ -0,0 +1,6 @@
+#include <thuasrv32.h>
+
+void clic_set_threshold(uint32_t thresh)
+{
+	csr_write(0x347, thresh & 0xff);
+}
@@ -0,0 +1,60 @@
+/*
+ * csr_hpm_set_period.c -- Load an HPM counter for overflow
+ *
+ */
+
+#include <stdint.h>
+
+#include <csr.h>
+
+/* The counters are 40 bits wide, the counter overflows when
+ * all 40 bits wrap. The counter is stopped while loading. */
+void csr_hpm_set_period(uint32_t counter, uint32_t period)
+{
+	uint32_t low = -period;
+	uint32_t high = (period == 0) ? 0 : 0xff;
+
+	csr_set(mcountinhibit, 1 << counter);
+
+	switch (counter) {
+		case 3:
+			csr_write(mhpmcounter3, low);
+			csr_write(mhpmcounter3h, high);
+			csr_clear(mhpmevent3, CSR_HPM_OF);
+			break;
+		case 4:
+			csr_write(mhpmcounter4, low);
+			csr_write(mhpmcounter4h, high);
+			csr_clear(mhpmevent4, CSR_HPM_OF);
+			break;
+		case 5:
+			csr_write(mhpmcounter5, low);
+			csr_write(mhpmcounter5h, high);
+			csr_clear(mhpmevent5, CSR_HPM_OF);
+			break;
+		case 6:
+			csr_write(mhpmcounter6, low);
+			csr_write(mhpmcounter6h, high);
+			csr_clear(mhpmevent6, CSR_HPM_OF);
+			break;
+		case 7:
+			csr_write(mhpmcounter7, low);
+			csr_write(mhpmcounter7h, high);
+			csr_clear(mhpmevent7, CSR_HPM_OF);
+			break;
+		case 8:
+			csr_write(mhpmcounter8, low);
+			csr_write(mhpmcounter8h, high);
+			csr_clear(mhpmevent8, CSR_HPM_OF);
+			break;
+		case 9:
+			csr_write(mhpmcounter9, low);
+			csr_write(mhpmcounter9h, high);
+			csr_clear(mhpmevent9, CSR_HPM_OF);
+			break;
+		default:
+			break;
+	}
+
+	csr_clear(mcountinhibit, 1 << counter);
+}
@@ -0,0 +1,9 @@
+#include <thuasrv32.h>
+
+void dma_init(void)
+{
+	for (uint32_t ch = 0; ch < DMA_CHANNELS; ch++) {
+		DMA->CH[ch].CTRL = 0;
+	}
+	DMA->STAT = 0xff;
+}
@@ -0,0 +1,30 @@
+#include <thuasrv32.h>
+
+int dma_memcpy(void *dst, const void *src, uint32_t len)
+{
+	uint32_t ctrl = DMA_SINC | DMA_DINC | DMA_TRIG(DMA_TRIG_ALWAYS);
+
+	if (len == 0) {
+		return 0;
+	}
+
+	/* Use the largest size both pointers and the length allow */
+	if ((((uint32_t) dst | (uint32_t) src | len) & 3) == 0) {
+		ctrl |= DMA_SSIZE32 | DMA_DSIZE32;
+		len >>= 2;
+	} else if ((((uint32_t) dst | (uint32_t) src | len) & 1) == 0) {
+		ctrl |= DMA_SSIZE16 | DMA_DSIZE16;
+		len >>= 1;
+	} else {
+		ctrl |= DMA_SSIZE8 | DMA_DSIZE8;
+	}
+
+	/* The counter is 16 bits */
+	if (len > 0xffff) {
+		return -1;
+	}
+
+	dma_start(DMA_MEMCPY_CHANNEL, ctrl, (volatile void *) src, dst, len);
+
+	return dma_wait(DMA_MEMCPY_CHANNEL);
+}
@@ -0,0 +1,11 @@
+#include <thuasrv32.h>
+
+void dma_start(uint32_t ch, uint32_t ctrl, volatile void *src, volatile void *dst, uint32_t cnt)
+{
+	DMA->CH[ch].CTRL = 0;
+	DMA->STAT = DMA_TC(ch) | DMA_ERR(ch);
+	DMA->CH[ch].SRC = (uint32_t) src;
+	DMA->CH[ch].DST = (uint32_t) dst;
+	DMA->CH[ch].CNT = cnt;
+	DMA->CH[ch].CTRL = ctrl | DMA_EN;
+}
@@ -0,0 +1,6 @@
+#include <thuasrv32.h>
+
+void dma_stop(uint32_t ch)
+{
+	DMA->CH[ch].CTRL &= ~DMA_EN;
+}
@@ -0,0 +1,8 @@
+#include <thuasrv32.h>
+
+int dma_wait(uint32_t ch)
+{
+	while ((DMA->STAT & (DMA_TC(ch) | DMA_ERR(ch))) == 0);
+
+	return (DMA->STAT & DMA_ERR(ch)) ? -1 : 0;
+}
@@ -0,0 +1,147 @@
+/*
+ * profile.c -- statistical PC-sampling profiler
+ *
+ * The MTIME interrupt samples the interrupted PC (mepc) at a fixed
+ * rate and counts it in a histogram of address buckets. The handler
+ * only shifts, compares and increments, and rearms MTIMECMP with the
+ * next sample time, so it can be left enabled. Code that runs with
+ * interrupts disabled is not sampled.
+ */
+
+#include <thuasrv32.h>
+
+static struct {
+	uint32_t *buckets;
+	uint32_t nbuckets;
+	uint32_t start;
+	uint32_t shift;
+	uint32_t period;
+	uint32_t samples;
+	uint32_t other;
+	uint64_t next;
+} prof;
+
+/* Read the 64-bit MTIME */
+static uint64_t profile_time(void)
+{
+	uint32_t time, timeh;
+
+	do {
+		timeh = MTIMEH;
+		time = MTIME;
+	} while (timeh != MTIMEH);
+
+	return ((uint64_t) timeh << 32) | time;
+}
+
+/* Write the 64-bit MTIMECMP without a spurious interrupt */
+static void profile_set_cmp(uint64_t cmp)
+{
+	MTIMECMPH = -1;
+	MTIMECMP = (uint32_t) cmp;
+	MTIMECMPH = (uint32_t) (cmp >> 32);
+}
+
+void profile_init(uint32_t *buckets, uint32_t nbuckets, uint32_t start, uint32_t end, uint32_t rate)
+{
+	uint32_t shift = 1;
+
+	profile_stop();
+
+	/* Smallest power of 2 bucket that covers the range */
+	while (shift < 31 && ((end - start + (1UL << shift) - 1) >> shift) > nbuckets) {
+		shift++;
+	}
+
+	prof.buckets = buckets;
+	prof.nbuckets = nbuckets;
+	prof.start = start;
+	prof.shift = shift;
+	/* MTIME counts microseconds */
+	prof.period = (rate == 0) ? 1000 : 1000000UL / rate;
+	if (prof.period == 0) {
+		prof.period = 1;
+	}
+
+	profile_clear();
+}
+
+void profile_clear(void)
+{
+	for (uint32_t i = 0; i < prof.nbuckets; i++) {
+		prof.buckets[i] = 0;
+	}
+	prof.samples = 0;
+	prof.other = 0;
+}
+
+void profile_start(void)
+{
+	prof.next = profile_time() + prof.period;
+	profile_set_cmp(prof.next);
+	csr_set(mie, 1 << 7);
+}
+
+void profile_stop(void)
+{
+	csr_clear(mie, 1 << 7);
+	MTIMECMPH = -1;
+	MTIMECMP = -1;
+}
+
+void profile_sample(uint32_t pc)
+{
+	uint32_t index = (pc - prof.start) >> prof.shift;
+	uint64_t now;
+
+	if (index < prof.nbuckets) {
+		prof.buckets[index]++;
+	} else {
+		prof.other++;
+	}
+	prof.samples++;
+
+	/* Next sample, skip samples missed while interrupts were disabled */
+	prof.next += prof.period;
+	now = profile_time();
+	if (prof.next <= now) {
+		prof.next = now + prof.period;
+	}
+	profile_set_cmp(prof.next);
+}
+
+__attribute__ ((interrupt))
+void profile_handler(void)
+{
+	profile_sample(csr_read(mepc));
+}
+
+void profile_dump(void)
+{
+	/* Header: start address, bucket shift, number of buckets,
+	 * samples, samples outside the range and the sample period */
+	uart1_puts("\r\nprofile ");
+	printhex(prof.start, 8);
+	uart1_putc(' ');
+	printhex(prof.shift, 2);
+	uart1_putc(' ');
+	printhex(prof.nbuckets, 8);
+	uart1_putc(' ');
+	printhex(prof.samples, 8);
+	uart1_putc(' ');
+	printhex(prof.other, 8);
+	uart1_putc(' ');
+	printhex(prof.period, 8);
+	uart1_puts("\r\n");
+
+	/* Only the buckets with samples */
+	for (uint32_t i = 0; i < prof.nbuckets; i++) {
+		if (prof.buckets[i] != 0) {
+			printhex(prof.start + (i << prof.shift), 8);
+			uart1_putc(' ');
+			printhex(prof.buckets[i], 8);
+			uart1_puts("\r\n");
+		}
+	}
+	uart1_puts("end\r\n");
+}
@@ -0,0 +1,38 @@
+#include <thuasrv32.h>
+
+/* The shadow bank can only be entered and left with MRET.
+ * The stack top is passed in mscratch because a0 is not
+ * visible in the shadow bank. Interrupts are kept disabled
+ * by clearing MPIE before each MRET. */
+void __attribute__((naked)) shadow_init(void *stack_top)
+{
+	__asm__ volatile (".option push;"
+	                  ".option norelax;"
+	                  "csrrci t1, mstatus, 8;"
+	                  "csrr  t2, mcause;"
+	                  "csrw  mcause, zero;"
+	                  "csrw  mscratch, a0;"
+	                  "li    t0, (1<<7);"
+	                  "csrc  mstatus, t0;"
+	                  "csrsi 0x7c0, 2;"
+	                  "la    t0, 1f;"
+	                  "csrw  mepc, t0;"
+	                  "mret;"
+	                  /* In the shadow bank */
+	                  "1:"
+	                  "csrr  sp, mscratch;"
+	                  "la    gp, __global_pointer$;"
+	                  "li    t0, (1<<7);"
+	                  "csrc  mstatus, t0;"
+	                  "csrci 0x7c0, 2;"
+	                  "la    t0, 2f;"
+	                  "csrw  mepc, t0;"
+	                  "mret;"
+	                  /* Back in the normal bank */
+	                  "2:"
+	                  "csrw  mcause, t2;"
+	                  "csrw  mstatus, t1;"
+	                  "ret;"
+	                  ".option pop"
+	                  ::: "memory");
+}
@@ -0,0 +1,234 @@
+/*
+ * timing.c -- cycle accurate timing of code regions
+ *
+ * The markers read the lower 32 bits of mcycle and, if an event
+ * is selected, mhpmcounter3. A region must be shorter than 2^32
+ * cycles. The cycles and events of the markers themselves are
+ * measured by timing_init and subtracted, also the overhead of
+ * the markers of nested regions. The statistics are kept in a
+ * static table, nothing is allocated. The markers must not be
+ * used in interrupt handlers.
+ */
+
+#include <thuasrv32.h>
+
+/* A started region */
+typedef struct {
+	uint32_t id;
+	uint32_t cycles;
+	uint32_t events;
+	uint32_t child;
+	uint32_t ovh;
+	uint32_t evovh;
+} timing_frame_t;
+
+static struct {
+	timing_region_t regions[TIMING_REGIONS];
+	timing_frame_t stack[TIMING_DEPTH];
+	uint32_t depth;
+	uint32_t lost;
+	uint32_t errors;
+	uint32_t event;
+	uint32_t overhead;
+	uint32_t evoverhead;
+	uint32_t lastevents;
+} timing;
+
+void timing_init(uint32_t event)
+{
+	uint32_t overhead = -1;
+	uint32_t evoverhead = -1;
+
+	timing.event = event;
+	if (event != 0) {
+		csr_write(mhpmevent3, event);
+		csr_clear(mcountinhibit, (1 << 3) | (1 << 0));
+	} else {
+		csr_clear(mcountinhibit, 1 << 0);
+	}
+
+	/* Measure the overhead of an empty region */
+	timing.overhead = 0;
+	timing.evoverhead = 0;
+	timing.depth = 0;
+	timing.lost = 0;
+	timing_reset();
+	for (int i = 0; i < 8; i++) {
+		timing_begin(0, NULL);
+		timing_end(0);
+		if (timing.regions[0].min < overhead) {
+			overhead = timing.regions[0].min;
+		}
+		if (timing.lastevents < evoverhead) {
+			evoverhead = timing.lastevents;
+		}
+	}
+	timing.overhead = overhead;
+	timing.evoverhead = evoverhead;
+
+	for (int i = 0; i < TIMING_REGIONS; i++) {
+		timing.regions[i].name = NULL;
+	}
+	timing_reset();
+}
+
+void timing_reset(void)
+{
+	for (int i = 0; i < TIMING_REGIONS; i++) {
+		timing.regions[i].count = 0;
+		timing.regions[i].min = -1;
+		timing.regions[i].max = 0;
+		timing.regions[i].total = 0;
+		timing.regions[i].self = 0;
+		timing.regions[i].events = 0;
+	}
+	timing.errors = 0;
+}
+
+void timing_begin(uint32_t id, const char *name)
+{
+	timing_frame_t *frame;
+
+	if (timing.depth >= TIMING_DEPTH) {
+		/* Too deep, this is the innermost region, so the
+		 * next end is its end and is skipped too */
+		timing.lost++;
+		timing.errors++;
+		return;
+	}
+
+	if (id >= TIMING_REGIONS) {
+		/* Invalid id, keep a dummy frame so that the
+		 * matching end is skipped, not another end */
+		timing.errors++;
+		id = TIMING_REGIONS;
+	} else if (timing.regions[id].name == NULL) {
+		timing.regions[id].name = name;
+	}
+
+	frame = &timing.stack[timing.depth++];
+	frame->id = id;
+	frame->child = 0;
+	frame->ovh = 0;
+	frame->evovh = 0;
+	/* Read the counters last */
+	frame->events = (timing.event != 0) ? csr_read(mhpmcounter3) : 0;
+	frame->cycles = csr_read(mcycle);
+}
+
+void timing_end(uint32_t id)
+{
+	/* Read the counters first */
+	uint32_t cycles = csr_read(mcycle);
+	uint32_t events = (timing.event != 0) ? csr_read(mhpmcounter3) : 0;
+	uint32_t ovh, evovh, self;
+	timing_frame_t *frame;
+	timing_region_t *region;
+
+	if (timing.lost > 0) {
+		timing.lost--;
+		return;
+	}
+	if (timing.depth == 0) {
+		timing.errors++;
+		return;
+	}
+
+	frame = &timing.stack[--timing.depth];
+	if (frame->id == TIMING_REGIONS) {
+		/* End of a region with an invalid id */
+		return;
+	}
+	if (frame->id != id) {
+		/* Mismatched markers, drop the region */
+		timing.errors++;
+		return;
+	}
+
+	/* Subtract the overhead of these and the nested markers */
+	ovh = timing.overhead + frame->ovh;
+	evovh = timing.evoverhead + frame->evovh;
+	cycles -= frame->cycles;
+	cycles = (cycles > ovh) ? cycles - ovh : 0;
+	events -= frame->events;
+	events = (events > evovh) ? events - evovh : 0;
+	self = (cycles > frame->child) ? cycles - frame->child : 0;
+	timing.lastevents = events;
+
+	region = &timing.regions[id];
+	region->count++;
+	region->total += cycles;
+	region->self += self;
+	region->events += events;
+	if (cycles < region->min) {
+		region->min = cycles;
+	}
+	if (cycles > region->max) {
+		region->max = cycles;
+	}
+
+	/* Account the region to the enclosing region */
+	if (timing.depth > 0) {
+		frame = &timing.stack[timing.depth - 1];
+		frame->child += cycles;
+		frame->ovh += ovh;
+		frame->evovh += evovh;
+	}
+}
+
+const timing_region_t *timing_get(uint32_t id)
+{
+	return (id < TIMING_REGIONS) ? &timing.regions[id] : NULL;
+}
+
+void timing_report(void)
+{
+	uart1_puts("\r\nid name             count min max avg total self");
+	if (timing.event != 0) {
+		uart1_puts(" events");
+	}
+	uart1_puts("\r\n");
+
+	for (uint32_t i = 0; i < TIMING_REGIONS; i++) {
+		timing_region_t *region = &timing.regions[i];
+		const char *name = region->name ? region->name : "";
+		int len = 0;
+
+		if (region->count == 0) {
+			continue;
+		}
+
+		printdec(i);
+		uart1_puts(i < 10 ? "  " : " ");
+		while (*name != '\0' && len < 16) {
+			uart1_putc(*name++);
+			len++;
+		}
+		while (len++ < 16) {
+			uart1_putc(' ');
+		}
+		uart1_putc(' ');
+		uart1_printulonglong(region->count);
+		uart1_putc(' ');
+		uart1_printulonglong(region->min);
+		uart1_putc(' ');
+		uart1_printulonglong(region->max);
+		uart1_putc(' ');
+		uart1_printulonglong(region->total / region->count);
+		uart1_putc(' ');
+		uart1_printulonglong(region->total);
+		uart1_putc(' ');
+		uart1_printulonglong(region->self);
+		if (timing.event != 0) {
+			uart1_putc(' ');
+			uart1_printulonglong(region->events);
+		}
+		uart1_puts("\r\n");
+	}
+
+	uart1_puts("overhead ");
+	printdec(timing.overhead);
+	uart1_puts(" cycles, errors ");
+	printdec(timing.errors);
+	uart1_puts("\r\n");
+}
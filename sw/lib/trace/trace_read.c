@@ -0,0 +1,29 @@
+#include <thuasrv32.h>
+
+uint32_t trace_read(uint32_t *buf, uint32_t len)
+{
+	uint32_t size = TRACE->SIZE;
+	uint32_t start, count;
+
+	/* If the buffer has wrapped, the oldest word is at WPTR */
+	if (TRACE->STAT & TRACE_WRAP) {
+		start = TRACE->WPTR;
+		count = size;
+	} else {
+		start = 0;
+		count = TRACE->WPTR;
+	}
+
+	/* Skip the oldest words if buf is too small */
+	if (count > len) {
+		start = (start + count - len) & (size - 1);
+		count = len;
+	}
+
+	TRACE->RPTR = start;
+	for (uint32_t i = 0; i < count; i++) {
+		buf[i] = TRACE->DATA;
+	}
+
+	return count;
+}
@@ -0,0 +1,6 @@
+#include <thuasrv32.h>
+
+void trace_start(uint32_t ctrl)
+{
+	TRACE->CTRL = TRACE_CLR | TRACE_EN | (ctrl & TRACE_ONESHOT);
+}
@@ -0,0 +1,6 @@
+#include <thuasrv32.h>
+
+void trace_stop(void)
+{
+	TRACE->CTRL = 0;
+}
@@ -19,6 +19,7 @@ int main(void)
 
 	uint32_t hw = csr_read(0xfc0); // CSR address = 0xfc0
 	uint32_t speed = csr_read(0xfc1); // CSR address = 0xfc1
+	uint32_t hw2 = csr_read(0xfc2); // CSR address = 0xfc2
 	uint32_t readback;
 	int count = 0;
 
@@ -60,6 +61,22 @@ int main(void)
 	uart1_printf("has Buffer I/O reponse: %s\r\n", (hw & CSR_MXHW_BUFFER) ? "yes" : "no");
 	uart1_printf("has Zbb extension: %s\r\n", (hw & CSR_MXHW_ZBB) ? "yes" : "no");
 	uart1_printf("has CRC hardware: %s\r\n", (hw & CSR_MXHW_CRC) ? "yes" : "no");
+	uart1_printf("has DMA controller: %s\r\n", (hw & CSR_MXHW_DMA) ? "yes" : "no");
+	uart1_printf("has branch prediction: %s\r\n", (hw & CSR_MXHW_BP) ? "yes" : "no");
+	uart1_printf("has branch target buffer: %s\r\n", (hw & CSR_MXHW_BTB) ? "yes" : "no");
+
+	uart1_printf("\r\nread CSR mxhw2: 0x%08x\r\n", hw2);
+
+	uart1_printf("has single-cycle multiply: %s\r\n", (hw2 & CSR_MXHW2_FASTMUL) ? "yes" : "no");
+	uart1_printf("has early-terminating divide: %s\r\n", (hw2 & CSR_MXHW2_EARLYDV) ? "yes" : "no");
+	uart1_printf("has prefetch queue: %s\r\n", (hw2 & CSR_MXHW2_PREFETCH) ? "yes" : "no");
+	uart1_printf("has single-cycle loads: %s\r\n", (hw2 & CSR_MXHW2_FASTLOAD) ? "yes" : "no");
+	uart1_printf("has store buffer: %s\r\n", (hw2 & CSR_MXHW2_STOREBUF) ? "yes" : "no");
+	uart1_printf("has Zcb extension: %s\r\n", (hw2 & CSR_MXHW2_ZCB) ? "yes" : "no");
+	uart1_printf("has Zcmp extension: %s\r\n", (hw2 & CSR_MXHW2_ZCMP) ? "yes" : "no");
+	uart1_printf("has CLIC interrupt controller: %s\r\n", (hw2 & CSR_MXHW2_CLIC) ? "yes" : "no");
+	uart1_printf("has shadow registers: %s\r\n", (hw2 & CSR_MXHW2_SHADOW) ? "yes" : "no");
+	uart1_printf("has trace buffer: %s\r\n", (hw2 & CSR_MXHW2_TRACE) ? "yes" : "no");
 
 	/* Are HPM counters enabled... */
 	if (hw & CSR_MXHW_ZIHPM) {
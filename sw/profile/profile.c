@@ -0,0 +1,72 @@
+/*
+ * profile.c -- find the hot spots with the PC-sampling profiler
+ *
+ */
+
+#include <thuasrv32.h>
+
+#ifndef F_CPU
+#define F_CPU (50000000UL)
+#endif
+#ifndef BAUD_RATE
+#define BAUD_RATE (115200UL)
+#endif
+
+/* Samples per second */
+#define PROFILE_RATE (1000)
+/* Number of buckets */
+#define PROFILE_BUCKETS (1024)
+
+static uint32_t buckets[PROFILE_BUCKETS];
+
+/* Start and end of the code, from the linker script */
+extern char _stext[], _etext[];
+
+void trap_handler(void);
+
+/* Something to profile */
+__attribute__((noinline)) static uint32_t fib(uint32_t n)
+{
+	return (n < 2) ? n : fib(n-1) + fib(n-2);
+}
+
+__attribute__((noinline)) static uint32_t checksum(uint32_t n)
+{
+	uint32_t sum = 0;
+
+	for (uint32_t i = 0; i < n; i++) {
+		sum = (sum << 1) ^ (sum >> 31) ^ i;
+	}
+	return sum;
+}
+
+int main(void)
+{
+	uart1_init(BAUD_RATE, UART_CTRL_EN);
+
+	/* MTIME interrupt in direct mode, see trap_handler */
+	set_mtvec(trap_handler, TRAP_DIRECT_MODE);
+
+	profile_init(buckets, PROFILE_BUCKETS, (uint32_t) _stext, (uint32_t) _etext, PROFILE_RATE);
+	profile_start();
+	enable_irq();
+
+	while (1) {
+		for (int i = 0; i < 10; i++) {
+			fib(20);
+			checksum(100000);
+		}
+		/* Save the output and decode with:
+		 * flatprof profile.elf <file> */
+		profile_dump();
+	}
+}
+
+/* Only the MTIME interrupt is expected */
+__attribute__ ((interrupt))
+void trap_handler(void)
+{
+	if (csr_read(mcause) == 0x80000007) {
+		profile_sample(csr_read(mepc));
+	}
+}
@@ -0,0 +1,72 @@
+/*
+ * shadow.c - high-rate interrupt in the shadow register bank
+ *
+ */
+
+#include <thuasrv32.h>
+
+/* Frequency of the DE0-CV board */
+#ifndef F_CPU
+#define F_CPU (50000000UL)
+#endif
+
+/* Interrupt frequency TIMER2 */
+#define TIMER2_FREQ (100000UL)
+
+/* Size of the stack used in the shadow bank */
+#define SHADOW_STACK_SIZE (256)
+
+static uint32_t shadow_stack[SHADOW_STACK_SIZE/4];
+
+static volatile uint32_t ticks;
+
+void timer2_handler(void);
+void trap_handler(void);
+
+int main(void)
+{
+	/* Get clock frequency */
+	uint32_t speed = csr_read(0xfc1);
+	speed = (speed == 0) ? F_CPU : speed;
+
+	if ((csr_read(0xfc2) & CSR_MXHW2_SHADOW) == 0) {
+		/* No shadow registers, just stop */
+		while (1);
+	}
+
+	/* Only TIMER2 interrupts, no exceptions expected */
+	set_mtvec(trap_handler, TRAP_DIRECT_MODE);
+
+	shadow_init(&shadow_stack[SHADOW_STACK_SIZE/4]);
+	shadow_enable();
+
+	/* Activate TIMER2 compare T interrupt */
+	TIMER2->PRSC = 0;
+	TIMER2->CMPT = speed/TIMER2_FREQ-1UL;
+	TIMER2->CTRL = (1<<4)|(1<<0);
+
+	/* Enable TIMER2 interrupt */
+	csr_set(mie, 1 << 21);
+
+	/* Enable global IRQ */
+	enable_irq();
+
+	while(1) {
+		/* Toggle the led every second */
+		if (ticks >= TIMER2_FREQ) {
+			ticks = 0;
+			GPIOA->POUT ^= (1 << 0);
+		}
+	}
+}
+
+/* A normal function, registers are not saved */
+void timer2_handler(void)
+{
+	TIMER2->STAT &= ~(0xf<<4);
+	GPIOA->POUT ^= (1 << 15);
+	ticks++;
+}
+
+/* Run timer2_handler in the shadow bank */
+SHADOW_HANDLER(trap_handler, timer2_handler)
@@ -0,0 +1,79 @@
+/*
+ * timing.c -- time the regions of a control loop
+ *
+ * Compile with -DTIMING_DISABLE to remove the timing code.
+ */
+
+#include <stdint.h>
+
+#include <thuasrv32.h>
+
+#ifndef F_CPU
+#define F_CPU (50000000UL)
+#endif
+#ifndef BAUD_RATE
+#define BAUD_RATE (115200UL)
+#endif
+
+/* The regions */
+enum { LOOP, SAMPLE, FILTER, OUTPUT };
+
+#define TAPS (16)
+
+static int32_t history[TAPS];
+static const int32_t coef[TAPS] = { 1, 2, 4, 7, 11, 15, 18, 20, 20, 18, 15, 11, 7, 4, 2, 1 };
+
+static int32_t sample(void)
+{
+	TIMING_BEGIN(SAMPLE, "sample");
+	for (int i = TAPS-1; i > 0; i--) {
+		history[i] = history[i-1];
+	}
+	history[0] = GPIOA->PIN & 0xffff;
+	TIMING_END(SAMPLE);
+
+	return history[0];
+}
+
+static int32_t filter(void)
+{
+	int32_t sum = 0;
+
+	TIMING_BEGIN(FILTER, "filter");
+	for (int i = 0; i < TAPS; i++) {
+		sum += coef[i] * history[i];
+	}
+	TIMING_END(FILTER);
+
+	return sum / 156;
+}
+
+static void output(int32_t v)
+{
+	TIMING_BEGIN(OUTPUT, "output");
+	GPIOA->POUT = v;
+	TIMING_END(OUTPUT);
+}
+
+int main(int argc, char *argv[])
+{
+	uart1_init(BAUD_RATE, UART_CTRL_EN);
+	uart1_puts("\r\nTiming of a control loop\r\n");
+
+	/* Count the stall cycles */
+	TIMING_INIT(CSR_HPM_STALLS);
+
+	while (1) {
+		for (int i = 0; i < 1000; i++) {
+			TIMING_BEGIN(LOOP, "loop");
+			sample();
+			output(filter());
+			TIMING_END(LOOP);
+		}
+		TIMING_REPORT();
+		TIMING_RESET();
+		delayms(1000);
+	}
+
+	return 0;
+}
@@ -0,0 +1,59 @@
+/*
+ * trace.c -- record the instruction flow with the trace buffer
+ *
+ */
+
+#include <thuasrv32.h>
+
+#ifndef F_CPU
+#define F_CPU (50000000UL)
+#endif
+#ifndef BAUD_RATE
+#define BAUD_RATE (115200UL)
+#endif
+
+/* Number of trace words to print */
+#define TRACE_WORDS (256)
+
+static uint32_t words[TRACE_WORDS];
+
+/* Something with branches, jumps and calls */
+__attribute__((noinline)) static void sort(uint32_t *a, uint32_t n)
+{
+	for (uint32_t i = 1; i < n; i++) {
+		uint32_t key = a[i];
+		uint32_t j = i;
+		while (j > 0 && a[j-1] > key) {
+			a[j] = a[j-1];
+			j--;
+		}
+		a[j] = key;
+	}
+}
+
+int main(void)
+{
+	uint32_t data[8] = { 7, 3, 5, 1, 8, 2, 6, 4 };
+	uint32_t count;
+
+	uart1_init(BAUD_RATE, UART_CTRL_EN);
+
+	if ((csr_read(0xfc2) & CSR_MXHW2_TRACE) == 0) {
+		uart1_puts("\r\nNo trace buffer\r\n");
+		while (1);
+	}
+
+	trace_start(0);
+	sort(data, sizeof data / sizeof data[0]);
+	trace_stop();
+
+	/* Print the buffer, save as file and decode with:
+	 * tracedecode trace.elf <file> */
+	count = trace_read(words, TRACE_WORDS);
+	uart1_printf("\r\n%d trace words, status 0x%x\r\n", count, TRACE->STAT);
+	for (uint32_t i = 0; i < count; i++) {
+		uart1_printf("%08x\r\n", words[i]);
+	}
+
+	while (1);
+}
@@ -0,0 +1,17 @@
+
+#ifdef _MSC_VER
+
+#ifndef GETOPT_H
+#define GETOPT_H
+
+extern int	opterr,             /* if error message should be printed */
+			optind,             /* index into parent argv vector */
+			optopt,             /* character checked for validity */
+			optreset;           /* reset getopt */
+extern char* optarg;            /* argument associated with option */
+
+int getopt(int nargc, char* const nargv[], const char* ostr);
+
+#endif
+
+#endif // _MSC_VER
\ No newline at end of file
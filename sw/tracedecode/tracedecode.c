@@ -0,0 +1,526 @@
+/*
+ * tracedecode - instruction trace decoder
+ *
+ * For use with the THUAS RISC-V processor
+ *
+ * (c)2026, J.E.J. op den Brouw <J.E.J.opdenBrouw@hhs.nl>
+ *
+ * This program rebuilds the instruction flow from the contents
+ * of the trace buffer and the ELF file of the program that was
+ * traced. The trace file contains the words of the buffer as
+ * hexadecimal numbers, oldest word first, one or more per line.
+ *
+ * The trace buffer records packets for every discontinuity in
+ * the instruction flow. A packet starts with a header word:
+ *   bit 0     - 1, header (address words have bit 0 cleared)
+ *   bits 3:1  - kind of discontinuity, see below
+ *   bit 4     - full packet, followed by the source and target
+ *   bit 5     - full packet only, events are lost before it
+ *   bits 31:5 - compressed packet only, (source - previous target) / 2
+ * A compressed packet is followed by the target address, except
+ * for a direct jump/branch. That target is found in the program.
+ * Decoding starts at the first full packet.
+ *
+ * Options:
+ *      -v         Verbose output, print the packets
+ *      -q         Quiet output, only errors are reported
+ *      -e         Print only the discontinuities, not every instruction
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <stdint.h>
+
+/* Test for Visual Studio */
+#if defined(_MSC_VER)
+
+#pragma warning(disable : 4996)
+#include <windows.h>
+#include "getopt.h"
+
+/* Test for GCC for Windows*/
+#elif defined(WIN32) || defined(WIN64) || defined (WINNT)
+#include <getopt.h>
+#include <unistd.h>
+
+/* Probably Linux */
+#else
+
+#include <getopt.h>
+#include <unistd.h>
+
+#endif
+
+#define VERSION "v0.1.0"
+
+/* 1000 should be enough */
+#define LEN_BUFFER (1000)
+
+/* Maximum number of sequential instructions between two
+ * discontinuities, protects against a wrong ELF file */
+#define MAX_STEPS (1000000)
+
+/* Kinds of discontinuity */
+#define KIND_DIRECT   (1)
+#define KIND_INDIRECT (2)
+#define KIND_TRAP     (3)
+#define KIND_MRET     (4)
+#define KIND_CHAIN    (5)
+#define KIND_RESUME   (6)
+
+static const char *kind_name[] = {
+    "?", "jump/branch", "indirect jump", "trap", "mret", "tail-chain", "resume", "?"
+};
+
+/* ELF file definitions, only what is needed */
+#define EI_NIDENT     (16)
+#define ELFCLASS32    (1)
+#define ELFDATA2LSB   (1)
+#define EM_RISCV      (243)
+#define SHT_PROGBITS  (1)
+#define SHT_SYMTAB    (2)
+#define SHF_ALLOC     (0x2)
+#define STT_FUNC      (2)
+
+/* A loaded section of the program */
+typedef struct {
+    uint32_t addr;
+    uint32_t size;
+    unsigned char *data;
+} section_t;
+
+/* A function symbol */
+typedef struct {
+    uint32_t addr;
+    char *name;
+} symbol_t;
+
+static section_t *sections = NULL;
+static int nsections = 0;
+static symbol_t *symbols = NULL;
+static int nsymbols = 0;
+
+/* Little Endian reads from the file image */
+static uint32_t get16(const unsigned char *p) {
+    return (uint32_t) p[0] | ((uint32_t) p[1] << 8);
+}
+
+static uint32_t get32(const unsigned char *p) {
+    return get16(p) | (get16(p+2) << 16);
+}
+
+/* Sort symbols on address */
+static int compare_symbols(const void *a, const void *b) {
+    const symbol_t *sa = a;
+    const symbol_t *sb = b;
+
+    if (sa->addr < sb->addr) {
+        return -1;
+    }
+    return sa->addr > sb->addr;
+}
+
+/* Read the allocated sections and the function symbols */
+static int read_elf(const char *filename) {
+
+    FILE *fp;
+    unsigned char *image;
+    long len;
+    uint32_t shoff, shentsize, shnum;
+    uint32_t i, j;
+
+    fp = fopen(filename, "rb");
+    if (fp == NULL) {
+        fprintf(stderr, "Cannot open ELF file %s\n", filename);
+        return -1;
+    }
+    fseek(fp, 0, SEEK_END);
+    len = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    image = malloc(len);
+    if (image == NULL || fread(image, 1, len, fp) != (size_t) len) {
+        fprintf(stderr, "Cannot read ELF file %s\n", filename);
+        fclose(fp);
+        return -1;
+    }
+    fclose(fp);
+
+    if (len < 52 || memcmp(image, "\177ELF", 4) != 0 || image[4] != ELFCLASS32 ||
+        image[5] != ELFDATA2LSB || get16(image+18) != EM_RISCV) {
+        fprintf(stderr, "%s is not a 32-bit RISC-V ELF file\n", filename);
+        return -1;
+    }
+
+    shoff = get32(image+32);
+    shentsize = get16(image+46);
+    shnum = get16(image+48);
+
+    sections = calloc(shnum, sizeof(section_t));
+    if (sections == NULL) {
+        fprintf(stderr, "Cannot allocate memory\n");
+        return -1;
+    }
+
+    for (i = 0; i < shnum; i++) {
+        unsigned char *sh = image + shoff + i*shentsize;
+        uint32_t type = get32(sh+4);
+        uint32_t flags = get32(sh+8);
+
+        /* Code and read-only data */
+        if (type == SHT_PROGBITS && (flags & SHF_ALLOC)) {
+            sections[nsections].addr = get32(sh+12);
+            sections[nsections].data = image + get32(sh+16);
+            sections[nsections].size = get32(sh+20);
+            nsections++;
+        }
+
+        /* Function symbols, names from the linked string table */
+        if (type == SHT_SYMTAB) {
+            unsigned char *strsh = image + shoff + get32(sh+24)*shentsize;
+            char *strtab = (char *) image + get32(strsh+16);
+            uint32_t count = get32(sh+20) / 16;
+
+            symbols = realloc(symbols, (nsymbols + count) * sizeof(symbol_t));
+            if (symbols == NULL) {
+                fprintf(stderr, "Cannot allocate memory\n");
+                return -1;
+            }
+            for (j = 0; j < count; j++) {
+                unsigned char *sym = image + get32(sh+16) + j*16;
+                if ((sym[12] & 0xf) == STT_FUNC) {
+                    symbols[nsymbols].addr = get32(sym+4);
+                    symbols[nsymbols].name = strtab + get32(sym);
+                    nsymbols++;
+                }
+            }
+        }
+    }
+
+    qsort(symbols, nsymbols, sizeof(symbol_t), compare_symbols);
+
+    return 0;
+}
+
+/* Fetch a halfword of the program, returns -1 if not in the program */
+static int fetch16(uint32_t addr, uint32_t *value) {
+
+    int i;
+
+    for (i = 0; i < nsections; i++) {
+        if (addr >= sections[i].addr && addr + 2 <= sections[i].addr + sections[i].size) {
+            *value = get16(sections[i].data + (addr - sections[i].addr));
+            return 0;
+        }
+    }
+    return -1;
+}
+
+/* Fetch an instruction, returns its length or -1 if not in the program */
+static int fetch(uint32_t addr, uint32_t *instr) {
+
+    uint32_t high;
+
+    if (fetch16(addr, instr) < 0) {
+        return -1;
+    }
+    if ((*instr & 3) != 3) {
+        return 2;
+    }
+    if (fetch16(addr+2, &high) < 0) {
+        return -1;
+    }
+    *instr |= high << 16;
+    return 4;
+}
+
+/* Print an address with the function it belongs to */
+static void print_address(FILE *fout, uint32_t addr) {
+
+    int low = 0, high = nsymbols - 1, mid, found = -1;
+
+    while (low <= high) {
+        mid = (low + high) / 2;
+        if (symbols[mid].addr <= addr) {
+            found = mid;
+            low = mid + 1;
+        } else {
+            high = mid - 1;
+        }
+    }
+
+    fprintf(fout, "%08lx", (unsigned long) addr);
+    if (found >= 0) {
+        fprintf(fout, " <%s+0x%lx>", symbols[found].name, (unsigned long) (addr - symbols[found].addr));
+    }
+}
+
+/* Target of a direct jump (JAL, C.J, C.JAL) or branch (Bxx, C.BEQZ, C.BNEZ) */
+static int direct_target(uint32_t addr, uint32_t *target) {
+
+    uint32_t instr;
+    int32_t imm;
+
+    switch (fetch(addr, &instr)) {
+    case 4:
+        if ((instr & 0x7f) == 0x6f) {
+            /* JAL */
+            imm = ((instr >> 11) & 0x100000) | (instr & 0xff000) |
+                  ((instr >> 9) & 0x800) | ((instr >> 20) & 0x7fe);
+            imm = (imm ^ 0x100000) - 0x100000;
+        } else if ((instr & 0x7f) == 0x63) {
+            /* Branch */
+            imm = ((instr >> 19) & 0x1000) | ((instr << 4) & 0x800) |
+                  ((instr >> 20) & 0x7e0) | ((instr >> 7) & 0x1e);
+            imm = (imm ^ 0x1000) - 0x1000;
+        } else {
+            return -1;
+        }
+        break;
+    case 2:
+        if ((instr & 3) == 1 && ((instr >> 13) == 1 || (instr >> 13) == 5)) {
+            /* C.JAL, C.J */
+            imm = ((instr >> 1) & 0x800) | ((instr << 2) & 0x400) | ((instr >> 1) & 0x300) |
+                  ((instr << 1) & 0x80) | ((instr >> 1) & 0x40) | ((instr << 3) & 0x20) |
+                  ((instr >> 7) & 0x10) | ((instr >> 2) & 0xe);
+            imm = (imm ^ 0x800) - 0x800;
+        } else if ((instr & 3) == 1 && ((instr >> 13) == 6 || (instr >> 13) == 7)) {
+            /* C.BEQZ, C.BNEZ */
+            imm = ((instr >> 4) & 0x100) | ((instr << 1) & 0xc0) | ((instr << 3) & 0x20) |
+                  ((instr >> 7) & 0x18) | ((instr >> 2) & 0x6);
+            imm = (imm ^ 0x100) - 0x100;
+        } else {
+            return -1;
+        }
+        break;
+    default:
+        return -1;
+    }
+
+    *target = addr + imm;
+    return 0;
+}
+
+/* Print the instructions from pc up to source. The source is included
+ * if it has retired. Returns -1 if the flow cannot be followed. */
+static int walk(FILE *fout, uint32_t pc, uint32_t source, int inclusive, int events) {
+
+    uint32_t instr;
+    long steps = 0;
+    int len;
+
+    while (pc != source || inclusive) {
+        len = fetch(pc, &instr);
+        if (len < 0 || steps++ > MAX_STEPS) {
+            return -1;
+        }
+        if (!events) {
+            fprintf(fout, "  ");
+            print_address(fout, pc);
+            fprintf(fout, "  %0*lx\n", 2*len, (unsigned long) instr);
+        }
+        if (pc == source) {
+            break;
+        }
+        pc += len;
+    }
+    return 0;
+}
+
+/* main */
+int main(int argc, char *argv[]) {
+
+    FILE *fp, *fout;
+    char buffer[LEN_BUFFER];
+    char *p, *end;
+    uint32_t *words = NULL;
+    long nwords = 0, maxwords = 0;
+    long i;
+    uint32_t header, kind, source, target, last_target = 0;
+    uint32_t pc = 0;
+    int synced = 0;
+    long packets = 0, resyncs = 0;
+
+    /* Options */
+    int opt;
+    int verbose = 0, events = 0;
+
+    /* Check for 0 extra arguments */
+    if (argc == 1) {
+        printf("tracedecode " VERSION " -- an instruction trace decoder\n");
+        printf("Usage: tracedecode [-vqe] elffile tracefile [outputfile]\n");
+        printf("   -v        Verbose, print the packets\n");
+        printf("   -q        Quiet. Only errors are reported\n");
+        printf("   -e        Print only the discontinuities\n\n");
+        printf("If outputfile is omitted, stdout is used\n");
+        printf("The trace file contains the words of the trace buffer\n"
+               "in hexadecimal, oldest word first.\n");
+        exit(EXIT_SUCCESS);
+    }
+
+    /* Parse options */
+    while ((opt = getopt(argc, argv, "vqe")) != -1) {
+        switch (opt) {
+        case 'v':
+            verbose = 1;
+            break;
+        case 'q':
+            verbose = 0;
+            break;
+        case 'e':
+            events = 1;
+            break;
+        default: /* '?' */
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    if (optind + 1 >= argc) {
+        fprintf(stderr, "Please supply an ELF file and a trace file\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (read_elf(argv[optind]) < 0) {
+        exit(EXIT_FAILURE);
+    }
+
+    /* Read the trace words, skip OpenOCD style "address:" prefixes */
+    fp = fopen(argv[optind+1], "r");
+    if (fp == NULL) {
+        fprintf(stderr, "Cannot open trace file %s\n", argv[optind+1]);
+        exit(EXIT_FAILURE);
+    }
+    while (fgets(buffer, sizeof buffer, fp) != NULL) {
+        p = strchr(buffer, ':');
+        p = (p == NULL) ? buffer : p + 1;
+        while (1) {
+            unsigned long val = strtoul(p, &end, 16);
+            if (end == p) {
+                break;
+            }
+            p = end;
+            if (nwords == maxwords) {
+                maxwords = maxwords ? 2*maxwords : 1024;
+                words = realloc(words, maxwords * sizeof(uint32_t));
+                if (words == NULL) {
+                    fprintf(stderr, "Cannot allocate memory\n");
+                    fclose(fp);
+                    exit(EXIT_FAILURE);
+                }
+            }
+            words[nwords++] = (uint32_t) val;
+        }
+    }
+    fclose(fp);
+
+    if (argv[optind+2] == NULL) {
+        fout = stdout;
+    } else {
+        fout = fopen(argv[optind+2], "w");
+        if (fout == NULL) {
+            fprintf(stderr, "Cannot open output file %s\n", argv[optind+2]);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    i = 0;
+    while (i < nwords) {
+        header = words[i++];
+
+        /* Skip address words and, before the first full packet,
+         * compressed packets. The buffer may have wrapped. */
+        if ((header & 1) == 0 || (!synced && (header & 0x10) == 0)) {
+            continue;
+        }
+
+        kind = (header >> 1) & 7;
+
+        if (header & 0x10) {
+            /* Full packet */
+            if (i + 2 > nwords) {
+                break;
+            }
+            source = words[i++];
+            target = words[i++];
+            if (verbose) {
+                fprintf(fout, "# full %s %08lx -> %08lx%s\n", kind_name[kind], (unsigned long) source,
+                        (unsigned long) target, (header & 0x20) ? ", events lost" : "");
+            }
+            /* Start of the trace, lost events or resume from debug mode */
+            if (!synced || (header & 0x20) || kind == KIND_RESUME) {
+                if (synced) {
+                    fprintf(fout, "--- %s, continuing at ", kind == KIND_RESUME ? "resume from debug mode" : "trace events lost");
+                } else {
+                    fprintf(fout, "--- start of trace at ");
+                }
+                print_address(fout, target);
+                fprintf(fout, "\n");
+                pc = target;
+                last_target = target;
+                synced = 1;
+                packets++;
+                continue;
+            }
+        } else {
+            /* Compressed packet */
+            source = last_target + (header >> 5) * 2;
+            if (kind == KIND_DIRECT) {
+                if (direct_target(source, &target) < 0) {
+                    fprintf(stderr, "No jump or branch at %08lx, is this the traced program?\n", (unsigned long) source);
+                    synced = 0;
+                    resyncs++;
+                    continue;
+                }
+            } else {
+                if (i + 1 > nwords) {
+                    break;
+                }
+                target = words[i++];
+            }
+            if (verbose) {
+                fprintf(fout, "# %s %08lx -> %08lx\n", kind_name[kind], (unsigned long) source, (unsigned long) target);
+            }
+        }
+
+        /* Sequential flow up to the discontinuity, the instruction
+         * that caused a trap has not retired */
+        if (walk(fout, pc, source, kind != KIND_TRAP, events) < 0) {
+            fprintf(stderr, "Cannot follow the program from %08lx to %08lx, is this the traced program?\n",
+                    (unsigned long) pc, (unsigned long) source);
+            fprintf(fout, "--- lost synchronization\n");
+            synced = 0;
+            resyncs++;
+            continue;
+        }
+
+        if (events || kind != KIND_DIRECT) {
+            fprintf(fout, "--- %s ", kind_name[kind]);
+            print_address(fout, source);
+            fprintf(fout, " -> ");
+            print_address(fout, target);
+            fprintf(fout, "\n");
+        }
+
+        pc = target;
+        last_target = target;
+        packets++;
+    }
+
+    if (synced) {
+        fprintf(fout, "--- end of trace, last at ");
+        print_address(fout, pc);
+        fprintf(fout, "\n");
+    }
+
+    if (verbose) {
+        fprintf(stderr, "%ld words, %ld packets, %ld resynchronizations\n", nwords, packets, resyncs);
+    }
+
+    if (fout != stdout) {
+        fclose(fout);
+    }
+
+    return 0;
+}